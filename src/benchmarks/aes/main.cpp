@@ -0,0 +1,158 @@
+#include "aes.h"
+#include "benchmark_utils.h"
+#include "byte_data.h"
+#include "crypto_constants.h"
+
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Encrypts / decrypts data block by block, expanding the key for every block. This is what Aes used to do
+ * before the key schedule was cached, so it serves as the 'before' line of the report
+ *
+ * @param key the key
+ * @param data data to process, multiple of block size
+ * @param encrypt if true - encrypt, otherwise decrypt
+ * @return the number of bytes processed
+ */
+static std::size_t processRekeyingEveryBlock(const ByteData &key, const ByteData &data, bool encrypt)
+{
+    ByteData result(0, data.size());
+
+    for (std::size_t i = 0; i < data.size(); i += CryptoConstants::BLOCK_SIZE_BYTES)
+    {
+        CryptoPP::SecByteBlock keyBlock(key.secureData().data(), key.size());
+        if (encrypt)
+        {
+            CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption ecbEncryption(keyBlock, keyBlock.size());
+            ecbEncryption.ProcessData(result.secureData().data() + i, data.secureData().data() + i,
+                                      CryptoConstants::BLOCK_SIZE_BYTES);
+        }
+        else
+        {
+            CryptoPP::ECB_Mode<CryptoPP::AES>::Decryption ecbDecryption(keyBlock, keyBlock.size());
+            ecbDecryption.ProcessData(result.secureData().data() + i, data.secureData().data() + i,
+                                      CryptoConstants::BLOCK_SIZE_BYTES);
+        }
+    }
+
+    return result.size();
+}
+
+/**
+ * @brief Encrypts / decrypts data block by block with a key schedule that was expanded once. This is what
+ * Aes used to do for each block with the CryptoPP backend, before whole buffers were handed to the backend at once
+ *
+ * @param encryption expanded encryption key
+ * @param decryption expanded decryption key
+ * @param data data to process, multiple of block size
+ * @param encrypt if true - encrypt, otherwise decrypt
+ * @return the number of bytes processed
+ */
+static std::size_t processWithCachedKey(const CryptoPP::AES::Encryption &encryption,
+                                        const CryptoPP::AES::Decryption &decryption, const ByteData &data,
+                                        bool encrypt)
+{
+    ByteData result(0, data.size());
+    const CryptoPP::BlockTransformation &cipher =
+        encrypt ? static_cast<const CryptoPP::BlockTransformation &>(encryption) : decryption;
+
+    for (std::size_t i = 0; i < data.size(); i += CryptoConstants::BLOCK_SIZE_BYTES)
+    {
+        cipher.ProcessBlock(data.secureData().data() + i, result.secureData().data() + i);
+    }
+
+    return result.size();
+}
+
+int main()
+{
+    using BenchmarkUtils::MIB;
+
+    ByteData key("0123456789abcdef", ByteData::Encoding::plain);
+    ByteData iv("fedcba9876543210", ByteData::Encoding::plain);
+    CryptoPP::AES::Encryption encryption(key.secureData().data(), key.size());
+    CryptoPP::AES::Decryption decryption(key.secureData().data(), key.size());
+
+    for (auto [size, iterations] : {std::pair{MIB, std::size_t{8}}, std::pair{64 * MIB, std::size_t{1}}})
+    {
+        auto sizeStr = std::to_string(size / MIB) + " MiB";
+        auto plain = BenchmarkUtils::pseudoRandomData(size);
+
+        BenchmarkUtils::report("before: rekey every block, encrypt " + sizeStr,
+                               BenchmarkUtils::throughputMbPerSec(
+                                   size, iterations, [&]() { return processRekeyingEveryBlock(key, plain, true); }));
+        BenchmarkUtils::report("before: rekey every block, decrypt " + sizeStr,
+                               BenchmarkUtils::throughputMbPerSec(
+                                   size, iterations, [&]() { return processRekeyingEveryBlock(key, plain, false); }));
+        BenchmarkUtils::report("after: cached key schedule, encrypt " + sizeStr,
+                               BenchmarkUtils::throughputMbPerSec(size, iterations, [&]() {
+                                   return processWithCachedKey(encryption, decryption, plain, true);
+                               }));
+        BenchmarkUtils::report("after: cached key schedule, decrypt " + sizeStr,
+                               BenchmarkUtils::throughputMbPerSec(size, iterations, [&]() {
+                                   return processWithCachedKey(encryption, decryption, plain, false);
+                               }));
+
+        for (auto backend : {Aes::Backend::cryptoPp, Aes::Backend::aesNi})
+        {
+            if (backend == Aes::Backend::aesNi && Aes(key, iv).backend() != Aes::Backend::aesNi)
+            {
+                std::cout << "AES-NI is not supported, skipping its lines" << std::endl;
+                continue;
+            }
+            auto backendStr = std::string(backend == Aes::Backend::aesNi ? "AES-NI" : "CryptoPP");
+
+            for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc})
+            {
+                auto modeStr = std::string(mode == Aes::Mode::ecb ? "ecb" : "cbc");
+                Aes aes(key, iv, mode, Aes::KeySize::bit128, backend);
+                auto cipher = aes.encrypt(plain);
+
+                BenchmarkUtils::report("Aes " + backendStr + " " + modeStr + " encrypt " + sizeStr,
+                                       BenchmarkUtils::throughputMbPerSec(
+                                           size, iterations, [&]() { return aes.encrypt(plain).size(); }));
+                BenchmarkUtils::report("Aes " + backendStr + " " + modeStr + " decrypt " + sizeStr,
+                                       BenchmarkUtils::throughputMbPerSec(
+                                           size, iterations, [&]() { return aes.decrypt(cipher).size(); }));
+                BenchmarkUtils::report("Aes " + backendStr + " " + modeStr + " decrypt " + sizeStr + ", all threads",
+                                       BenchmarkUtils::throughputMbPerSec(
+                                           size, iterations, [&]() { return aes.decrypt(cipher, 0).size(); }));
+            }
+
+            // ctr encrypts and decrypts the same way, in place through transformAt
+            Aes ctr(key, iv.subData(0, 8), Aes::Mode::ctr, Aes::KeySize::bit128, backend);
+            auto data = plain;
+            for (std::size_t numThreads : {1, 0})
+            {
+                BenchmarkUtils::report("Aes " + backendStr + " ctr transform " + sizeStr +
+                                           (numThreads == 0 ? ", all threads" : ""),
+                                       BenchmarkUtils::throughputMbPerSec(size, iterations, [&]() {
+                                           ctr.transformAt(0, data.secureData(), numThreads);
+                                           return data.size();
+                                       }));
+            }
+        }
+    }
+
+    // short messages, like the ones the ECB oracle encrypts, where the allocations of the ByteData overloads dominate
+    constexpr std::size_t MESSAGE_SIZE = 64;
+    constexpr std::size_t MESSAGES = 100000;
+    auto message = BenchmarkUtils::pseudoRandomData(MESSAGE_SIZE);
+    Aes ecb(key, ByteData(), Aes::Mode::ecb);
+    std::vector<std::uint8_t> buffer(ecb.cipherSize(MESSAGE_SIZE));
+
+    BenchmarkUtils::report("Aes ecb encrypt 64 byte messages, ByteData",
+                           BenchmarkUtils::throughputMbPerSec(MESSAGE_SIZE, MESSAGES, [&]() {
+                               return ecb.encrypt(message).size();
+                           }));
+    BenchmarkUtils::report("Aes ecb encrypt 64 byte messages, caller buffer",
+                           BenchmarkUtils::throughputMbPerSec(MESSAGE_SIZE, MESSAGES, [&]() {
+                               return ecb.encrypt(message, buffer);
+                           }));
+
+    return 0;
+}
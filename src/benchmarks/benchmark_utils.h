@@ -0,0 +1,82 @@
+#ifndef MATASANO_BENCHMARK_UTILS_H
+#define MATASANO_BENCHMARK_UTILS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "byte_data.h"
+
+/**
+ * @brief A collection of helpers shared by the benchmark executables
+ */
+namespace BenchmarkUtils
+{
+/**
+ * @brief Number of bytes in one MiB
+ */
+static constexpr std::size_t MIB = 1024 * 1024;
+
+/**
+ * @brief Creates ByteData with length of 'length' filled with pseudo random bytes
+ * Unlike GeneralUtils::randomData it uses a single seeded engine, so it is fast enough for hundreds of MiB and the
+ * data is the same between runs
+ *
+ * @param length the length of the data
+ * @param seed seed of the random engine
+ * @return ByteData the pseudo random data
+ */
+inline ByteData pseudoRandomData(std::size_t length, std::uint32_t seed = 42)
+{
+    ByteData res(0, length);
+    std::mt19937 engine{seed};
+
+    for (auto &b : res.secureData())
+    {
+        b = static_cast<std::uint8_t>(engine());
+    }
+
+    return res;
+}
+
+/**
+ * @brief Runs a given function 'iterations' times and measures the throughput
+ *
+ * @param bytesPerIteration number of bytes processed by one call of f
+ * @param iterations number of times to call f
+ * @param f the function to measure, should return the number of bytes it produced (used to keep the work observable)
+ * @return throughput in MB/s (MiB based)
+ */
+template <typename F> double throughputMbPerSec(std::size_t bytesPerIteration, std::size_t iterations, F &&f)
+{
+    volatile std::size_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        sink = sink + f();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return static_cast<double>(bytesPerIteration * iterations) / static_cast<double>(MIB) / elapsed.count();
+}
+
+/**
+ * @brief Prints one line of the benchmark report
+ *
+ * @param name name of the measured case
+ * @param mbPerSec measured throughput
+ */
+inline void report(const std::string &name, double mbPerSec)
+{
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << mbPerSec << " MB/s" << std::endl;
+}
+
+} // namespace BenchmarkUtils
+
+#endif
@@ -0,0 +1,95 @@
+#include "byte_data.h"
+#include "decryptor_xor.h"
+#include "file_utils.h"
+#include "language_model.h"
+#include "xor_scorers.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief number of snippets every scorer is measured on, per snippet length
+ */
+static constexpr std::size_t SNIPPETS = 2000;
+
+/**
+ * @brief Cuts SNIPPETS snippets of a given length spread over a text, and xors each one with its own key
+ *
+ * @param text the text to cut
+ * @param length the length of each snippet
+ * @param keys filled with the key of each snippet
+ * @return the ciphered snippets
+ */
+static std::vector<ByteData> cipheredSnippets(const std::string &text, std::size_t length,
+                                              std::vector<std::uint8_t> &keys)
+{
+    std::vector<ByteData> snippets;
+    keys.clear();
+
+    auto step = (text.size() - length) / SNIPPETS;
+    for (std::size_t i = 0; i < SNIPPETS; i++)
+    {
+        auto key = static_cast<std::uint8_t>(i * 167 + 13);
+        snippets.push_back(ByteData(text.substr(i * step, length), ByteData::Encoding::plain) ^ key);
+        keys.push_back(key);
+    }
+
+    return snippets;
+}
+
+/**
+ * @brief Finds the key of every snippet with a given scorer, and prints the accuracy and the time per scored key
+ */
+template <XorScorer Scorer>
+static void measure(const std::string &name, const Scorer &scorer, const std::vector<ByteData> &snippets,
+                    const std::vector<std::uint8_t> &keys)
+{
+    std::size_t correct = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < snippets.size(); i++)
+    {
+        auto best = DecryptorXor::rankSingleByteKeys(snippets[i], 1, scorer);
+        correct += best.front().first == keys[i];
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << 100.0 * static_cast<double>(correct) / static_cast<double>(snippets.size()) << " %"
+              << std::setw(10) << elapsed.count() / static_cast<double>(snippets.size() * 256) << " ns/key"
+              << std::endl;
+}
+
+int main()
+{
+    auto lotr = FileUtils::read(LOTR_PATH);
+    auto mobydick = FileUtils::read(MOBYDICK_PATH);
+
+    // trained on one book, measured on the other one
+    for (auto [reference, text, caseStr] : {std::tuple{&lotr, &mobydick, std::string("lotr -> mobydick")},
+                                            std::tuple{&mobydick, &lotr, std::string("mobydick -> lotr")}})
+    {
+        LanguageModel model(ByteData(*reference, ByteData::Encoding::plain));
+        L1Scorer l1(model);
+        ChiSquaredScorer chiSquared(model);
+        LogLikelihoodScorer logLikelihood(model);
+        PrintableScorer printable;
+
+        for (std::size_t length : {8, 16, 32, 64, 256})
+        {
+            std::vector<std::uint8_t> keys;
+            auto snippets = cipheredSnippets(*text, length, keys);
+            auto suffix = ", " + std::to_string(length) + " bytes, " + caseStr;
+
+            measure("l1" + suffix, l1, snippets, keys);
+            measure("chi-squared" + suffix, chiSquared, snippets, keys);
+            measure("log-likelihood" + suffix, logLikelihood, snippets, keys);
+            measure("printable" + suffix, printable, snippets, keys);
+        }
+    }
+
+    return 0;
+}
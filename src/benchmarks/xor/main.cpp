@@ -0,0 +1,55 @@
+#include "benchmark_utils.h"
+#include "byte_data.h"
+
+#include <string>
+
+/**
+ * @brief Repeating key xor with a modulo per byte, this is what ByteData used to do before the vectorized kernel,
+ * so it serves as the 'before' line of the report
+ *
+ * @param data data to xor
+ * @param key key that is applied cyclically
+ * @param result result buffer, should have the size of data
+ * @return the number of bytes processed
+ */
+static std::size_t xorWithModulo(const ByteData &data, const ByteData &key, ByteData &result)
+{
+    for (std::size_t i = 0; i < data.size(); i++)
+    {
+        result.secureData().at(i) = data.secureData().at(i) ^ key.secureData().at(i % key.size());
+    }
+
+    return result.size();
+}
+
+int main()
+{
+    using BenchmarkUtils::MIB;
+
+    for (auto [size, iterations] : {std::pair{MIB, std::size_t{64}}, std::pair{256 * MIB, std::size_t{1}}})
+    {
+        auto sizeStr = std::to_string(size / MIB) + " MiB";
+        auto plain = BenchmarkUtils::pseudoRandomData(size);
+        ByteData result(0, size);
+
+        for (std::size_t keySize : {3, 16, 29, 100})
+        {
+            auto key = BenchmarkUtils::pseudoRandomData(keySize, static_cast<std::uint32_t>(keySize));
+            auto caseStr = std::to_string(keySize) + " byte key, " + sizeStr;
+
+            BenchmarkUtils::report("before: modulo per byte, " + caseStr,
+                                   BenchmarkUtils::throughputMbPerSec(
+                                       size, iterations, [&]() { return xorWithModulo(plain, key, result); }));
+            BenchmarkUtils::report("after: xorTo, " + caseStr,
+                                   BenchmarkUtils::throughputMbPerSec(size, iterations, [&]() {
+                                       ByteData::xorTo(plain, key, result);
+                                       return result.size();
+                                   }));
+            BenchmarkUtils::report("after: operator^, " + caseStr,
+                                   BenchmarkUtils::throughputMbPerSec(
+                                       size, iterations, [&]() { return (plain ^ key).size(); }));
+        }
+    }
+
+    return 0;
+}
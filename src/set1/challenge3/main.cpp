@@ -1,6 +1,6 @@
 #include "byte_data.h"
 #include "decryptor_xor.h"
-#include "file_utils.h"
+#include "language_model.h"
 #include "matasano_asserts.h"
 
 #include <iostream>
@@ -10,8 +10,7 @@ static const std::string CIPHERED_TEXT = "1b37373331363f78151b7f2b783431333d7839
 
 int main()
 {
-    auto referenceEnglish = FileUtils::read("./assets/lotr.txt");
-    DecryptorXor decryptor(referenceEnglish);
+    DecryptorXor decryptor(LanguageModel::load("assets/lotr.model"));
     auto [resultStr, resultCipher, ignore] = decryptor.decipherSingle(CIPHERED_TEXT);
     std::cout << "The text is: " << resultStr << std::endl;
     std::cout << "The cipher byte was: " << resultCipher << std::endl;
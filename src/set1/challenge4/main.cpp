@@ -1,35 +1,29 @@
 #include "byte_data.h"
 #include "decryptor_xor.h"
 #include "file_utils.h"
+#include "language_model.h"
 #include "matasano_asserts.h"
 
 #include <iostream>
-#include <limits>
 #include <string>
+#include <vector>
 
 int main()
 {
     auto cipheredStrings = FileUtils::readLines("assets/4.txt");
-    auto referenceEnglish = FileUtils::read("assets/lotr.txt");
-    DecryptorXor decryptor(referenceEnglish);
+    DecryptorXor decryptor(LanguageModel::load("assets/lotr.model"));
 
-    std::string resultString = cipheredStrings.at(0);
-    auto resultDecipher = std::make_tuple(std::string(), std::uint8_t{0}, std::numeric_limits<double>::max());
+    std::vector<ByteData> cipheredData(cipheredStrings.begin(), cipheredStrings.end());
+    std::vector<ByteView> cipheredViews(cipheredData.begin(), cipheredData.end());
 
-    for (auto const &cipheredString : cipheredStrings)
-    {
-        auto candidateDecipher = decryptor.decipherSingle(cipheredString);
-        if (std::get<2>(candidateDecipher) < std::get<2>(resultDecipher))
-        {
-            resultDecipher = candidateDecipher;
-            resultString = cipheredString;
-        }
-    }
+    auto best = decryptor.decipherSingleBatch(cipheredViews, 1, 0);
+    THROW_IF(best.empty(), "no ciphered strings", std::runtime_error);
 
-    auto [decipher, key, ignore] = resultDecipher;
-    std::cout << "The ciphered string was: " << resultString << std::endl;
-    std::cout << "The deciphered result is: " << decipher << std::endl;
+    auto [index, key, ignore] = best.front();
+    std::cout << "The ciphered string was: " << cipheredStrings.at(index) << std::endl;
+    std::cout << "The deciphered result is: " << (cipheredData.at(index) ^ ByteData(key)).str(ByteData::Encoding::plain)
+              << std::endl;
     std::cout << "The key is: " << key << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #include "byte_data.h"
-#include "file_utils.h"
 #include "matasano_asserts.h"
+#include "xor_stream.h"
+#include <fstream>
 #include <iostream>
 #include <string>
 
@@ -39,14 +40,18 @@ int main()
                      .str(ByteData::Encoding::plain)
               << std::endl;
 
-    auto passwd = FileUtils::read("/etc/passwd");
+    // streamed straight to the output twice, the file is never held in memory
+    std::ifstream passwd("/etc/passwd", std::ios::in | std::ios::binary);
+    THROW_IF(!passwd, "can't open /etc/passwd", std::ifstream::failure);
+
     std::cout << std::endl << "etc password file :" << std::endl;
-    std::cout << passwd << std::endl;
+    std::cout << passwd.rdbuf() << std::endl;
     std::cout << std::endl;
     std::cout << "Encypted result:" << std::endl;
-    std::cout << (ByteData(passwd, ByteData::Encoding::plain) ^ ByteData(KEY, ByteData::Encoding::plain))
-                     .str(ByteData::Encoding::plain)
-              << std::endl;
+    passwd.clear();
+    passwd.seekg(0);
+    XorStream(ByteData(KEY, ByteData::Encoding::plain)).process(passwd, std::cout);
+    std::cout << std::endl;
 
     return 0;
 }
\ No newline at end of file
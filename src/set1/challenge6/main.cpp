@@ -1,6 +1,7 @@
 #include "byte_data.h"
 #include "decryptor_xor.h"
 #include "file_utils.h"
+#include "language_model.h"
 #include "matasano_asserts.h"
 
 #include <iostream>
@@ -9,11 +10,10 @@
 
 int main()
 {
-    auto cipheredBase64Str = FileUtils::read("assets/6.txt", true);
-    auto referenceEnglish = FileUtils::read("assets/lotr.txt");
-    DecryptorXor decryptor(referenceEnglish);
+    auto cipheredBase64Str = FileUtils::read("assets/6.txt");
+    DecryptorXor decryptor(LanguageModel::load("assets/lotr.model"));
 
-    ByteData cipheredBase64(cipheredBase64Str, ByteData::Encoding::base64);
+    ByteData cipheredBase64(cipheredBase64Str, ByteData::Encoding::base64IgnoreWhitespace);
 
     auto [decipher, key, ignore] = decryptor.decipherMulti(cipheredBase64, std::pair(2, 40));
 
@@ -2,25 +2,23 @@
 #include "file_utils.h"
 #include "matasano_asserts.h"
 #include <iostream>
-#include <set>
 #include <string>
+#include <unordered_set>
 
 /**
- * @brief Iterates over the given vector of ByteData and finds a pair of identical ByteData (if any)
+ * @brief Iterates over the given vector of ByteView and finds a pair of identical ByteView (if any)
  *
- * @return pair of identical ByteData if found
+ * @return pair of identical ByteView if found
  */
-static std::optional<ByteData> hasIdenticalByteData(const std::vector<ByteData> &bytesVector)
+static std::optional<ByteView> hasIdenticalByteData(const std::vector<ByteView> &bytesVector)
 {
-    std::set<ByteData> bytesSet;
-    for (auto &byteData : bytesVector)
+    std::unordered_set<ByteView> bytesSet;
+    for (auto byteView : bytesVector)
     {
-        if (bytesSet.contains(byteData))
+        if (!bytesSet.insert(byteView).second)
         {
-            return byteData;
+            return byteView;
         }
-
-        bytesSet.insert(byteData);
     }
 
     return {};
@@ -36,11 +34,12 @@ int main()
 
     for (auto &line : lines)
     {
-        auto rows = ByteData(line).extractRows(16);
-        identical = hasIdenticalByteData(rows);
+        ByteData lineData(line);
+        auto identicalView = hasIdenticalByteData(lineData.extractRowViews(16));
 
-        if (identical)
+        if (identicalView)
         {
+            identical = ByteData(*identicalView);
             // we should only hae one ECB enconded cipher, according to exercise
             VALIDATE_FALSE(found);
             found = true;
@@ -10,7 +10,7 @@ static const std::vector<std::uint8_t> IV(16, 0);
 
 int main()
 {
-    auto cipher = ByteData(FileUtils::read("assets/10.txt", true), ByteData::Encoding::base64);
+    auto cipher = ByteData(FileUtils::read("assets/10.txt"), ByteData::Encoding::base64IgnoreWhitespace);
     ByteData key(KEY, ByteData::Encoding::plain);
     ByteData iv(IV);
 
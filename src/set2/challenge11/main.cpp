@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <functional>
 #include <iostream>
 
@@ -7,7 +8,7 @@
 #include "general_utils.h"
 #include "matasano_asserts.h"
 
-static ByteData randomEncryptor(const ByteData &plain, bool &outIsEcb)
+static std::size_t randomEncryptor(ByteView plain, std::span<std::uint8_t> out, bool &outIsEcb)
 {
     auto key = GeneralUtils::randomData(16);
     auto iv = GeneralUtils::randomData(16);
@@ -21,7 +22,13 @@ static ByteData randomEncryptor(const ByteData &plain, bool &outIsEcb)
     outIsEcb = (GeneralUtils::randomNum(0, 1) == 1) ? true : false;
 
     Aes aes(key, iv, outIsEcb ? Aes::Mode::ecb : Aes::Mode::cbc);
-    return aes.encrypt(prepend + plain + append);
+    auto cipher = aes.encrypt(prepend + ByteData(plain) + append);
+    if (cipher.size() <= out.size())
+    {
+        std::copy(cipher.secureData().begin(), cipher.secureData().end(), out.begin());
+    }
+
+    return cipher.size();
 }
 
 int main()
@@ -31,8 +38,9 @@ int main()
 
     for (std::size_t i = 0; i < 1000; i++)
     {
-        AesEcbOracle oracle([&isEcb](const ByteData &plain) { return randomEncryptor(plain, isEcb); },
-                            AesEcbOracle::EncryptorType::RandomUpToBlock1_Plain_RandomUpToBlock2);
+        AesEcbOracle oracle(
+            [&isEcb](ByteView plain, std::span<std::uint8_t> out) { return randomEncryptor(plain, out, isEcb); },
+            AesEcbOracle::EncryptorType::RandomUpToBlock1_Plain_RandomUpToBlock2);
         VALIDATE_EQ(isEcb, oracle.isEcb());
     }
 
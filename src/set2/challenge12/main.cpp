@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <functional>
 #include <iostream>
 
@@ -11,12 +12,23 @@ static const std::string PLAIN_HEX =
     "Um9sbGluJyBpbiBteSA1LjAKV2l0aCBteSByYWctdG9wIGRvd24gc28gbXkgaGFpciBjYW4gYmxvdwpUa"
     "GUgZ2lybGllcyBvbiBzdGFuZGJ5IHdhdmluZyBqdXN0IHRvIHNheSBoaQpEaWQgeW91IHN0b3A/IE5vLCBJIGp1c3QgZHJvdmUgYnkK";
 
-static const auto KEY = GeneralUtils::randomData(16);
+static const Aes AES(GeneralUtils::randomData(16), ByteData(), Aes::Mode::ecb);
+static const ByteData SECRET(PLAIN_HEX, ByteData::Encoding::base64);
 
-static ByteData randomEncryptor(const ByteData &plain)
+static std::size_t randomEncryptor(ByteView plain, std::span<std::uint8_t> out)
 {
-    Aes aes(KEY, ByteData(), Aes::Mode::ecb);
-    return aes.encrypt(plain + ByteData(PLAIN_HEX, ByteData::Encoding::base64));
+    // plain and the secret are written into the oracle's buffer once and encrypted in place, padding included
+    auto cipherSize = AES.cipherSize(plain.size() + SECRET.size());
+    if (cipherSize > out.size())
+    {
+        return cipherSize;
+    }
+
+    std::copy(plain.begin(), plain.end(), out.begin());
+    std::copy(SECRET.secureData().begin(), SECRET.secureData().end(),
+              out.begin() + static_cast<std::ptrdiff_t>(plain.size()));
+
+    return AES.encryptInPlace(out, plain.size() + SECRET.size());
 }
 
 int main()
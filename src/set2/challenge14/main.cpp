@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <functional>
 #include <iostream>
 
@@ -11,11 +12,24 @@ static const std::string TARGET_BYTES = "This is a message I would like to decry
 
 static const auto KEY = GeneralUtils::randomData(16);
 static const auto RANDOM_PREFIX = GeneralUtils::randomData(GeneralUtils::randomNum(0, 40));
+static const Aes AES(KEY, ByteData(), Aes::Mode::ecb);
+static const ByteData TARGET(TARGET_BYTES, ByteData::Encoding::plain);
 
-static ByteData randomEncryptor(const ByteData &plain)
+static std::size_t randomEncryptor(ByteView plain, std::span<std::uint8_t> out)
 {
-    Aes aes(KEY, ByteData(), Aes::Mode::ecb);
-    return aes.encrypt(RANDOM_PREFIX + plain + ByteData(TARGET_BYTES, ByteData::Encoding::plain));
+    // the prefix, plain and the target are written into the oracle's buffer once and encrypted in place
+    auto plainSize = RANDOM_PREFIX.size() + plain.size() + TARGET.size();
+    auto cipherSize = AES.cipherSize(plainSize);
+    if (cipherSize > out.size())
+    {
+        return cipherSize;
+    }
+
+    auto it = std::copy(RANDOM_PREFIX.secureData().begin(), RANDOM_PREFIX.secureData().end(), out.begin());
+    it = std::copy(plain.begin(), plain.end(), it);
+    std::copy(TARGET.secureData().begin(), TARGET.secureData().end(), it);
+
+    return AES.encryptInPlace(out, plainSize);
 }
 
 int main()
@@ -0,0 +1,72 @@
+#include "aes.h"
+#include "aes_stream.h"
+#include "byte_data.h"
+#include "tool_utils.h"
+
+#include <cstring>
+#include <string>
+
+static void usage(const char *name)
+{
+    ToolUtils::usage(name, "[--threads <n>] [--iv <iv>] <encrypt|decrypt> <ecb|cbc|ctr> <key> <input> <output>",
+                     "encrypts or decrypts input with AES-128 and writes the result to output, in constant memory",
+                     {{"--threads", "number of threads, 0 for all of them (1 by default)"},
+                      {"--iv", "the iv in hex, 16 bytes for cbc and the 8 byte nonce for ctr"},
+                      {"key", "the key in hex, 16 bytes"},
+                      {"-", "as input or output is the standard input or output"}});
+}
+
+int main(int argc, char *argv[])
+{
+    int arg = 1;
+    std::size_t numThreads = 1;
+    ByteData iv;
+    int result = ToolUtils::run([&]() {
+        for (; arg + 1 < argc && std::strncmp(argv[arg], "--", 2) == 0; arg += 2)
+        {
+            if (std::strcmp(argv[arg], "--threads") == 0)
+            {
+                numThreads = std::stoul(argv[arg + 1]);
+            }
+            else if (std::strcmp(argv[arg], "--iv") == 0)
+            {
+                iv = ByteData(argv[arg + 1], ByteData::Encoding::hex);
+            }
+            else
+            {
+                break;
+            }
+        }
+    });
+    if (result != 0)
+    {
+        return result;
+    }
+
+    if (argc - arg != 5)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::string direction = argv[arg];
+    std::string mode = argv[arg + 1];
+    if ((direction != "encrypt" && direction != "decrypt") || (mode != "ecb" && mode != "cbc" && mode != "ctr"))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Aes::Mode aesMode = mode == "ecb" ? Aes::Mode::ecb : mode == "cbc" ? Aes::Mode::cbc : Aes::Mode::ctr;
+    auto streamDirection = direction == "encrypt" ? AesStream::Direction::encrypt : AesStream::Direction::decrypt;
+    std::string key = argv[arg + 2];
+    std::string input = argv[arg + 3];
+    std::string output = argv[arg + 4];
+    return ToolUtils::run([&]() {
+        Aes aes(ByteData(key, ByteData::Encoding::hex), iv, aesMode);
+        ToolUtils::FileStreams streams(input, output);
+
+        AesStream stream(aes, streamDirection, Aes::Padding::pkcs7, numThreads);
+        stream.process(streams.in(), streams.out());
+    });
+}
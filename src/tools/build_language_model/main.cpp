@@ -0,0 +1,26 @@
+#include "byte_data.h"
+#include "file_utils.h"
+#include "language_model.h"
+#include "tool_utils.h"
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        ToolUtils::usage(argv[0], "<reference text> <output model>",
+                         "builds the language model of a reference text and saves it to output model", {});
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    return ToolUtils::run([&]() {
+        auto referenceText = FileUtils::read(input);
+        LanguageModel model(ByteData(referenceText, ByteData::Encoding::plain));
+        model.save(output);
+        std::cout << output << ": " << model.total() << " bytes of reference text" << std::endl;
+    });
+}
@@ -0,0 +1,107 @@
+#ifndef MATASANO_TOOL_UTILS_H
+#define MATASANO_TOOL_UTILS_H
+
+#include <exception>
+#include <fstream>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "matasano_asserts.h"
+
+/**
+ * @brief A collection of helpers shared by the command line tools
+ */
+namespace ToolUtils
+{
+/**
+ * @brief The input and the output of a tool: files, or the standard input / output when the name is "-"
+ */
+class FileStreams
+{
+public:
+    /**
+     * @brief Opens the input for reading and creates (or truncates) the output, both binary
+     *
+     * @param input the input file name, "-" for the standard input
+     * @param output the output file name, "-" for the standard output
+     * @throw std::ios_base::failure if a file can't be opened or created
+     */
+    FileStreams(const std::string &input, const std::string &output) : stdin_(input == "-"), stdout_(output == "-")
+    {
+        // the streams are read in large blocks, don't pay for syncing them with stdio
+        std::ios::sync_with_stdio(false);
+
+        inFile_.exceptions(std::ifstream::badbit);
+        outFile_.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        if (!stdin_)
+        {
+            inFile_.open(input, std::ios::in | std::ios::binary);
+            THROW_IF(!inFile_.is_open(), "can't open " + input, std::ifstream::failure);
+        }
+        if (!stdout_)
+        {
+            outFile_.open(output, std::ios::out | std::ios::binary | std::ios::trunc);
+        }
+    }
+
+    /**
+     * @brief the stream to read
+     */
+    inline std::istream &in() { return stdin_ ? std::cin : inFile_; }
+
+    /**
+     * @brief the stream to write
+     */
+    inline std::ostream &out() { return stdout_ ? std::cout : outFile_; }
+
+private:
+    bool stdin_;
+    bool stdout_;
+    std::ifstream inFile_;
+    std::ofstream outFile_;
+};
+
+/**
+ * @brief Prints the usage of a tool to the standard error
+ *
+ * @param name the name the tool was run with (argv[0])
+ * @param arguments the arguments line
+ * @param description what the tool does
+ * @param options an explanation of each option / argument
+ */
+inline void usage(const char *name, const std::string &arguments, const std::string &description,
+                  std::initializer_list<std::pair<const char *, const char *>> options)
+{
+    std::cerr << "usage: " << name << " " << arguments << std::endl << "  " << description << std::endl;
+    for (auto [option, explanation] : options)
+    {
+        std::cerr << "  " << std::left << std::setw(11) << option << explanation << std::endl;
+    }
+}
+
+/**
+ * @brief Runs the body of a tool, an exception is printed to the standard error instead of terminating the process
+ *
+ * @param body the body of the tool
+ * @return the exit code of the tool, 0 on success and 1 if the body threw
+ */
+template <typename F> int run(F &&body)
+{
+    try
+    {
+        body();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+} // namespace ToolUtils
+
+#endif
@@ -0,0 +1,52 @@
+#include "byte_data.h"
+#include "tool_utils.h"
+#include "xor_stream.h"
+
+#include <cstring>
+#include <string>
+
+static void usage(const char *name)
+{
+    ToolUtils::usage(name, "[--hex] <key> <input> [<output>]",
+                     "xors input with the repeating key and writes the result to output, or back into input if there "
+                     "is no output",
+                     {{"--hex", "the key is given in hex, otherwise its characters are the key bytes"},
+                      {"-", "as input or output is the standard input or output"}});
+}
+
+int main(int argc, char *argv[])
+{
+    int arg = 1;
+    auto encoding = ByteData::Encoding::plain;
+    if (arg < argc && std::strcmp(argv[arg], "--hex") == 0)
+    {
+        encoding = ByteData::Encoding::hex;
+        arg++;
+    }
+
+    if (argc - arg != 2 && argc - arg != 3)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    return ToolUtils::run([&]() {
+        ByteData key(argv[arg], encoding);
+        std::string input = argv[arg + 1];
+
+        if (argc - arg == 2)
+        {
+            XorStream::xorFileInPlace(input, key);
+        }
+        else if (std::string output = argv[arg + 2]; input != "-" && output != "-")
+        {
+            XorStream::xorFile(input, output, key);
+        }
+        else
+        {
+            // pipes can't be mapped, stream through a buffer instead
+            ToolUtils::FileStreams streams(input, output);
+            XorStream(key).process(streams.in(), streams.out());
+        }
+    });
+}
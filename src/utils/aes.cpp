@@ -4,14 +4,65 @@
 #include <cryptopp/files.h>
 #include <cryptopp/modes.h>
 
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include "aes.h"
-#include "crypto_block_aggregator.h"
 #include "crypto_constants.h"
+#include "general_utils.h"
+#include "internal/aes_ni_kernel.h"
+#include "internal/xor_kernel.h"
 #include "matasano_asserts.h"
 #include "padder.h"
 
-Aes::Aes(const ByteData &key, const ByteData &iv, Mode mode, KeySize keySize)
-    : key_(key), iv_(iv), mode_(mode), keySize_(keySize)
+namespace
+{
+constexpr std::size_t BLOCK_SIZE = CryptoConstants::BLOCK_SIZE_BYTES;
+
+/**
+ * @brief the nonce is the first half of a ctr counter block, the block counter the second half
+ */
+constexpr std::size_t CTR_NONCE_SIZE = 8;
+
+/**
+ * @brief number of blocks the CryptoPP backend processes at a time through a stack buffer (ctr counter blocks, in
+ * place cbc decryption)
+ */
+constexpr std::size_t BATCH_BLOCKS = 64;
+
+/**
+ * @brief the calling thread's copy of a shared CryptoPP cipher. The ciphers keep scratch space, so they can't be used
+ * by several threads at once, and copying one allocates. The copy is made again only when the thread moves to another
+ * key schedule (another Aes object)
+ *
+ * @param shared the key schedule shared between the copies of an Aes object
+ * @return the copy, valid until the thread asks for another key schedule
+ */
+template <typename Cipher> Cipher &threadCipher(const std::shared_ptr<const Cipher> &shared)
+{
+    struct Cached
+    {
+        // weak, so a destroyed schedule is not kept alive and its address is never mistaken for a new one
+        std::weak_ptr<const Cipher> source;
+        std::optional<Cipher> cipher;
+    };
+    thread_local Cached cached;
+
+    if (cached.source.lock() != shared)
+    {
+        cached.cipher.emplace(*shared);
+        cached.source = shared;
+    }
+
+    return *cached.cipher;
+}
+} // namespace
+
+Aes::Aes(const ByteData &key, const ByteData &iv, Mode mode, KeySize keySize, Backend backend)
+    : iv_(iv), mode_(mode), keySize_(keySize)
 {
     switch (mode_)
     {
@@ -20,6 +71,9 @@ Aes::Aes(const ByteData &key, const ByteData &iv, Mode mode, KeySize keySize)
     case (Aes::Mode::cbc):
         THROW_IF(iv.size() != 16, "iv should be 16 bytes long for cbc", std::invalid_argument);
         break;
+    case (Aes::Mode::ctr):
+        THROW_IF(iv.size() != CTR_NONCE_SIZE, "nonce should be 8 bytes long for ctr", std::invalid_argument);
+        break;
     default:
         throw std::invalid_argument("Invalid mode");
     }
@@ -32,88 +86,336 @@ Aes::Aes(const ByteData &key, const ByteData &iv, Mode mode, KeySize keySize)
     default:
         throw std::invalid_argument("Invalid Key Size");
     }
+
+    THROW_IF(backend == Backend::aesNi && !AesNiKernel::supported(), "AES-NI is not supported by this CPU",
+             std::invalid_argument);
+
+    // the key schedule is expanded only once and shared between copies. The native kernel is stateless, the CryptoPP
+    // ciphers are not (they keep scratch space), so they are only ever used through a copy per thread
+    if (backend != Backend::cryptoPp && AesNiKernel::supported())
+    {
+        native_ = std::make_shared<const AesNiKernel>(key.secureData().data());
+    }
+    else
+    {
+        encryption_ = std::make_shared<const CryptoPP::AES::Encryption>(key.secureData().data(), key.size());
+        decryption_ = std::make_shared<const CryptoPP::AES::Decryption>(key.secureData().data(), key.size());
+    }
 }
 
-ByteData Aes::encrypt(const ByteData &plain) const { return encryptDecrypt(plain, true); }
+ByteData Aes::encrypt(const ByteData &plain, std::size_t numThreads) const
+{
+    return encryptDecrypt(plain, true, numThreads);
+}
 
-ByteData Aes::decrypt(const ByteData &plain) const { return encryptDecrypt(plain, false); }
+ByteData Aes::decrypt(const ByteData &plain, std::size_t numThreads) const
+{
+    return encryptDecrypt(plain, false, numThreads);
+}
 
-ByteData Aes::encryptDecrypt(const ByteData &data, bool encrypt) const
+ByteData Aes::encryptDecrypt(const ByteData &data, bool encrypt, std::size_t numThreads) const
 {
     THROW_IF(data.size() == 0, "can't " + std::string(encrypt ? "encrypt" : "decrypt") + " empty data",
              std::invalid_argument);
 
-    switch (mode_)
+    ByteData result(0, encrypt ? cipherSize(data.size()) : data.size());
+    auto size = encrypt ? this->encrypt(data, result.secureData(), Padding::pkcs7, numThreads)
+                        : decrypt(data, result.secureData(), Padding::pkcs7, numThreads);
+    result.secureData().resize(size);
+
+    return result;
+}
+
+std::size_t Aes::cipherSize(std::size_t plainSize, Padding padding) const
+{
+    if (mode_ == Mode::ctr)
     {
-    case (Aes::Mode::ecb):
-        return encryptDecryptEcb(data, encrypt);
-    case (Aes::Mode::cbc):
-        return encryptDecryptCbc(data, encrypt);
-    default:
-        LOGIC_SHOULD_NOT_REACH_THAT_POINT();
+        return plainSize;
     }
 
-    LOGIC_SHOULD_NOT_REACH_THAT_POINT();
-    return ByteData();
+    if (padding == Padding::none)
+    {
+        THROW_IF(plainSize % BLOCK_SIZE != 0, "data without padding should be whole blocks", std::invalid_argument);
+        return plainSize;
+    }
+
+    return plainSize - plainSize % BLOCK_SIZE + BLOCK_SIZE;
 }
 
-ByteData Aes::ecbEncryptDecryptBlock(const ByteData &block, bool encrypt) const
+std::size_t Aes::encrypt(ByteView plain, std::span<std::uint8_t> out, Padding padding, std::size_t numThreads) const
 {
-    LOGIC_ASSERT(block.size() % CryptoConstants::BLOCK_SIZE_BYTES == 0);
-    ByteData result(0, block.size());
-
-    CryptoPP::SecByteBlock key(key_.secureData().data(), key_.size());
-    if (encrypt)
+    if (mode_ == Mode::ctr)
     {
-        CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption ecbEncryption(key, key.size());
-        ecbEncryption.ProcessData(result.secureData().data(), block.secureData().data(), result.size());
+        transformAt(0, plain, out, numThreads);
+        return plain.size();
     }
-    else
+
+    auto size = cipherSize(plain.size(), padding);
+    THROW_IF(out.size() < size, "output is shorter than the cipher", std::invalid_argument);
+
+    // the padded last block is built before anything is written, out may be the same memory as plain
+    auto whole = plain.size() - plain.size() % BLOCK_SIZE;
+    std::array<std::uint8_t, BLOCK_SIZE> last;
+    std::copy(plain.begin() + static_cast<std::ptrdiff_t>(whole), plain.end(), last.begin());
+    std::fill(last.begin() + static_cast<std::ptrdiff_t>(plain.size() - whole), last.end(),
+              static_cast<std::uint8_t>(BLOCK_SIZE - (plain.size() - whole)));
+
+    auto const *iv = iv_.secureData().data();
+    encryptDecryptBlocks(iv, plain.data(), whole, out.data(), true, numThreads);
+    if (padding == Padding::pkcs7)
     {
-        CryptoPP::ECB_Mode<CryptoPP::AES>::Decryption ecbDecryption(key, key.size());
-        ecbDecryption.ProcessData(result.secureData().data(), block.secureData().data(), result.size());
+        encryptDecryptBlocks(whole == 0 ? iv : out.data() + whole - BLOCK_SIZE, last.data(), BLOCK_SIZE,
+                             out.data() + whole, true, 1);
     }
 
-    return result;
+    return size;
 }
 
-ByteData Aes::encryptDecryptEcb(const ByteData &data, bool encrypt) const
+std::size_t Aes::decrypt(ByteView cipher, std::span<std::uint8_t> out, Padding padding, std::size_t numThreads) const
 {
-    LOGIC_ASSERT(data.size() != 0);
+    if (mode_ == Mode::ctr)
+    {
+        transformAt(0, cipher, out, numThreads);
+        return cipher.size();
+    }
 
-    CryptoBlockAggregator aggregator(data, encrypt ? CryptoBlockAggregator::Padding::PadOnGetBlock
-                                                   : CryptoBlockAggregator::Padding::UnpadOnAggregateBlock);
+    THROW_IF(cipher.size() % BLOCK_SIZE != 0, "ciphered data should be whole blocks", std::invalid_argument);
+    auto const *iv = iv_.secureData().data();
 
-    for (auto const &block : aggregator.blocksFromSource())
+    if (padding == Padding::none)
     {
-        aggregator.aggregateBlock(ecbEncryptDecryptBlock(block, encrypt));
+        THROW_IF(out.size() < cipher.size(), "output is shorter than the plain data", std::invalid_argument);
+        encryptDecryptBlocks(iv, cipher.data(), cipher.size(), out.data(), false, numThreads);
+        return cipher.size();
     }
 
-    return aggregator.output();
+    THROW_IF(cipher.empty(), "padded ciphered data can't be empty", std::invalid_argument);
+
+    // the last block is decrypted first: in place the cipher block before it is still there, and a wrong padding is
+    // reported before anything is written
+    auto whole = cipher.size() - BLOCK_SIZE;
+    std::array<std::uint8_t, BLOCK_SIZE> last;
+    encryptDecryptBlocks(whole == 0 ? iv : cipher.data() + whole - BLOCK_SIZE, cipher.data() + whole, BLOCK_SIZE,
+                         last.data(), false, 1);
+    auto size = cipher.size() - Padder::paddingSize(ByteView(last.data(), last.size()));
+    THROW_IF(out.size() < size, "output is shorter than the plain data", std::invalid_argument);
+
+    encryptDecryptBlocks(iv, cipher.data(), whole, out.data(), false, numThreads);
+    std::copy_n(last.begin(), size - whole, out.data() + whole);
+
+    return size;
 }
 
-ByteData Aes::encryptDecryptCbc(const ByteData &data, bool encrypt) const
+void Aes::encryptDecryptBlocks(ByteView iv, ByteView in, std::span<std::uint8_t> out, bool encrypt,
+                               std::size_t numThreads) const
 {
-    LOGIC_ASSERT(data.size() != 0);
-
-    CryptoBlockAggregator aggregator(data, encrypt ? CryptoBlockAggregator::Padding::PadOnGetBlock
-                                                   : CryptoBlockAggregator::Padding::UnpadOnAggregateBlock);
+    THROW_IF(mode_ == Mode::ctr, "CTR mode has no blocks to chain, use transformAt", std::logic_error);
+    THROW_IF(in.size() % BLOCK_SIZE != 0, "data should be whole blocks", std::invalid_argument);
+    THROW_IF(out.size() < in.size(), "output is shorter than the data", std::invalid_argument);
+    THROW_IF(mode_ == Mode::cbc && iv.size() != BLOCK_SIZE, "iv should be a block", std::invalid_argument);
 
-    auto prevCipheredBlock = iv_;
+    if (!in.empty())
+    {
+        encryptDecryptBlocks(iv.data(), in.data(), in.size(), out.data(), encrypt, numThreads);
+    }
+}
 
-    for (auto const &block : aggregator.blocksFromSource())
+void Aes::encryptDecryptBlocks(const std::uint8_t *iv, const std::uint8_t *in, std::size_t size, std::uint8_t *out,
+                               bool encrypt, std::size_t numThreads) const
+{
+    switch (mode_)
     {
+    case (Aes::Mode::ecb):
+        ecbEncryptDecryptBlocks(in, size, out, encrypt, numThreads);
+        break;
+    case (Aes::Mode::cbc):
+        cbcEncryptDecryptBlocks(iv, in, size, out, encrypt, numThreads);
+        break;
+    default:
+        LOGIC_SHOULD_NOT_REACH_THAT_POINT();
+    }
+}
+
+void Aes::ecbEncryptDecryptBlocks(const std::uint8_t *in, std::size_t size, std::uint8_t *out, bool encrypt,
+                                  std::size_t numThreads) const
+{
+    LOGIC_ASSERT(size % BLOCK_SIZE == 0);
+
+    GeneralUtils::parallelFor(GeneralUtils::ceil(size, PARALLEL_CHUNK), numThreads, [&](std::size_t chunk) {
+        auto offset = chunk * PARALLEL_CHUNK;
+        auto chunkSize = std::min(PARALLEL_CHUNK, size - offset);
+
+        if (native_)
+        {
+            auto blocks = chunkSize / BLOCK_SIZE;
+            encrypt ? native_->encryptEcb(in + offset, blocks, out + offset)
+                    : native_->decryptEcb(in + offset, blocks, out + offset);
+            return;
+        }
+
         if (encrypt)
         {
-            prevCipheredBlock = ecbEncryptDecryptBlock(prevCipheredBlock ^ block, encrypt);
-            aggregator.aggregateBlock(prevCipheredBlock);
+            auto &cipher = threadCipher(encryption_);
+            cipher.AdvancedProcessBlocks(in + offset, nullptr, out + offset, chunkSize,
+                                         CryptoPP::BlockTransformation::BT_AllowParallel);
         }
         else
         {
-            aggregator.aggregateBlock(prevCipheredBlock ^ ecbEncryptDecryptBlock(block, encrypt));
-            prevCipheredBlock = block;
+            auto &cipher = threadCipher(decryption_);
+            cipher.AdvancedProcessBlocks(in + offset, nullptr, out + offset, chunkSize,
+                                         CryptoPP::BlockTransformation::BT_AllowParallel);
+        }
+    });
+}
+
+void Aes::cbcEncryptDecryptBlocks(const std::uint8_t *iv, const std::uint8_t *in, std::size_t size, std::uint8_t *out,
+                                  bool encrypt, std::size_t numThreads) const
+{
+    LOGIC_ASSERT(size % BLOCK_SIZE == 0);
+
+    if (encrypt && native_)
+    {
+        native_->encryptCbc(iv, in, size / BLOCK_SIZE, out);
+        return;
+    }
+
+    if (encrypt)
+    {
+        // each block depends on the previous cipher block, one at a time
+        auto &cipher = threadCipher(encryption_);
+        auto const *previous = iv;
+        for (std::size_t i = 0; i < size; i += BLOCK_SIZE)
+        {
+            XorKernel::xorBlocks(in + i, previous, BLOCK_SIZE, out + i);
+            cipher.ProcessBlock(out + i, out + i);
+            previous = out + i;
         }
+        return;
+    }
+
+    // a decrypted block needs only its cipher block and the one before it, so the chunks are independent: the iv of
+    // a chunk is the last cipher block of the chunk before it. In place that block is overwritten by the chunk before,
+    // so the ivs are saved first
+    auto chunks = GeneralUtils::ceil(size, PARALLEL_CHUNK);
+    std::vector<std::array<std::uint8_t, BLOCK_SIZE>> savedIvs(in == out && chunks > 1 ? chunks : 0);
+    for (std::size_t chunk = 1; chunk < savedIvs.size(); chunk++)
+    {
+        std::copy_n(in + chunk * PARALLEL_CHUNK - BLOCK_SIZE, BLOCK_SIZE, savedIvs[chunk].begin());
     }
 
-    return aggregator.output();
-}
\ No newline at end of file
+    GeneralUtils::parallelFor(chunks, numThreads, [&](std::size_t chunk) {
+        auto offset = chunk * PARALLEL_CHUNK;
+        auto chunkSize = std::min(PARALLEL_CHUNK, size - offset);
+        auto const *chunkIv = offset == 0 ? iv : savedIvs.empty() ? in + offset - BLOCK_SIZE : savedIvs[chunk].data();
+
+        if (native_)
+        {
+            native_->decryptCbc(chunkIv, in + offset, chunkSize / BLOCK_SIZE, out + offset);
+            return;
+        }
+
+        auto &cipher = threadCipher(decryption_);
+        if (in != out)
+        {
+            // every decrypted block is xored with the previous cipher block, which is the input shifted by a block
+            cipher.AdvancedProcessBlocks(in + offset, chunkIv, out + offset, BLOCK_SIZE, 0);
+            cipher.AdvancedProcessBlocks(in + offset + BLOCK_SIZE, in + offset, out + offset + BLOCK_SIZE,
+                                         chunkSize - BLOCK_SIZE, CryptoPP::BlockTransformation::BT_AllowParallel);
+            return;
+        }
+
+        // in place the batches go from the end of the chunk to its start, and the blocks of a batch from its last to
+        // its first, so the cipher block before each block is still there when it is xored
+        std::array<std::uint8_t, BATCH_BLOCKS * BLOCK_SIZE> batch;
+        for (auto end = chunkSize; end > 0;)
+        {
+            auto begin = end - std::min(end, batch.size());
+            cipher.AdvancedProcessBlocks(in + offset + begin, nullptr, batch.data(), end - begin,
+                                         CryptoPP::BlockTransformation::BT_AllowParallel);
+            for (auto block = end; block > begin;)
+            {
+                block -= BLOCK_SIZE;
+                auto const *previous = block == 0 ? chunkIv : in + offset + block - BLOCK_SIZE;
+                XorKernel::xorBlocks(batch.data() + block - begin, previous, BLOCK_SIZE, out + offset + block);
+            }
+            end = begin;
+        }
+    });
+}
+
+void Aes::transformAt(std::uint64_t offset, ByteView in, std::span<std::uint8_t> out, std::size_t numThreads) const
+{
+    THROW_IF(mode_ != Mode::ctr, "random access is only possible in ctr mode", std::logic_error);
+    THROW_IF(out.size() < in.size(), "output is shorter than input", std::invalid_argument);
+
+    GeneralUtils::parallelFor(GeneralUtils::ceil(in.size(), PARALLEL_CHUNK), numThreads, [&](std::size_t chunk) {
+        auto begin = chunk * PARALLEL_CHUNK;
+        auto size = std::min(PARALLEL_CHUNK, in.size() - begin);
+        ctrTransform(offset + begin, in.data() + begin, size, out.data() + begin);
+    });
+}
+
+void Aes::ctrTransform(std::uint64_t offset, const std::uint8_t *in, std::size_t size, std::uint8_t *out) const
+{
+    auto const *nonce = iv_.secureData().data();
+
+    // encrypts whole counter blocks into out, xored with in
+    auto transformBlocks = [&](std::uint64_t counter, const std::uint8_t *blocksIn, std::size_t blocks,
+                               std::uint8_t *blocksOut) {
+        if (native_)
+        {
+            native_->transformCtr(nonce, counter, blocksIn, blocks, blocksOut);
+            return;
+        }
+
+        auto &cipher = threadCipher(encryption_);
+        std::array<std::uint8_t, BATCH_BLOCKS * BLOCK_SIZE> counterBlocks;
+        for (std::size_t done = 0; done < blocks; done += BATCH_BLOCKS)
+        {
+            auto batch = std::min(BATCH_BLOCKS, blocks - done);
+            for (std::size_t i = 0; i < batch; i++)
+            {
+                auto *counterBlock = counterBlocks.data() + i * BLOCK_SIZE;
+                std::uint64_t value = counter + done + i;
+                std::copy(nonce, nonce + CTR_NONCE_SIZE, counterBlock);
+                for (std::size_t byte = 0; byte < BLOCK_SIZE - CTR_NONCE_SIZE; byte++)
+                {
+                    counterBlock[CTR_NONCE_SIZE + byte] = static_cast<std::uint8_t>(value >> (8 * byte));
+                }
+            }
+
+            cipher.AdvancedProcessBlocks(counterBlocks.data(), blocksIn + done * BLOCK_SIZE,
+                                         blocksOut + done * BLOCK_SIZE, batch * BLOCK_SIZE,
+                                         CryptoPP::BlockTransformation::BT_AllowParallel);
+        }
+    };
+
+    // a partial first or last block is xored with the part of its keystream block it covers
+    auto transformPartial = [&](std::uint64_t counter, std::size_t skip, const std::uint8_t *partIn,
+                                std::size_t partSize, std::uint8_t *partOut) {
+        std::array<std::uint8_t, BLOCK_SIZE> block{};
+        std::copy(partIn, partIn + partSize, block.begin() + static_cast<std::ptrdiff_t>(skip));
+        transformBlocks(counter, block.data(), 1, block.data());
+        std::copy(block.begin() + static_cast<std::ptrdiff_t>(skip),
+                  block.begin() + static_cast<std::ptrdiff_t>(skip + partSize), partOut);
+    };
+
+    auto counter = offset / BLOCK_SIZE;
+    auto skip = static_cast<std::size_t>(offset % BLOCK_SIZE);
+    std::size_t done = 0;
+    if (skip != 0)
+    {
+        done = std::min(size, BLOCK_SIZE - skip);
+        transformPartial(counter++, skip, in, done, out);
+    }
+
+    auto blocks = (size - done) / BLOCK_SIZE;
+    transformBlocks(counter, in + done, blocks, out + done);
+    counter += blocks;
+    done += blocks * BLOCK_SIZE;
+
+    if (done < size)
+    {
+        transformPartial(counter, 0, in + done, size - done, out + done);
+    }
+}
@@ -2,9 +2,18 @@
 #define MATASANO_AES_H
 
 #include "byte_data.h"
+#include "byte_view.h"
+#include "matasano_asserts.h"
 #include <coroutine>
+#include <cryptopp/aes.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 
+class AesNiKernel;
+
 /**
  * @brief Aes encryption services
  */
@@ -17,7 +26,8 @@ public:
     enum class Mode
     {
         ecb, // ECB mode
-        cbc  // CBC mode
+        cbc, // CBC mode
+        ctr  // CTR mode, the counter block is the 8 byte nonce followed by the 64 bit little endian block counter
     };
 
     /**
@@ -29,44 +39,222 @@ public:
         bit128, // 16 byte key size
     };
 
+    /**
+     * @brief implementation of the block cipher
+     */
+    enum class Backend
+    {
+        automatic, // AES-NI if the CPU supports it, otherwise CryptoPP
+        aesNi,     // native AES-NI kernel (@see AesNiKernel), interleaves many blocks in flight
+        cryptoPp   // CryptoPP block cipher
+    };
+
+    /**
+     * @brief padding of the last block in ECB / CBC mode. CTR never pads
+     */
+    enum class Padding
+    {
+        pkcs7, // PKCS#7 (@see Padder), a whole block of padding is added to data that is whole blocks
+        none   // no padding, the data should be whole blocks
+    };
+
     /**
      * @brief Construct a new Aes object
      *
      * @param key Key to use for encryption / decryption
-     * @param iv IV , empty by default
+     * @param iv IV , empty by default. For ctr it is the 8 byte nonce
      * @param mode encryption / decryption mode
      * @param keySize encryption / decryption key size
+     * @param backend implementation of the block cipher, the output does not depend on it
      *
      * @throw std::invalid_argument on invalid mode or KeySize or invalid iv for the mode where it is requred or if
-     * KeySize is not equal to provided key size
+     * KeySize is not equal to provided key size, or if the backend is AES-NI and the CPU does not support it
      */
-    Aes(const ByteData &key, const ByteData &iv, Mode mode = Mode::cbc, KeySize keySize = KeySize::bit128);
+    Aes(const ByteData &key, const ByteData &iv, Mode mode = Mode::cbc, KeySize keySize = KeySize::bit128,
+        Backend backend = Backend::automatic);
 
     /**
      * @brief Encrypts the given plain data
      *
      * @param plain plain data
-     * @return resulting encrypted data
+     * @param numThreads number of threads, 0 for the number of hardware threads. ECB splits large data into chunks of
+     * PARALLEL_CHUNK bytes that are encrypted in parallel, CBC encryption is chained and always runs in one thread, CTR
+     * is parallel like transformAt. The result does not depend on it
+     * @return resulting encrypted data, padded to whole blocks except in CTR mode where it is as long as plain
      *
      * @throw std::invalid_argument if plain is empty
      */
-    ByteData encrypt(const ByteData &plain) const;
+    ByteData encrypt(const ByteData &plain, std::size_t numThreads = 1) const;
 
     /**
      * @brief Decrypts the gived ciphered data
      *
      * @param cipher ciphered data
+     * @param numThreads number of threads, 0 for the number of hardware threads. Large data is split into chunks of
+     * PARALLEL_CHUNK bytes that are decrypted in parallel in both modes (a CBC block depends only on itself and on the
+     * cipher block before it), only the last block is unpadded. The result does not depend on it
      * @return plain data
      *
-     * @throw std::invalid_argument if cipher is empty
+     * @throw std::invalid_argument if cipher is empty, or in ECB / CBC mode is not whole blocks or its padding is wrong
+     */
+    ByteData decrypt(const ByteData &cipher, std::size_t numThreads = 1) const;
+
+    /**
+     * @brief the size of the encryption of plainSize bytes
+     *
+     * @param plainSize number of plain bytes
+     * @param padding padding of the last block, ignored in CTR mode
+     * @return the number of bytes encrypt writes
+     * @throw std::invalid_argument if padding is none and plainSize is not whole blocks in ECB / CBC mode
+     */
+    std::size_t cipherSize(std::size_t plainSize, Padding padding = Padding::pkcs7) const;
+
+    /**
+     * @brief Encrypts into a buffer the caller owns, without any heap allocation. The whole blocks go straight from
+     * plain to out, the padded last block is built on the stack
+     *
+     * @param plain plain data, may be empty
+     * @param out output buffer, at least cipherSize(plain.size(), padding) bytes. May be the same memory as plain (the
+     * padding is written after it), but should not partially overlap with it
+     * @param padding padding of the last block, ignored in CTR mode
+     * @param numThreads number of threads, 0 for the number of hardware threads (@see encrypt)
+     * @return the number of bytes written, cipherSize(plain.size(), padding)
+     *
+     * @throw std::invalid_argument if out is too short, or padding is none and plain is not whole blocks in ECB / CBC
+     * mode
+     */
+    std::size_t encrypt(ByteView plain, std::span<std::uint8_t> out, Padding padding = Padding::pkcs7,
+                        std::size_t numThreads = 1) const;
+
+    /**
+     * @brief Decrypts into a buffer the caller owns, without any heap allocation (except for in place CBC decryption
+     * of more than PARALLEL_CHUNK bytes, that saves the cipher block before every chunk). The padded last block is
+     * decrypted first, so nothing is written if the padding is wrong
+     *
+     * @param cipher ciphered data
+     * @param out output buffer, at least as long as the plain data. May be the same memory as cipher, but should not
+     * partially overlap with it
+     * @param padding padding of the last block, ignored in CTR mode
+     * @param numThreads number of threads, 0 for the number of hardware threads (@see decrypt)
+     * @return the number of bytes written, the size of the plain data
+     *
+     * @throw std::invalid_argument if out is too short, or in ECB / CBC mode cipher is not whole blocks, is empty while
+     * padding is pkcs7 or its padding is wrong
+     */
+    std::size_t decrypt(ByteView cipher, std::span<std::uint8_t> out, Padding padding = Padding::pkcs7,
+                        std::size_t numThreads = 1) const;
+
+    /**
+     * @brief Encrypts in place (@see encrypt)
+     *
+     * @param buffer the plain data followed by room for the padding, at least cipherSize(plainSize, padding) bytes
+     * @param plainSize number of plain bytes at the start of buffer
+     * @param padding padding of the last block, ignored in CTR mode
+     * @param numThreads number of threads, 0 for the number of hardware threads
+     * @return the number of bytes of the cipher at the start of buffer
+     */
+    inline std::size_t encryptInPlace(std::span<std::uint8_t> buffer, std::size_t plainSize,
+                                      Padding padding = Padding::pkcs7, std::size_t numThreads = 1) const
+    {
+        THROW_IF(plainSize > buffer.size(), "plain size is more than the buffer", std::invalid_argument);
+        return encrypt(ByteView(buffer.data(), plainSize), buffer, padding, numThreads);
+    }
+
+    /**
+     * @brief Decrypts in place (@see decrypt)
+     *
+     * @param data the cipher, overwritten with the plain data
+     * @param padding padding of the last block, ignored in CTR mode
+     * @param numThreads number of threads, 0 for the number of hardware threads
+     * @return the number of bytes of the plain data at the start of data
+     */
+    inline std::size_t decryptInPlace(std::span<std::uint8_t> data, Padding padding = Padding::pkcs7,
+                                      std::size_t numThreads = 1) const
+    {
+        return decrypt(ByteView(data), data, padding, numThreads);
+    }
+
+    /**
+     * @brief CTR mode encryption / decryption (they are the same) of a range of the data without processing what comes
+     * before it: in is xored with the keystream starting at byte offset of the whole data. The keystream is generated
+     * in batches of many blocks, and large ranges are split into chunks of PARALLEL_CHUNK bytes spread over threads
+     *
+     * @param offset position of in in the whole data
+     * @param in the range of the data
+     * @param out output buffer, at least as long as in (may be the same memory as in)
+     * @param numThreads number of threads, 0 for the number of hardware threads. The result does not depend on it
+     *
+     * @throw std::logic_error if the mode is not ctr
+     * @throw std::invalid_argument if out is shorter than in
+     */
+    void transformAt(std::uint64_t offset, ByteView in, std::span<std::uint8_t> out, std::size_t numThreads = 1) const;
+
+    /**
+     * @brief same as transformAt, in place
+     */
+    inline void transformAt(std::uint64_t offset, std::span<std::uint8_t> data, std::size_t numThreads = 1) const
+    {
+        transformAt(offset, ByteView(data), data, numThreads);
+    }
+
+    /**
+     * @brief Encrypts / decrypts whole blocks in ECB or CBC mode without padding, chaining from the given iv instead
+     * of the one of this object. Lets data that comes in pieces carry the CBC chaining value from a piece to the next
+     *
+     * @param iv the cipher block before the first one, a whole block in CBC mode, ignored in ECB mode
+     * @param in whole blocks
+     * @param out output buffer, at least as long as in (may be the same memory as in)
+     * @param encrypt if true - encrypt, otherwise decrypt
+     * @param numThreads number of threads, 0 for the number of hardware threads (@see encrypt, decrypt)
+     *
+     * @throw std::logic_error if the mode is ctr
+     * @throw std::invalid_argument if in is not whole blocks, out is shorter than in or the iv is not a block in CBC
+     * mode
+     */
+    void encryptDecryptBlocks(ByteView iv, ByteView in, std::span<std::uint8_t> out, bool encrypt,
+                              std::size_t numThreads = 1) const;
+
+    /**
+     * @brief the mode of operation
+     */
+    inline Mode mode() const { return mode_; }
+
+    /**
+     * @brief the iv, for ctr the nonce
+     */
+    inline const ByteData &iv() const { return iv_; }
+
+    /**
+     * @brief number of bytes processed by one task of the parallel modes, a multiple of the block size
+     */
+    static constexpr std::size_t PARALLEL_CHUNK = 256 * 1024;
+
+    /**
+     * @brief the implementation of the block cipher this object uses (never Backend::automatic)
      */
-    ByteData decrypt(const ByteData &cipher) const;
+    inline Backend backend() const { return native_ ? Backend::aesNi : Backend::cryptoPp; }
 
 private:
     /**
-     * @brief encryption key
+     * @brief native AES-NI key schedule, built once on construction and shared between copies. Null if CryptoPP is used
+     */
+    std::shared_ptr<const AesNiKernel> native_;
+
+    /**
+     * @brief expanded encryption key schedule, built once on construction and shared between copies. Null if the
+     * native kernel is used. CryptoPP ciphers keep scratch space in the object, so it is never used directly: every
+     * thread works on its own copy, which copies the schedule without expanding the key again
+     * @note the copy is kept thread_local and reused while the thread works with the same Aes object, so it is
+     * allocated once per thread and key, not per chunk. The parallel modes start new worker threads on every call, so
+     * each of them still makes one copy per call, only the calling thread keeps its copy between calls
      */
-    ByteData key_;
+    std::shared_ptr<const CryptoPP::AES::Encryption> encryption_;
+
+    /**
+     * @brief expanded decryption key schedule, built once on construction and shared between copies. Null if the
+     * native kernel is used. Used through a copy per thread, the same way as encryption_
+     */
+    std::shared_ptr<const CryptoPP::AES::Decryption> decryption_;
 
     /**
      * @brief iv
@@ -88,38 +276,62 @@ private:
      *
      * @param data data to encrypt / decrypt
      * @param encrypt if true encrypt, otherwise decrypt
+     * @param numThreads number of threads
      * @return resulting encrypted data
      *
      * @throw std::invalid_argument if plain is empty
      */
-    ByteData encryptDecrypt(const ByteData &data, bool encrypt) const;
+    ByteData encryptDecrypt(const ByteData &data, bool encrypt, std::size_t numThreads) const;
 
     /**
-     * @brief Encrypts / Decrypts a single data that is multiple of blocks size
+     * @brief Encrypts / Decrypts whole blocks in the mode of this object, ECB or CBC
      *
-     * @param block data that is multiple of block size
+     * @param iv the cipher block before the first one, CBC only
+     * @param in data that is multiple of block size
+     * @param size number of bytes in data
+     * @param out output buffer of size bytes, may be the same memory as in
      * @param encrypt if true - encrypt, otherwise decrypt
-     * @return the encrypted / decrypted data
+     * @param numThreads number of threads
      */
-    ByteData ecbEncryptDecryptBlock(const ByteData &block, bool encrypt) const;
+    void encryptDecryptBlocks(const std::uint8_t *iv, const std::uint8_t *in, std::size_t size, std::uint8_t *out,
+                              bool encrypt, std::size_t numThreads) const;
 
     /**
-     * @brief Perform ecb encryption / decryption on a given data
+     * @brief Encrypts / Decrypts whole blocks in ECB mode, in chunks of PARALLEL_CHUNK bytes spread over threads.
+     * Each chunk is a single call to the backend
      *
-     * @param data data to encrypt / decrypt
+     * @param in data that is multiple of block size
+     * @param size number of bytes in data
+     * @param out output buffer of size bytes, may be the same memory as in
      * @param encrypt if true - encrypt, otherwise decrypt
-     * @return encrypted data
+     * @param numThreads number of threads
      */
-    ByteData encryptDecryptEcb(const ByteData &data, bool encrypt) const;
+    void ecbEncryptDecryptBlocks(const std::uint8_t *in, std::size_t size, std::uint8_t *out, bool encrypt,
+                                 std::size_t numThreads) const;
 
     /**
-     * @brief Perform cbc encryption / decryption on a given data
+     * @brief Encrypts / Decrypts whole blocks in CBC mode. Decryption is done in chunks of PARALLEL_CHUNK bytes spread
+     * over threads, the iv of each chunk is the last cipher block of the chunk before it
      *
-     * @param data data to encrypt / decrypt
+     * @param iv the cipher block before the first one
+     * @param in data that is multiple of block size
+     * @param size number of bytes in data
+     * @param out output buffer of size bytes, may be the same memory as in
      * @param encrypt if true - encrypt, otherwise decrypt
-     * @return encrypted data
+     * @param numThreads number of threads, decryption only
+     */
+    void cbcEncryptDecryptBlocks(const std::uint8_t *iv, const std::uint8_t *in, std::size_t size, std::uint8_t *out,
+                                 bool encrypt, std::size_t numThreads) const;
+
+    /**
+     * @brief CTR mode encryption / decryption of a range of the data in one thread (@see transformAt)
+     *
+     * @param offset position of in in the whole data
+     * @param in the range of the data
+     * @param size number of bytes in the range
+     * @param out output buffer of size bytes, may be the same memory as in
      */
-    ByteData encryptDecryptCbc(const ByteData &data, bool encrypt) const;
+    void ctrTransform(std::uint64_t offset, const std::uint8_t *in, std::size_t size, std::uint8_t *out) const;
 };
 
 #endif
\ No newline at end of file
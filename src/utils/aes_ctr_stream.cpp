@@ -0,0 +1,21 @@
+#include "aes_ctr_stream.h"
+#include "matasano_asserts.h"
+
+#include <span>
+#include <stdexcept>
+
+AesCtrStream::AesCtrStream(const Aes &aes, std::size_t numThreads) : aes_(aes), numThreads_(numThreads)
+{
+    THROW_IF(aes_.mode() != Aes::Mode::ctr, "aes should be in ctr mode", std::invalid_argument);
+}
+
+void AesCtrStream::process(const std::uint8_t *in, std::size_t size, std::uint8_t *out)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    aes_.transformAt(position_, ByteView(in, size), std::span<std::uint8_t>(out, size), numThreads_);
+    position_ += size;
+}
@@ -0,0 +1,72 @@
+#ifndef MATASANO_AES_CTR_STREAM_H
+#define MATASANO_AES_CTR_STREAM_H
+
+#include "aes.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief AES-CTR applied to data that comes in chunks of any size. The position in the keystream carries over from one
+ * chunk to the next, so processing the chunks one after another gives the same result as encrypting all of the data at
+ * once, and seek jumps anywhere in the data without generating the keystream before it. Nothing is allocated per chunk
+ */
+class AesCtrStream
+{
+public:
+    /**
+     * @brief Construct a new Aes Ctr Stream object
+     *
+     * @param aes the cipher, should be in ctr mode
+     * @param numThreads number of threads large chunks are processed with, 0 for the number of hardware threads
+     * @throw std::invalid_argument if aes is not in ctr mode
+     */
+    explicit AesCtrStream(const Aes &aes, std::size_t numThreads = 1);
+
+    /**
+     * @brief encrypts / decrypts the next chunk of the data
+     *
+     * @param in the chunk
+     * @param size number of bytes in the chunk
+     * @param out output buffer, should have room for size bytes (may be the same memory as in, but should not
+     * partially overlap with it)
+     */
+    void process(const std::uint8_t *in, std::size_t size, std::uint8_t *out);
+
+    /**
+     * @brief encrypts / decrypts the next chunk of the data in place
+     *
+     * @param data the chunk
+     * @param size number of bytes in the chunk
+     */
+    inline void process(std::uint8_t *data, std::size_t size) { process(data, size, data); }
+
+    /**
+     * @brief moves to a position in the data, the next chunk is processed as if it starts there
+     *
+     * @param position byte offset from the start of the data
+     */
+    inline void seek(std::uint64_t position) { position_ = position; }
+
+    /**
+     * @brief byte offset of the next chunk from the start of the data
+     */
+    inline std::uint64_t position() const { return position_; }
+
+private:
+    /**
+     * the cipher, its key schedule is shared with the Aes it was copied from
+     */
+    Aes aes_;
+
+    /**
+     * number of threads large chunks are processed with
+     */
+    std::size_t numThreads_;
+
+    /**
+     * byte offset of the next chunk from the start of the data
+     */
+    std::uint64_t position_ = 0;
+};
+
+#endif
@@ -4,16 +4,30 @@
 #include "matasano_asserts.h"
 #include "padder.h"
 
+#include <array>
 #include <functional>
 
-std::optional<std::size_t> AesEcbOracle::detectEqualBlockNumAfterEncryption(ByteData &plain, std::size_t blockSize)
+ByteView AesEcbOracle::encrypt(ByteView plain)
 {
-    auto encrypted = encryptor_(plain);
+    auto &cipher = cipherScratch_.secureData();
 
-    auto blocks = encrypted.extractRows(blockSize);
-    for (std::size_t i = 0; i < blocks.size() - 1; i++)
+    std::size_t size = 0;
+    while ((size = encryptor_(plain, cipher)) > cipher.size())
     {
-        if (blocks.at(i) == blocks.at(i + 1))
+        // only grows, so after the first few calls the buffer fits every cipher
+        cipher.resize(size);
+    }
+
+    return ByteView(cipher.data(), size);
+}
+
+std::optional<std::size_t> AesEcbOracle::detectEqualBlockNumAfterEncryption(ByteView plain, std::size_t blockSize)
+{
+    auto encrypted = encrypt(plain);
+
+    for (std::size_t i = 0; (i + 2) * blockSize <= encrypted.size(); i++)
+    {
+        if (encrypted.subView(i * blockSize, blockSize) == encrypted.subView((i + 1) * blockSize, blockSize))
         {
             return i;
         }
@@ -67,10 +81,11 @@ AesEcbOracle::OffsetToAddToLookForSecret AesEcbOracle::guessPlainOffset()
     auto blockSize = guessBlockSize();
     LOGIC_ASSERT(blockSize);
 
-    ByteData plain(0, std::size_t{*blockSize * 2});
+    ByteData plain(0, std::size_t{*blockSize * 3});
     for (std::size_t numOfAdditionalBytes = 0; numOfAdditionalBytes < *blockSize; numOfAdditionalBytes++)
     {
-        auto equalBlockNum = detectEqualBlockNumAfterEncryption(plain, *blockSize);
+        auto equalBlockNum =
+            detectEqualBlockNumAfterEncryption(plain.subView(0, *blockSize * 2 + numOfAdditionalBytes), *blockSize);
         if (equalBlockNum)
         {
             AesEcbOracle::OffsetToAddToLookForSecret res{*equalBlockNum, numOfAdditionalBytes};
@@ -78,8 +93,6 @@ AesEcbOracle::OffsetToAddToLookForSecret AesEcbOracle::guessPlainOffset()
 
             return res;
         }
-
-        plain += 0;
     }
 
     LOGIC_SHOULD_NOT_REACH_THAT_POINT();
@@ -92,7 +105,7 @@ ByteData AesEcbOracle::recoverSecret()
 
     auto offset = guessPlainOffset();
 
-    auto encryptedJustBytesOffset = encryptor_(ByteData(0, std::size_t{offset.inBytes}));
+    auto encryptedJustBytesOffset = encrypt(ByteData(0, std::size_t{offset.inBytes}));
     LOGIC_ASSERT(encryptedJustBytesOffset.size() % CryptoConstants::BLOCK_SIZE_BYTES == 0);
 
     auto numOfBlocks = encryptedJustBytesOffset.size() / CryptoConstants::BLOCK_SIZE_BYTES;
@@ -118,7 +131,7 @@ ByteData AesEcbOracle::recoverSecretBlock(const ByteData &prevBlockPlain, std::s
     std::size_t i = 1;
     do
     {
-        auto curBlockWithoutFirstNBytes = prevBlockPlain.subData(i, uknownPartSize - 1);
+        auto curBlockWithoutFirstNBytes = prevBlockPlain.subView(i, uknownPartSize - 1);
         auto guessedByte =
             guessNthByteInNextBlock(curBlockWithoutFirstNBytes, partOfNextBlockGuessedSoFar, blockNum, offset);
         if (!guessedByte)
@@ -136,29 +149,40 @@ ByteData AesEcbOracle::recoverSecretBlock(const ByteData &prevBlockPlain, std::s
 }
 
 std::optional<std::uint8_t>
-AesEcbOracle::guessNthByteInNextBlock(const ByteData &curBlockWithoutFirstNBytes,
-                                      const ByteData &partOfNextBlockGuessedSoFar, size_t blockNum,
-                                      const AesEcbOracle::OffsetToAddToLookForSecret &offset)
+AesEcbOracle::guessNthByteInNextBlock(ByteView curBlockWithoutFirstNBytes, ByteView partOfNextBlockGuessedSoFar,
+                                      size_t blockNum, const AesEcbOracle::OffsetToAddToLookForSecret &offset)
 {
     LOGIC_ASSERT(curBlockWithoutFirstNBytes.size() + partOfNextBlockGuessedSoFar.size() ==
                  CryptoConstants::BLOCK_SIZE_BYTES - 1);
 
-    ByteData offsetBytesPrepend(0, std::size_t{offset.inBytes});
+    // the offset bytes and the known bytes are written into the scratch once, only the guessed last byte changes below
+    auto &plain = plainScratch_.secureData();
+    plain.assign(offset.inBytes, 0);
+    plain.insert(plain.end(), curBlockWithoutFirstNBytes.begin(), curBlockWithoutFirstNBytes.end());
 
-    auto encryptedFirstNBytesOfSecret = encryptor_(offsetBytesPrepend + curBlockWithoutFirstNBytes)
-                                            .extractRow(CryptoConstants::BLOCK_SIZE_BYTES, blockNum + offset.inBlocks);
-    LOGIC_ASSERT(encryptedFirstNBytesOfSecret.size() != 0);
+    auto encryptedWithFirstNBytesOfSecret = encrypt(ByteView(plain.data(), plain.size()));
+    auto targetBlockStart = CryptoConstants::BLOCK_SIZE_BYTES * (blockNum + offset.inBlocks);
+    LOGIC_ASSERT(encryptedWithFirstNBytesOfSecret.size() >= targetBlockStart + CryptoConstants::BLOCK_SIZE_BYTES);
 
-    std::uint8_t curByte = 0;
-    auto curBlockWithoutLastByte = curBlockWithoutFirstNBytes + partOfNextBlockGuessedSoFar;
+    // copied out, the cipher scratch is overwritten by the guesses
+    std::array<std::uint8_t, CryptoConstants::BLOCK_SIZE_BYTES> encryptedFirstNBytesOfSecret;
+    auto targetBlock = encryptedWithFirstNBytesOfSecret.subView(targetBlockStart, CryptoConstants::BLOCK_SIZE_BYTES);
+    std::copy(targetBlock.begin(), targetBlock.end(), encryptedFirstNBytesOfSecret.begin());
+
+    plain.insert(plain.end(), partOfNextBlockGuessedSoFar.begin(), partOfNextBlockGuessedSoFar.end());
+    plain.push_back(0);
 
+    std::uint8_t curByte = 0;
     do
     {
-        auto bytePermutation = encryptor_(offsetBytesPrepend + curBlockWithoutLastByte + curByte)
-                                   .extractRow(CryptoConstants::BLOCK_SIZE_BYTES, offset.inBlocks);
-        LOGIC_ASSERT(bytePermutation.size() != 0);
-
-        if (encryptedFirstNBytesOfSecret == bytePermutation)
+        plain.back() = curByte;
+        auto encryptedPermutation = encrypt(ByteView(plain.data(), plain.size()));
+        LOGIC_ASSERT(encryptedPermutation.size() >= CryptoConstants::BLOCK_SIZE_BYTES * (offset.inBlocks + 1));
+        auto bytePermutation =
+            encryptedPermutation.subView(CryptoConstants::BLOCK_SIZE_BYTES * offset.inBlocks,
+                                         CryptoConstants::BLOCK_SIZE_BYTES);
+
+        if (ByteView(encryptedFirstNBytesOfSecret) == bytePermutation)
         {
             return curByte;
         }
@@ -167,4 +191,4 @@ AesEcbOracle::guessNthByteInNextBlock(const ByteData &curBlockWithoutFirstNBytes
     // if we reached this point and were not able to guess, it means we reached the padding part which changes
     // depending the number of the bytes missing till the end of the block, we need to stop
     return {};
-}
\ No newline at end of file
+}
@@ -3,8 +3,10 @@
 
 #include <functional>
 #include <map>
+#include <span>
 
 #include "byte_data.h"
+#include "byte_view.h"
 
 /**
  * @brief various Ecb decryption services that receive some encryptor function that encrypts data with unknown secret
@@ -40,9 +42,12 @@ public:
 
     /**
      * @brief encryptorFunction type
-     * Receives plain ByteData, returns encrypted ByteData according to the EcryptorType
+     * Receives plain bytes and an output buffer owned by the oracle, encrypts according to the EcryptorType into the
+     * buffer and returns the number of bytes written. If the buffer is too short, nothing should be written and the
+     * required size returned instead, the oracle grows its buffer and calls again. The oracle reuses one buffer for all
+     * of its calls, so the encryptor does not have to allocate anything
      */
-    using encryptorFunction = std::function<ByteData(const ByteData &plain)>;
+    using encryptorFunction = std::function<std::size_t(ByteView plain, std::span<std::uint8_t> out)>;
 
     AesEcbOracle(encryptorFunction encryptor, EncryptorType encryptorType)
         : encryptor_(encryptor), encryptorType_(encryptorType)
@@ -83,6 +88,20 @@ private:
     encryptorFunction encryptor_;
     EncryptorType encryptorType_;
 
+    /**
+     * @brief scratch buffers reused by all the encryptor calls, so guessing a byte does not allocate
+     */
+    ByteData plainScratch_;
+    ByteData cipherScratch_;
+
+    /**
+     * @brief calls the encryptor function, growing cipherScratch_ if it is too short
+     *
+     * @param plain the plain data
+     * @return view of the cipher in cipherScratch_, valid until the next call
+     */
+    ByteView encrypt(ByteView plain);
+
     /**
      * @brief Represents an offset that should be added each time when looking for secret data (in blocks and bytes)
      * @note this is not the same as the actual offset of secret data
@@ -122,7 +141,7 @@ private:
      * @return std::optional<std::size_t> if 2 repeaping subsequent blocks are detected, return the number of the first
      * one
      */
-    std::optional<std::size_t> detectEqualBlockNumAfterEncryption(ByteData &plain, std::size_t blockSize);
+    std::optional<std::size_t> detectEqualBlockNumAfterEncryption(ByteView plain, std::size_t blockSize);
 
     /**
      * @brief Guesses the block size of the encryptorFunction
@@ -156,8 +175,8 @@ private:
      * @return Nth byte in the original secret text or nothing (this means we reached padding and previous guessed byte
      * is also irrelevant)
      */
-    std::optional<std::uint8_t> guessNthByteInNextBlock(const ByteData &curBlockWithoutFirstNBytes,
-                                                        const ByteData &partOfNextBlockGuessedSoFar, size_t blockNum,
+    std::optional<std::uint8_t> guessNthByteInNextBlock(ByteView curBlockWithoutFirstNBytes,
+                                                        ByteView partOfNextBlockGuessedSoFar, size_t blockNum,
                                                         const AesEcbOracle::OffsetToAddToLookForSecret &offset);
 };
 
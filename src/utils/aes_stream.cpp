@@ -0,0 +1,173 @@
+#include "aes_stream.h"
+#include "internal/stream_buffer.h"
+#include "matasano_asserts.h"
+#include "padder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+constexpr std::size_t BLOCK_SIZE = CryptoConstants::BLOCK_SIZE_BYTES;
+} // namespace
+
+AesStream::AesStream(const Aes &aes, Direction direction, Aes::Padding padding, std::size_t numThreads)
+    : aes_(aes), direction_(direction), padding_(padding), numThreads_(numThreads)
+{
+    reset();
+}
+
+void AesStream::reset()
+{
+    if (aes_.mode() == Aes::Mode::cbc)
+    {
+        std::copy_n(aes_.iv().secureData().begin(), BLOCK_SIZE, chain_.begin());
+    }
+
+    // the pending block may hold plain text, don't leave it behind
+    std::fill_n(static_cast<volatile std::uint8_t *>(pending_.data()), BLOCK_SIZE, 0);
+    pendingSize_ = 0;
+    position_ = 0;
+}
+
+void AesStream::processBlocks(const std::uint8_t *in, std::size_t size, std::uint8_t *out)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (direction_ == Direction::encrypt)
+    {
+        aes_.encryptDecryptBlocks(ByteView(chain_), ByteView(in, size), std::span(out, size), true, numThreads_);
+        std::copy_n(out + size - BLOCK_SIZE, BLOCK_SIZE, chain_.begin());
+        return;
+    }
+
+    // the last cipher block is taken before the blocks are decrypted, in may be the same memory as out
+    std::array<std::uint8_t, BLOCK_SIZE> lastCipher{};
+    std::copy_n(in + size - BLOCK_SIZE, BLOCK_SIZE, lastCipher.begin());
+    aes_.encryptDecryptBlocks(ByteView(chain_), ByteView(in, size), std::span(out, size), false, numThreads_);
+    chain_ = lastCipher;
+}
+
+std::size_t AesStream::update(ByteView in, std::span<std::uint8_t> out)
+{
+    if (aes_.mode() == Aes::Mode::ctr)
+    {
+        aes_.transformAt(position_, in, out, numThreads_);
+        position_ += in.size();
+        return in.size();
+    }
+
+    // whole blocks are written, but a padded decryption keeps its last block until finalize
+    auto total = pendingSize_ + in.size();
+    auto size = total - total % BLOCK_SIZE;
+    if (direction_ == Direction::decrypt && padding_ == Aes::Padding::pkcs7 && size == total && size != 0)
+    {
+        size -= BLOCK_SIZE;
+    }
+    THROW_IF(out.size() < size, "output is shorter than the processed data", std::invalid_argument);
+
+    std::size_t used = 0;
+    std::size_t written = 0;
+    if (size != 0 && pendingSize_ != 0)
+    {
+        used = BLOCK_SIZE - pendingSize_;
+        std::copy_n(in.data(), used, pending_.begin() + static_cast<std::ptrdiff_t>(pendingSize_));
+        processBlocks(pending_.data(), BLOCK_SIZE, out.data());
+        written = BLOCK_SIZE;
+        pendingSize_ = 0;
+    }
+
+    processBlocks(in.data() + used, size - written, out.data() + written);
+    used += size - written;
+
+    std::copy(in.begin() + static_cast<std::ptrdiff_t>(used), in.end(),
+              pending_.begin() + static_cast<std::ptrdiff_t>(pendingSize_));
+    pendingSize_ += in.size() - used;
+
+    return size;
+}
+
+std::size_t AesStream::finalize(std::span<std::uint8_t> out)
+{
+    if (aes_.mode() == Aes::Mode::ctr)
+    {
+        reset();
+        return 0;
+    }
+
+    if (padding_ == Aes::Padding::none)
+    {
+        THROW_IF(pendingSize_ != 0, "data without padding should be whole blocks", std::invalid_argument);
+        reset();
+        return 0;
+    }
+
+    THROW_IF(out.size() < BLOCK_SIZE, "output is shorter than a block", std::invalid_argument);
+
+    if (direction_ == Direction::encrypt)
+    {
+        std::fill(pending_.begin() + static_cast<std::ptrdiff_t>(pendingSize_), pending_.end(),
+                  static_cast<std::uint8_t>(BLOCK_SIZE - pendingSize_));
+        processBlocks(pending_.data(), BLOCK_SIZE, out.data());
+        reset();
+        return BLOCK_SIZE;
+    }
+
+    THROW_IF(pendingSize_ != BLOCK_SIZE, "ciphered data should be whole blocks and can't be empty",
+             std::invalid_argument);
+
+    // unpadded in place, so a wrong padding leaves nothing in out. The decrypted block is wiped and the stream starts
+    // over either way
+    processBlocks(pending_.data(), BLOCK_SIZE, pending_.data());
+    std::size_t size = 0;
+    try
+    {
+        size = BLOCK_SIZE - Padder::paddingSize(ByteView(pending_.data(), BLOCK_SIZE));
+    }
+    catch (...)
+    {
+        reset();
+        throw;
+    }
+    std::copy_n(pending_.begin(), size, out.begin());
+    reset();
+
+    return size;
+}
+
+std::size_t AesStream::process(std::istream &in, std::ostream &out)
+{
+    // the buffers hold the plain text, they are wiped and the exceptions of out restored however this ends
+    StreamBuffer inBuffer(STREAM_BUFFER_SIZE);
+    StreamBuffer outBuffer(STREAM_BUFFER_SIZE + BLOCK_SIZE);
+    StreamExceptionsGuard outExceptions(out, std::ios_base::failbit | std::ios_base::badbit);
+    std::size_t total = 0;
+
+    auto write = [&](std::size_t count) {
+        out.write(outBuffer.chars(), static_cast<std::streamsize>(count));
+        total += count;
+    };
+
+    try
+    {
+        while (in)
+        {
+            in.read(inBuffer.chars(), static_cast<std::streamsize>(inBuffer.size()));
+            auto count = static_cast<std::size_t>(in.gcount());
+
+            write(update(ByteView(inBuffer.bytes(), count), std::span(outBuffer.bytes(), outBuffer.size())));
+        }
+        write(finalize(std::span(outBuffer.bytes(), BLOCK_SIZE)));
+    }
+    catch (...)
+    {
+        // a partial block of this data must not leak into the next one
+        reset();
+        throw;
+    }
+
+    return total;
+}
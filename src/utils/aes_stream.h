@@ -0,0 +1,140 @@
+#ifndef MATASANO_AES_STREAM_H
+#define MATASANO_AES_STREAM_H
+
+#include "aes.h"
+#include "byte_view.h"
+#include "crypto_constants.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <span>
+
+/**
+ * @brief Incremental Aes encryption / decryption of data that comes in chunks of any size, in constant memory. The
+ * CBC chaining value, the CTR position and a partial block carry over from one update to the next, so updating with the
+ * chunks one after another and then finalizing gives the same result as Aes::encrypt / Aes::decrypt of all of the data
+ * at once. PKCS#7 padding is added only by finalize, and decryption holds the last block back until finalize, where it
+ * is unpadded. Nothing is allocated per chunk
+ */
+class AesStream
+{
+public:
+    /**
+     * @brief whether the stream encrypts or decrypts
+     */
+    enum class Direction
+    {
+        encrypt, // plain in, cipher out
+        decrypt  // cipher in, plain out
+    };
+
+    /**
+     * @brief Construct a new Aes Stream object
+     *
+     * @param aes the cipher, its mode and iv are used (the key schedule is shared with it)
+     * @param direction encrypt or decrypt
+     * @param padding padding of the last block, ignored in CTR mode
+     * @param numThreads number of threads large chunks are processed with, 0 for the number of hardware threads
+     */
+    AesStream(const Aes &aes, Direction direction, Aes::Padding padding = Aes::Padding::pkcs7,
+              std::size_t numThreads = 1);
+
+    /**
+     * @brief processes the next chunk of the data. Whole blocks are written as soon as they are complete (a partial
+     * block waits for the next chunk), except that decryption with padding keeps the last block until finalize
+     *
+     * @param in the chunk
+     * @param out output buffer, in.size() + CryptoConstants::BLOCK_SIZE_BYTES bytes are always enough. Should not
+     * overlap with in
+     * @return the number of bytes written
+     * @throw std::invalid_argument if out is too short
+     */
+    std::size_t update(ByteView in, std::span<std::uint8_t> out);
+
+    /**
+     * @brief ends the data: encryption pads and writes the last block, decryption unpads the last block and writes
+     * what is left of it. The stream then starts over from the iv, ready for new data
+     *
+     * @param out output buffer, a block (CryptoConstants::BLOCK_SIZE_BYTES) is always enough
+     * @return the number of bytes written
+     * @throw std::invalid_argument if out is too short, or in ECB / CBC mode the data is not whole blocks where it
+     * should be, the cipher is empty or its padding is wrong
+     */
+    std::size_t finalize(std::span<std::uint8_t> out);
+
+    /**
+     * @brief processes everything that is left in a stream into another stream and finalizes, through fixed size
+     * buffers, so the data may be larger than the memory
+     *
+     * @param in the stream to read
+     * @param out the stream to write
+     * @return number of bytes written
+     * @throw std::ios_base::failure if writing fails
+     * @throw std::invalid_argument like finalize
+     */
+    std::size_t process(std::istream &in, std::ostream &out);
+
+private:
+    /**
+     * size of the buffer the stream version reads into, enough parallel chunks to keep the threads busy
+     */
+    static constexpr std::size_t STREAM_BUFFER_SIZE = 16 * Aes::PARALLEL_CHUNK;
+
+    /**
+     * @brief encrypts / decrypts whole blocks chaining from chain_, and moves chain_ to the last cipher block
+     *
+     * @param in the blocks
+     * @param size number of bytes, whole blocks
+     * @param out output buffer of size bytes
+     */
+    void processBlocks(const std::uint8_t *in, std::size_t size, std::uint8_t *out);
+
+    /**
+     * @brief goes back to the initial state
+     */
+    void reset();
+
+    /**
+     * the cipher, its key schedule is shared with the Aes it was copied from
+     */
+    Aes aes_;
+
+    /**
+     * encrypt or decrypt
+     */
+    Direction direction_;
+
+    /**
+     * padding of the last block
+     */
+    Aes::Padding padding_;
+
+    /**
+     * number of threads large chunks are processed with
+     */
+    std::size_t numThreads_;
+
+    /**
+     * CBC: the cipher block the next block is chained with
+     */
+    std::array<std::uint8_t, CryptoConstants::BLOCK_SIZE_BYTES> chain_{};
+
+    /**
+     * the partial block waiting for more data, or the held back last block of a padded decryption
+     */
+    std::array<std::uint8_t, CryptoConstants::BLOCK_SIZE_BYTES> pending_{};
+
+    /**
+     * number of bytes in pending_
+     */
+    std::size_t pendingSize_ = 0;
+
+    /**
+     * CTR: byte offset of the next chunk from the start of the data
+     */
+    std::uint64_t position_ = 0;
+};
+
+#endif
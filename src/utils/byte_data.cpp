@@ -1,7 +1,8 @@
 #include "byte_data.h"
 #include "internal/matasano_convert.h"
+#include "internal/xor_kernel.h"
 #include "matasano_asserts.h"
-#include <bitset>
+#include <algorithm>
 
 ByteData::ByteData(const std::string &str, Encoding strEnc)
 {
@@ -16,7 +17,10 @@ ByteData::ByteData(const std::string &str, Encoding strEnc)
         parsePlain(str);
         break;
     case Encoding::base64:
-        parseBase64(str);
+        parseBase64(str, false);
+        break;
+    case Encoding::base64IgnoreWhitespace:
+        parseBase64(str, true);
         break;
     default:
         throw std::invalid_argument("Bad Encoding was given");
@@ -57,72 +61,47 @@ void ByteData::parseHexInternal(const std::string &hex)
 {
     THROW_IF(hex.length() % 2 != 0, hex + " has uneven length", std::invalid_argument);
 
-    for (std::size_t i = 0; i < hex.size(); i += 2)
-    {
-        auto number = Convert::parseNumFromStr(hex.substr(i, 2), 16);
-        LOGIC_ASSERT(number <= 255);
-        std::uint8_t b{static_cast<std::uint8_t>(number)};
-        byteData_.push_back(b);
-    }
+    auto oldSize = byteData_.size();
+    byteData_.resize(oldSize + hex.size() / 2);
+    Convert::hexToBytes(hex.data(), hex.size(), byteData_.data() + oldSize);
 }
 
-void ByteData::parseBase64(const std::string &base64)
+void ByteData::parseBase64(const std::string &base64, bool skipWhitespace)
 {
     LOGIC_ASSERT(byteData_.size() == 0);
 
-    if (base64.length() == 0)
-    {
-        return;
-    }
-
-    THROW_IF(base64.length() % 4 != 0, base64 + " has length that is not multiply of 4", std::invalid_argument);
+    byteData_.resize(base64.size() / 4 * 3);
+    auto written = Convert::base64ToBytes(base64.data(), base64.size(), byteData_.data(), skipWhitespace);
+    byteData_.resize(written);
+}
 
-    auto eqPos = base64.find('=');
-    THROW_IF(eqPos < base64.size() - 2, base64 + " is not in correct base64 format", std::invalid_argument);
+ByteData operator^(ByteData lhs, const ByteData &rhs) { return std::move(lhs) ^ ByteView(rhs); }
 
-    for (std::size_t i = 0; i < base64.size(); i += 4)
-    {
-        auto hex3 = Convert::base64_4ToHex3(base64.substr(i, 4));
-        parseHexInternal(hex3);
-    }
+ByteData operator^(ByteData lhs, ByteView rhs)
+{
+    // lhs is already a copy, so the result can be stored in place
+    ByteData::xorTo(lhs, rhs, lhs);
 
-    // remove padding
-    std::size_t numPad = 0;
-    if (base64.at(base64.size() - 2) == '=')
-    {
-        THROW_IF(base64.back() != '=', base64 + " is not in correct base64 format", std::invalid_argument)
-        numPad = 2;
-    }
-    else if ('=' == base64.back())
-    {
-        numPad = 1;
-    }
-    for (std::size_t i = 0; i < numPad; i++)
-    {
-        byteData_.pop_back();
-    }
+    return lhs;
 }
 
-ByteData operator^(ByteData lhs, const ByteData &rhs)
-{
-    THROW_IF(lhs.size() == 0, "lhs is empty", std::invalid_argument);
-    THROW_IF(rhs.size() == 0, "rhs is empty", std::invalid_argument);
+ByteData &ByteData::operator^=(const ByteData &rhs) { return *this ^= ByteView(rhs); }
 
-    ByteData res = lhs;
-
-    ByteData::xorVectors(lhs.byteData_, rhs.byteData_, res.byteData_);
+ByteData &ByteData::operator^=(ByteView rhs)
+{
+    xorTo(*this, rhs, *this);
 
-    return res;
+    return *this;
 }
 
-ByteData &ByteData::operator^=(const ByteData &rhs)
+void ByteData::xorTo(ByteView lhs, ByteView rhs, ByteData &result)
 {
-    THROW_IF(size() == 0, "this is empty", std::invalid_argument);
+    THROW_IF(lhs.size() == 0, "lhs is empty", std::invalid_argument);
     THROW_IF(rhs.size() == 0, "rhs is empty", std::invalid_argument);
 
-    xorVectors(byteData_, rhs.byteData_, byteData_);
-
-    return *this;
+    // when lhs views result the size does not change, so the view stays valid
+    result.byteData_.resize(lhs.size());
+    XorKernel::xorRepeating(lhs.data(), lhs.size(), rhs.data(), rhs.size(), result.byteData_.data());
 }
 
 bool ByteData::eqCyclically(const ByteData &other) const
@@ -169,19 +148,6 @@ bool ByteData::eqCyclicallyInternal(const ByteData &lhs, const ByteData &rhs) co
     return true;
 }
 
-void ByteData::xorVectors(const Botan::secure_vector<std::uint8_t> &lhs, const Botan::secure_vector<std::uint8_t> &rhs,
-                          Botan::secure_vector<std::uint8_t> &result)
-{
-    LOGIC_ASSERT(lhs.size() != 0);
-    LOGIC_ASSERT(rhs.size() != 0);
-    LOGIC_ASSERT(result.size() == lhs.size());
-
-    for (unsigned i = 0; i < result.size(); i++)
-    {
-        result.at(i) = lhs.at(i) ^ rhs.at(i % rhs.size());
-    }
-}
-
 std::string ByteData::str(Encoding strEnc) const
 {
     switch (strEnc)
@@ -193,6 +159,7 @@ std::string ByteData::str(Encoding strEnc) const
         return strPlain();
         break;
     case Encoding::base64:
+    case Encoding::base64IgnoreWhitespace:
         return strBase64();
         break;
     default:
@@ -218,120 +185,79 @@ std::string ByteData::strHex() const { return strHexInternal(0, byteData_.size()
 
 std::string ByteData::strHexInternal(std::size_t start, std::size_t end) const
 {
-    std::string res;
+    LOGIC_ASSERT(start <= end && end <= byteData_.size());
 
-    for (auto i = start; i < end; i++)
-    {
-        res += Convert::numToStr(byteData_.at(i), 2, 16);
-    }
+    std::string res(2 * (end - start), '\0');
+    Convert::bytesToHex(byteData_.data() + start, end - start, res.data());
 
     return res;
 }
 
 std::string ByteData::strBase64() const
 {
-    std::string result;
-
-    auto numBytes = byteData_.size();
-    auto bytesToPad = (3 - numBytes % 3) % 3;
-
-    // convert every 3 bytes to 4 octal numbers and from that to one base64 symbol
-    // iterate all the triples except the reminder
-    std::size_t i = 0;
-    for (; i < byteData_.size() - byteData_.size() % 3; i += 3)
-    {
-        result += Convert::hex3ToBase64_4(strHexInternal(i, i + 3));
-    }
-
-    if (bytesToPad != 0)
-    {
-        // convert the remaining 3 bytes with additional pad
-        std::string paddedHexReminder = Convert::padWith(strHexInternal(i, byteData_.size()), "00", bytesToPad);
-
-        result += Convert::hex3ToBase64_4(paddedHexReminder);
-
-        // remove the padding symbols
-        result = result.erase(result.length() - bytesToPad, bytesToPad);
-
-        result = Convert::padWith(result, "=", bytesToPad);
-    }
+    std::string result(Convert::base64Length(byteData_.size()), '\0');
+    Convert::bytesToBase64(byteData_.data(), byteData_.size(), result.data());
 
     return result;
 }
 
-double ByteData::hamming(const ByteData &another)
-{
-    THROW_IF(byteData_.size() != another.size(),
-             "this object has length of " + std::to_string(byteData_.size()) + " which is not equal to " +
-                 std::to_string(another.size()),
-             std::invalid_argument);
+double ByteData::hamming(ByteView another) const { return ByteView(*this).hamming(another); }
 
-    if (size() == 0)
-    {
-        return 0;
-    }
-
-    auto tmp = (*this) ^ another;
+std::uint64_t ByteData::hammingBits(ByteView another) const { return ByteView(*this).hammingBits(another); }
 
-    double byteFraction = 1.0 / static_cast<double>(tmp.size());
-    double result = 0;
+std::vector<ByteData> ByteData::extractRows(std::size_t elmsInRow, std::size_t maxRows) const
+{
+    auto views = extractRowViews(elmsInRow, maxRows);
 
-    for (auto b : tmp.secureData())
+    std::vector<ByteData> result;
+    result.reserve(views.size());
+    for (auto view : views)
     {
-        std::bitset<8> bitset(b);
-        result += static_cast<double>(bitset.count()) * byteFraction;
+        result.emplace_back(view);
     }
 
     return result;
 }
 
-std::vector<ByteData> ByteData::extractRows(std::size_t elmsInRow, std::size_t maxRows) const
+std::vector<ByteView> ByteData::extractRowViews(std::size_t elmsInRow, std::size_t maxRows) const
 {
     THROW_IF(size() == 0, "can't extract rows from empty object", std::invalid_argument);
     THROW_IF(0 == elmsInRow, "elmsInRow should not be 0", std::invalid_argument);
 
-    std::vector<ByteData> result;
-    ByteData currBD;
-    std::size_t currRow = 0;
-    std::size_t indexInRow = 0;
-
-    for (std::size_t i = 0; i < byteData_.size(); i++, indexInRow++)
+    auto numRows = size() / elmsInRow + (size() % elmsInRow != 0);
+    if (maxRows != 0)
     {
-        if (indexInRow == elmsInRow)
-        {
-            indexInRow = 0;
-            currRow++;
-            result.push_back(currBD);
-            currBD = ByteData();
-        }
-
-        if ((maxRows != 0) && (currRow >= maxRows))
-        {
-            break;
-        }
-
-        currBD += byteData_.at(i);
+        numRows = std::min(numRows, maxRows);
     }
 
-    if (currBD.size() != 0)
+    std::vector<ByteView> result;
+    result.reserve(numRows);
+
+    for (std::size_t row = 0; row < numRows; row++)
     {
-        result.push_back(currBD);
+        auto start = row * elmsInRow;
+        result.push_back(subView(start, std::min(elmsInRow, size() - start)));
     }
 
     return result;
 }
 
 ByteData ByteData::extractRow(std::size_t elmsInRow, std::size_t rowNum) const
+{
+    return ByteData(extractRowView(elmsInRow, rowNum));
+}
+
+ByteView ByteData::extractRowView(std::size_t elmsInRow, std::size_t rowNum) const
 {
     THROW_IF(size() == 0, "can't extract rows from empty object", std::invalid_argument);
-    ByteData res;
 
-    for (std::size_t i = elmsInRow * rowNum; (i < elmsInRow * rowNum + elmsInRow) && (i < size()); i++)
+    auto start = elmsInRow * rowNum;
+    if (start >= size())
     {
-        res += byteData_.at(i);
+        return ByteView();
     }
 
-    return res;
+    return subView(start, std::min(elmsInRow, size() - start));
 }
 
 std::vector<ByteData> ByteData::extractColumns(std::size_t maxNumColumns, std::size_t maxElmsInColumn) const
@@ -339,46 +265,35 @@ std::vector<ByteData> ByteData::extractColumns(std::size_t maxNumColumns, std::s
     THROW_IF(size() == 0, "can't extract columnts from empty object", std::invalid_argument);
     THROW_IF(0 == maxNumColumns, "maxNumColumns should not be 0", std::invalid_argument);
 
+    auto numColumns = std::min(maxNumColumns, size());
+
     std::vector<ByteData> result;
-    std::size_t currColumn = 0;
+    result.reserve(numColumns);
 
-    for (std::size_t i = 0; i < byteData_.size(); i++, currColumn++)
+    for (std::size_t column = 0; column < numColumns; column++)
     {
-        if (currColumn == maxNumColumns)
-        {
-            currColumn = 0;
-        }
-
-        if (result.size() <= currColumn)
+        // column 'column' holds elements column, column + numColumns, column + 2 * numColumns, ...
+        auto columnSize = (size() - column - 1) / numColumns + 1;
+        if (0 != maxElmsInColumn)
         {
-            result.push_back(ByteData());
-            LOGIC_ASSERT(result.size() > currColumn);
+            columnSize = std::min(columnSize, maxElmsInColumn);
         }
 
-        if (0 != maxElmsInColumn)
+        ByteData currColumn(0, columnSize);
+        for (std::size_t i = 0; i < columnSize; i++)
         {
-            LOGIC_ASSERT(result.at(currColumn).size() <= maxElmsInColumn);
-            if (result.at(currColumn).size() == maxElmsInColumn)
-            {
-                continue;
-            }
+            currColumn.byteData_[i] = byteData_[column + i * numColumns];
         }
 
-        result.at(currColumn) += byteData_.at(i);
+        result.push_back(std::move(currColumn));
     }
 
     return result;
 }
 
-ByteData ByteData::subData(std::size_t start, std::size_t count) const
-{
-    THROW_IF((start + count) > size(),
-             std::to_string(start) + " + " + std::to_string(count) +
-                 " fall beyond the size of data:" + std::to_string(size()),
-             std::invalid_argument);
+ByteData ByteData::subData(std::size_t start, std::size_t count) const { return ByteData(subView(start, count)); }
 
-    return ByteData(Botan::secure_vector<std::uint8_t>(byteData_.begin() + start, byteData_.begin() + start + count));
-}
+ByteView ByteData::subView(std::size_t start, std::size_t count) const { return ByteView(*this).subView(start, count); }
 
 ByteData::ByteData(const std::vector<ByteData> &rows)
 {
@@ -1,6 +1,7 @@
 #ifndef MATASANO_BYTE_DATA_H
 #define MATASANO_BYTE_DATA_H
 
+#include "byte_view.h"
 #include <botan/secmem.h>
 #include <compare>
 #include <cstddef>
@@ -19,9 +20,10 @@ public:
      */
     enum class Encoding
     {
-        hex,    // hex Encoding
-        base64, // base64 Encoding
-        plain   // no Encoding
+        hex,                    // hex Encoding
+        base64,                 // base64 Encoding
+        base64IgnoreWhitespace, // base64 Encoding, whitespace and line breaks are skipped when parsing
+        plain                   // no Encoding
     };
 
     /**
@@ -61,6 +63,13 @@ public:
      */
     ByteData(const Botan::secure_vector<std::uint8_t> bytes) : byteData_(std::move(bytes)){};
 
+    /**
+     * @brief Construct a new ByteData object by copying the viewed bytes
+     *
+     * @param view bytes to construct object from
+     */
+    explicit ByteData(ByteView view) : byteData_(view.begin(), view.end()){};
+
     /**
      * @brief Construct a new Byte Data object from a vector of rows
      *
@@ -99,6 +108,13 @@ public:
      */
     friend ByteData operator^(ByteData lhs, const ByteData &rhs);
 
+    /**
+     * @brief same as xor with ByteData, but rhs can be a view (a part of some other ByteData)
+     *
+     * @throw std::invalid_argument if either of arguments is empty
+     */
+    friend ByteData operator^(ByteData lhs, ByteView rhs);
+
     /**
      * @brief performs mathematical xor between this object and the other one rhs is applied cyclically to lhs
      * Both ByteData objects should be not empty
@@ -110,6 +126,26 @@ public:
      */
     ByteData &operator^=(const ByteData &rhs);
 
+    /**
+     * @brief same as xor with ByteData, but rhs can be a view (a part of some other ByteData)
+     *
+     * @throw std::invalid_argument if either of arguments is empty
+     */
+    ByteData &operator^=(ByteView rhs);
+
+    /**
+     * @brief same as xor operator, but stores the result in a given object, so a buffer can be reused between calls
+     * rhs is applied cyclically to lhs
+     *
+     * @param lhs the first argument
+     * @param rhs the second argument
+     * @param result resized to the size of lhs and filled with the result. May be the object lhs views (to xor in
+     * place), but should not be the object rhs views
+     *
+     * @throw std::invalid_argument if either of arguments is empty
+     */
+    static void xorTo(ByteView lhs, ByteView rhs, ByteData &result);
+
     /**
      * @brief retrieve string representation of this object in given Encoding
      *
@@ -160,14 +196,28 @@ public:
     inline std::size_t size() const { return byteData_.size(); }
 
     /**
-     * @brief Find hamming distance with another ByteData
+     * @brief View of the whole data. The view is valid as long as this object is alive and not modified
      *
-     * @param another ByteData to compute distance with. Should be the same length as this one
+     * @return ByteView of the data
+     */
+    inline operator ByteView() const { return ByteView(byteData_.data(), byteData_.size()); }
+
+    /**
+     * @brief Find hamming distance with another ByteData (or a view of one)
+     *
+     * @param another bytes to compute distance with. Should be the same length as this one
      * @return double hamming distance normalized with the length of the byte data
      *
      * @throw std::invalid_argument if length of another is not equal to length of the current byte data
      */
-    double hamming(const ByteData &another);
+    double hamming(ByteView another) const;
+
+    /**
+     * @brief Same as hamming, but returns the number of differing bits instead of normalizing it (@see hamming)
+     *
+     * @throw std::invalid_argument if length of another is not equal to length of the current byte data
+     */
+    std::uint64_t hammingBits(ByteView another) const;
 
     /**
      * @brief Extracts sub ByteData from a given one
@@ -180,6 +230,17 @@ public:
      */
     ByteData subData(std::size_t start, std::size_t count) const;
 
+    /**
+     * @brief Same as subData but returns a view instead of a copy
+     *
+     * @param start the index of element to start
+     * @param count the number of elements in the view
+     * @return view of the sub data, valid as long as this object is alive and not modified
+     *
+     * @throw std::invalid_argument if start / count do not fall within the range of data in ByteData
+     */
+    ByteView subView(std::size_t start, std::size_t count) const;
+
     /**
      * @brief pops back the last symbol
      */
@@ -196,9 +257,16 @@ public:
      *
      * @throw std::invalid_argument if elmsInRow is 0, or this object is empty
      */
-    // TODO consider using span instead
     std::vector<ByteData> extractRows(std::size_t elmsInRow, std::size_t maxRows = 0) const;
 
+    /**
+     * @brief Same as extractRows, but returns views of the rows instead of copies (@see extractRows)
+     * The views are valid as long as this object is alive and not modified
+     *
+     * @throw std::invalid_argument if elmsInRow is 0, or this object is empty
+     */
+    std::vector<ByteView> extractRowViews(std::size_t elmsInRow, std::size_t maxRows = 0) const;
+
     /**
      * @brief Extract the rowNum's row of consequetive elements from byte data. The number of elements in a row is
      * 'elmsInRow' elements form one row. The last row could have less elements than elmsInRow
@@ -208,8 +276,16 @@ public:
      * @param rowNum row's number
      * @return extracted ByteData, will be empty if rowNum does not contain any elements
      */
-    // TODO consider using span instead
     ByteData extractRow(std::size_t elmsInRow, std::size_t rowNum) const;
+
+    /**
+     * @brief Same as extractRow, but returns a view of the row instead of a copy (@see extractRow)
+     * The view is valid as long as this object is alive and not modified
+     *
+     * @throw std::invalid_argument if this object is empty
+     */
+    ByteView extractRowView(std::size_t elmsInRow, std::size_t rowNum) const;
+
     /**
      * @brief Exctract each 'numColumns'-s element from byte data. For example if numColumns is 4 then this will be the
      * resulting vector (numbers are indexes of the elements in the original byte data vector):
@@ -223,9 +299,11 @@ public:
      * @param maxElmsInColumn the maximum size of one ByteData in a vector
      * @return vector of resulting columns of ByteData
      *
+     * @note columns are not contiguous in memory, so unlike rows there is no view variant. Each column is still
+     * allocated once with its final size
+     *
      * @throw std::invalid_argument if numColumns is 0, or this object is empty
      */
-    // TODO consider using span instead
     std::vector<ByteData> extractColumns(std::size_t maxNumColumns, std::size_t maxElmsInColumn = 0) const;
 
 private:
@@ -247,7 +325,7 @@ private:
      * The only difference from parseHex is that it can add to existing byte data
      *
      * @param hex hex data
-     * @throw std::invalid_argument if hex string is not even size
+     * @throw std::invalid_argument if hex string is not even size or has non hex characters
      */
     void parseHexInternal(const std::string &hex);
 
@@ -262,9 +340,10 @@ private:
      * @brief parses string data as base64. Should be called from constructor
      *
      * @param base64 base64 data
-     * @throw std::invalid_argument if base64 string is not multiply of 4
+     * @param skipWhitespace if true, whitespace and line breaks are skipped while decoding
+     * @throw std::invalid_argument if base64 string is not multiply of 4 or is not in correct base64 format
      */
-    void parseBase64(const std::string &base64);
+    void parseBase64(const std::string &base64, bool skipWhitespace);
 
     /**
      * @brief return string representation without any Encoding
@@ -287,18 +366,6 @@ private:
      */
     std::string strBase64() const;
 
-    /**
-     * @brief xors two given vectors and stores the result in result
-     * rhs is applied cyclically to lhs
-     *
-     * @param lhs the first argument
-     * @param rhs the first argument
-     * @param result the result to store, it's size should be the same
-     * as size of lhs
-     */
-    static void xorVectors(const Botan::secure_vector<std::uint8_t> &lhs, const Botan::secure_vector<std::uint8_t> &rhs,
-                           Botan::secure_vector<std::uint8_t> &result);
-
     /**
      * @brief return string representation without any Encoding
      * Internal function that does not need this
@@ -329,4 +396,12 @@ private:
     bool eqCyclicallyInternal(const ByteData &lhs, const ByteData &rhs) const;
 };
 
+/**
+ * @brief hash of the bytes, allows using ByteData as a key of unordered containers. Equal to the hash of its view
+ */
+template <> struct std::hash<ByteData>
+{
+    std::size_t operator()(const ByteData &byteData) const noexcept { return std::hash<ByteView>{}(byteData); }
+};
+
 #endif
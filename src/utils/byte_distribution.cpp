@@ -1,54 +1,66 @@
 #include "byte_distribution.h"
+#include "internal/xored_sum.h"
+#include <algorithm>
 #include <cmath>
 
-ByteDistribution::ByteDistribution(const ByteData &byteData)
+ByteDistribution::ByteDistribution(ByteView bytes) : ByteDistribution(histogram(bytes), bytes.size()) {}
+
+ByteDistribution::ByteDistribution(const Histogram &histogram, std::size_t total)
 {
-    auto bytes = byteData.secureData();
-    double one_elm_percentage = (1.0 / static_cast<double>(bytes.size()) * static_cast<double>(100));
+    if (total == 0)
+    {
+        return;
+    }
 
-    for (auto b : bytes)
+    double oneElmPercentage = 100.0 / static_cast<double>(total);
+    for (std::size_t i = 0; i < BINS; i++)
     {
-        distributionMap_[b] += one_elm_percentage;
+        percentages_[i] = static_cast<double>(histogram[i]) * oneElmPercentage;
     }
 }
 
-double ByteDistribution::distance(const ByteDistribution &anotherDistribution) const
+ByteDistribution::Histogram ByteDistribution::histogram(ByteView bytes)
 {
-    auto iteratorThis = distributionMap_.begin();
-    auto iteratorAnother = anotherDistribution.distributionMap_.begin();
-    auto thisEnd = distributionMap_.end();
-    auto anotherEnd = anotherDistribution.distributionMap_.end();
-    double result = 0;
+    // 4 tables, so consecutive equal bytes (very common in text) do not wait for each other's increments
+    std::array<Histogram, 4> tables{};
 
-    while (iteratorThis != thisEnd && iteratorAnother != anotherEnd)
+    std::size_t i = 0;
+    for (; i + 4 <= bytes.size(); i += 4)
     {
-        if (iteratorThis->first < iteratorAnother->first)
-        {
-            result += iteratorThis->second;
-            iteratorThis++;
-        }
-        else if (iteratorAnother->first < iteratorThis->first)
-        {
-            result += iteratorAnother->second;
-            iteratorAnother++;
-        }
-        else
-        {
-            result += std::abs(iteratorThis->second - iteratorAnother->second);
-            iteratorThis++;
-            iteratorAnother++;
-        }
+        tables[0][bytes[i]]++;
+        tables[1][bytes[i + 1]]++;
+        tables[2][bytes[i + 2]]++;
+        tables[3][bytes[i + 3]]++;
     }
 
-    for (auto it = iteratorThis; it != thisEnd; it++)
+    for (; i < bytes.size(); i++)
     {
-        result += iteratorThis->second;
+        tables[0][bytes[i]]++;
     }
 
-    for (auto it = iteratorAnother; it != anotherEnd; it++)
+    for (std::size_t b = 0; b < BINS; b++)
     {
-        result += iteratorAnother->second;
+        tables[0][b] += tables[1][b] + tables[2][b] + tables[3][b];
     }
 
-    return result;
-}
\ No newline at end of file
+    return tables[0];
+}
+
+std::size_t ByteDistribution::size() const
+{
+    return static_cast<std::size_t>(
+        std::count_if(percentages_.begin(), percentages_.end(), [](double percentage) { return percentage != 0; }));
+}
+
+double ByteDistribution::distance(const ByteDistribution &anotherDistribution) const
+{
+    return distance(anotherDistribution, 0);
+}
+
+double ByteDistribution::distance(const ByteDistribution &anotherDistribution, std::uint8_t xorKey) const
+{
+    // byte b of the xored data is byte b ^ xorKey of this one
+    return XoredSum::sum(percentages_, xorKey, [&](double percentage, std::size_t b) {
+        return std::abs(percentage - anotherDistribution.percentages_[b]);
+    });
+}
@@ -2,6 +2,8 @@
 #define MATASANO_DISTRIBUTION_H
 
 #include "byte_data.h"
+#include <array>
+#include <cstdint>
 
 /**
  * @brief Represents percentage distribution of each byte in a given ByteData
@@ -11,16 +13,44 @@
  *
  * If object has these bytes  : {10, 10, 99, 98}
  * The resulting map shall be : {{10, 50}, {99, 25}, {98, 25}}
+ *
+ * The distribution is kept in a fixed table of 256 bins, so it is cheap to build and to compare
  */
 class ByteDistribution
 {
 public:
     /**
-     * @brief Construct a new Bytes Distribution object based on a given ByteData object
+     * @brief number of bins, one for each byte value
+     */
+    static constexpr std::size_t BINS = 256;
+
+    /**
+     * @brief counts of each byte value
+     */
+    using Histogram = std::array<std::uint32_t, BINS>;
+
+    /**
+     * @brief Construct a new Bytes Distribution object based on a given ByteData object (or a view of one)
+     *
+     * @param bytes bytes to construction distribution from
+     */
+    ByteDistribution(ByteView bytes);
+
+    /**
+     * @brief Construct a new Bytes Distribution object from byte counts
      *
-     * @param byteData ByteData to construction distribution from
+     * @param histogram number of times each byte value appears
+     * @param total sum of all the counts in histogram
      */
-    ByteDistribution(const ByteData &byteData);
+    ByteDistribution(const Histogram &histogram, std::size_t total);
+
+    /**
+     * @brief Counts each byte value in the given bytes
+     *
+     * @param bytes bytes to count
+     * @return the counts
+     */
+    static Histogram histogram(ByteView bytes);
 
     /**
      * @brief distribution of a particular byte in percentage. If byte did not appear in the ByteData object - return 0
@@ -28,39 +58,46 @@ public:
      * @param byte to check distribution for
      * @return distribution in percentage
      */
-    inline double at(std::uint8_t byte) const
-    {
-        return distributionMap_.contains(byte) ? distributionMap_.at(byte) : 0;
-    }
+    inline double at(std::uint8_t byte) const { return percentages_[byte]; }
 
     /**
      * @brief removes distribution of a particular byte. If it does not exists, there is no effect
      *
      * @param byte byte to remove
      */
-    inline void erase(std::uint8_t byte) { distributionMap_.erase(byte); }
+    inline void erase(std::uint8_t byte) { percentages_[byte] = 0; }
 
     /**
      * @brief get the size of the distribution, i.e the number of members with non-zero percentage
      *
      * @return the size
      */
-    inline std::size_t size() const { return distributionMap_.size(); }
+    std::size_t size() const;
 
     /**
      * @brief returns non-negative double representing a 'distance' from another Distribution object
-     * The closer this number to 0 the closer their distribution is
+     * The closer this number to 0 the closer their distribution is. This is the L1 distance between the percentages
      *
      * @param anotherDistribution
      * @return double
      */
     double distance(const ByteDistribution &anotherDistribution) const;
 
+    /**
+     * @brief same as distance, but as if every byte this distribution was built from was xored with xorKey first.
+     * Xor with a constant byte only permutes the bins, so this does not need the xored data
+     *
+     * @param anotherDistribution
+     * @param xorKey the byte to xor with
+     * @return double
+     */
+    double distance(const ByteDistribution &anotherDistribution, std::uint8_t xorKey) const;
+
 private:
     /**
-     * @brief the distribution map
+     * @brief percentage of each byte value, 0 for values that do not appear
      */
-    std::map<std::uint8_t, double> distributionMap_;
+    std::array<double, BINS> percentages_{};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,72 @@
+#include "byte_view.h"
+#include "internal/xor_kernel.h"
+#include "matasano_asserts.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+ByteView ByteView::subView(std::size_t start, std::size_t count) const
+{
+    THROW_IF(start > size() || count > size() - start,
+             std::to_string(start) + " + " + std::to_string(count) +
+                 " fall beyond the size of data:" + std::to_string(size()),
+             std::invalid_argument);
+
+    return ByteView(bytes_.subspan(start, count));
+}
+
+std::uint64_t ByteView::hammingBits(ByteView another) const
+{
+    THROW_IF(size() != another.size(),
+             "this object has length of " + std::to_string(size()) + " which is not equal to " +
+                 std::to_string(another.size()),
+             std::invalid_argument);
+
+    return XorKernel::hammingDistance(data(), another.data(), size());
+}
+
+double ByteView::hamming(ByteView another) const
+{
+    auto bits = hammingBits(another);
+
+    return size() == 0 ? 0 : static_cast<double>(bits) / static_cast<double>(size());
+}
+
+bool ByteView::operator==(const ByteView &other) const
+{
+    return size() == other.size() && (size() == 0 || std::memcmp(data(), other.data(), size()) == 0);
+}
+
+std::strong_ordering ByteView::operator<=>(const ByteView &other) const
+{
+    return std::lexicographical_compare_three_way(begin(), end(), other.begin(), other.end());
+}
+
+std::size_t std::hash<ByteView>::operator()(ByteView view) const noexcept
+{
+    // 64 bit FNV-1a over 8 byte words, finalized with the murmur3 mixer
+    std::uint64_t hash = 0xcbf29ce484222325ULL ^ view.size();
+    std::size_t i = 0;
+
+    for (; i + 8 <= view.size(); i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, view.data() + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+
+    for (; i < view.size(); i++)
+    {
+        hash = (hash ^ view[i]) * 0x100000001b3ULL;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return static_cast<std::size_t>(hash);
+}
@@ -0,0 +1,121 @@
+#ifndef MATASANO_BYTE_VIEW_H
+#define MATASANO_BYTE_VIEW_H
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+/**
+ * @brief Non-owning, cheap to copy view over contiguous bytes (for example a row of ByteData)
+ * The view does not extend the lifetime of the data, so the viewed object should outlive it
+ */
+class ByteView
+{
+public:
+    /**
+     * @brief Construct a new empty ByteView object
+     */
+    ByteView() = default;
+
+    /**
+     * @brief Construct a new ByteView object over a given memory range
+     *
+     * @param data pointer to the first byte
+     * @param size number of bytes
+     */
+    ByteView(const std::uint8_t *data, std::size_t size) : bytes_(data, size){};
+
+    /**
+     * @brief Construct a new ByteView object over a given span
+     *
+     * @param bytes span of bytes
+     */
+    ByteView(std::span<const std::uint8_t> bytes) : bytes_(bytes){};
+
+    /**
+     * @brief pointer to the first viewed byte
+     */
+    inline const std::uint8_t *data() const { return bytes_.data(); }
+
+    /**
+     * @brief number of viewed bytes
+     */
+    inline std::size_t size() const { return bytes_.size(); }
+
+    /**
+     * @brief true if the view has no bytes
+     */
+    inline bool empty() const { return bytes_.empty(); }
+
+    /**
+     * @brief the underlying span
+     */
+    inline std::span<const std::uint8_t> span() const { return bytes_; }
+
+    /**
+     * @brief access byte by index without bounds checking
+     */
+    inline std::uint8_t operator[](std::size_t i) const { return bytes_[i]; }
+
+    inline auto begin() const { return bytes_.begin(); }
+    inline auto end() const { return bytes_.end(); }
+
+    /**
+     * @brief Returns view of a part of this view
+     *
+     * @param start the index of element to start
+     * @param count the number of elements in the sub view
+     * @return sub view
+     *
+     * @throw std::invalid_argument if start / count do not fall within the range of this view
+     */
+    ByteView subView(std::size_t start, std::size_t count) const;
+
+    /**
+     * @brief Find hamming distance with another ByteView (the number of differing bits). Nothing is allocated
+     *
+     * @param another ByteView to compute distance with. Should be the same length as this one
+     * @return the number of bits that differ
+     *
+     * @throw std::invalid_argument if length of another is not equal to length of this view
+     */
+    std::uint64_t hammingBits(ByteView another) const;
+
+    /**
+     * @brief Find hamming distance with another ByteView, normalized with the length of the view
+     *
+     * @param another ByteView to compute distance with. Should be the same length as this one
+     * @return double hamming distance normalized with the length of the view (average differing bits per byte)
+     *
+     * @throw std::invalid_argument if length of another is not equal to length of this view
+     */
+    double hamming(ByteView another) const;
+
+    /**
+     * @brief compares the viewed bytes (not the pointers)
+     */
+    bool operator==(const ByteView &other) const;
+
+    /**
+     * @brief lexicographical comparison of the viewed bytes, same order as for ByteData
+     */
+    std::strong_ordering operator<=>(const ByteView &other) const;
+
+private:
+    /**
+     * @brief the viewed bytes
+     */
+    std::span<const std::uint8_t> bytes_;
+};
+
+/**
+ * @brief hash of the viewed bytes, allows using ByteView as a key of unordered containers
+ */
+template <> struct std::hash<ByteView>
+{
+    std::size_t operator()(ByteView view) const noexcept;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "crib_dragger.h"
+#include "general_utils.h"
+#include "internal/xor_kernel.h"
+#include "matasano_asserts.h"
+#include "top_k.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace
+{
+/**
+ * @brief ranks the lower scores first, then the smaller offsets
+ */
+struct BetterMatch
+{
+    bool operator()(const CribDragger::Match &lhs, const CribDragger::Match &rhs) const
+    {
+        return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+    }
+};
+} // namespace
+
+CribDragger::CribDragger(std::shared_ptr<const NGramModel> model) : model_(std::move(model))
+{
+    THROW_IF(!model_, "model is null", std::invalid_argument);
+}
+
+std::vector<CribDragger::Match> CribDragger::drag(ByteView data, ByteView crib, std::size_t topK,
+                                                  std::size_t numThreads) const
+{
+    return dragImpl(data.data(), nullptr, data.size(), crib, topK, numThreads);
+}
+
+std::vector<CribDragger::Match> CribDragger::dragPair(ByteView first, ByteView second, ByteView crib,
+                                                      std::size_t topK, std::size_t numThreads) const
+{
+    return dragImpl(first.data(), second.data(), std::min(first.size(), second.size()), crib, topK, numThreads);
+}
+
+std::vector<CribDragger::Match> CribDragger::dragImpl(const std::uint8_t *first, const std::uint8_t *second,
+                                                      std::size_t size, ByteView crib, std::size_t topK,
+                                                      std::size_t numThreads) const
+{
+    THROW_IF(crib.empty(), "crib is empty", std::invalid_argument);
+    if (crib.size() > size || topK == 0)
+    {
+        return {};
+    }
+
+    auto numOffsets = size - crib.size() + 1;
+    auto taskOffsets = TILES_PER_TASK * NGramModel::MAX_WINDOWS;
+    auto numTasks = GeneralUtils::ceil(numOffsets, taskOffsets);
+    std::vector<std::vector<Match>> taskMatches(numTasks);
+
+    GeneralUtils::parallelFor(numTasks, numThreads, [&](std::size_t task) {
+        TopK<Match, BetterMatch> best(topK);
+        std::array<double, NGramModel::MAX_WINDOWS> scores;
+        // a tile of the xor of the ciphertexts, the windows of the last offsets of the tile run crib size - 1 bytes
+        // past it
+        std::vector<std::uint8_t> tile(second ? NGramModel::MAX_WINDOWS + crib.size() - 1 : 0);
+
+        auto end = std::min(numOffsets, (task + 1) * taskOffsets);
+        for (auto offset = task * taskOffsets; offset < end; offset += NGramModel::MAX_WINDOWS)
+        {
+            auto numWindows = std::min(end - offset, NGramModel::MAX_WINDOWS);
+            const std::uint8_t *windows = first + offset;
+            if (second)
+            {
+                XorKernel::xorBlocks(first + offset, second + offset, numWindows + crib.size() - 1, tile.data());
+                windows = tile.data();
+            }
+
+            model_->scoreWindows(windows, numWindows, crib, scores.data());
+            for (std::size_t i = 0; i < numWindows; i++)
+            {
+                best.push({offset + i, scores[i]});
+            }
+        }
+
+        taskMatches[task] = best.extractSorted();
+    });
+
+    TopK<Match, BetterMatch> best(topK);
+    for (auto &matches : taskMatches)
+    {
+        for (auto &match : matches)
+        {
+            best.push(match);
+        }
+    }
+
+    return best.extractSorted();
+}
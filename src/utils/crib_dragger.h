@@ -0,0 +1,85 @@
+#ifndef MATASANO_CRIB_DRAGGER_H
+#define MATASANO_CRIB_DRAGGER_H
+
+#include "byte_view.h"
+#include "ngram_model.h"
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Known plaintext search: a crib (a fragment of the plaintext that is believed to be somewhere in it, like a
+ * header or a protocol token) is xored with the data at every offset, and every window is scored with the trigram
+ * model (@see NGramModel::scoreWindows). Where the data is a ciphertext xored with the crib's plaintext, the window is
+ * the keystream; where it is two ciphertexts that share a keystream xored together, the window is the other plaintext
+ * and scores well.
+ *
+ * The offsets are scored in tiles of NGramModel::MAX_WINDOWS, so nothing is allocated per offset, and the tiles are
+ * spread over threads. This works for cribs of hundreds of bytes over hundreds of megabytes of data
+ */
+class CribDragger
+{
+public:
+    /**
+     * @brief offset of a window in the data and its score, the lower the score - the more likely the window is
+     */
+    using Match = std::pair<std::size_t, double>;
+
+    /**
+     * @brief Construct a new Crib Dragger object
+     *
+     * @param model trigram model of the language of the plaintexts, can't be null
+     * @throw std::invalid_argument if model is null
+     */
+    explicit CribDragger(std::shared_ptr<const NGramModel> model);
+
+    /**
+     * @brief Drags the crib over the data: scores data[o, o + crib size) ^ crib for every offset o
+     *
+     * @param data the data, e.g. the xor of two ciphertexts
+     * @param crib the crib, can't be empty
+     * @param topK number of the best offsets to return
+     * @param numThreads number of threads to use, 0 for the number of hardware threads
+     * @return up to topK offsets and their scores, the best first (ties broken by the smaller offset). Empty if the
+     * crib is longer than the data
+     * @throw std::invalid_argument if crib is empty
+     */
+    std::vector<Match> drag(ByteView data, ByteView crib, std::size_t topK, std::size_t numThreads = 1) const;
+
+    /**
+     * @brief Drags the crib over the xor of two ciphertexts that were ciphered with the same keystream (a reused
+     * one-time pad or stream cipher nonce), without building the xor: it is computed a tile at a time into a small
+     * buffer. If the crib is in one of the plaintexts at offset o, the window at o is the other plaintext
+     *
+     * @param first the first ciphertext
+     * @param second the second ciphertext, only the common prefix of the ciphertexts is used
+     * @param crib the crib, can't be empty
+     * @param topK number of the best offsets to return
+     * @param numThreads number of threads to use, 0 for the number of hardware threads
+     * @return up to topK offsets and their scores, the best first (ties broken by the smaller offset). Empty if the
+     * crib is longer than the common prefix
+     * @throw std::invalid_argument if crib is empty
+     */
+    std::vector<Match> dragPair(ByteView first, ByteView second, ByteView crib, std::size_t topK,
+                                std::size_t numThreads = 1) const;
+
+private:
+    /**
+     * number of tiles of NGramModel::MAX_WINDOWS offsets scored by one task
+     */
+    static constexpr std::size_t TILES_PER_TASK = 16;
+
+    /**
+     * @brief drags the crib over the xor of first and second, or over first alone if second is null
+     */
+    std::vector<Match> dragImpl(const std::uint8_t *first, const std::uint8_t *second, std::size_t size, ByteView crib,
+                                std::size_t topK, std::size_t numThreads) const;
+
+    /**
+     * the trigram model
+     */
+    std::shared_ptr<const NGramModel> model_;
+};
+
+#endif
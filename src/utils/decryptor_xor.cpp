@@ -1,147 +1,707 @@
 #include "decryptor_xor.h"
 #include "byte_distribution.h"
+#include "general_utils.h"
+#include "internal/mapped_file.h"
 #include "matasano_asserts.h"
+#include "xor_stream.h"
+#include <algorithm>
 #include <limits>
-#include <queue>
+#include <numeric>
 #include <tuple>
 
-DecryptorXor::DecryptorXor(const std::string &referenceLanguageData)
-    : referenceLanguage_(ByteDistribution(ByteData(referenceLanguageData, ByteData::Encoding::plain)))
+template <XorScorer ReferenceScorer>
+BasicDecryptorXor<ReferenceScorer>::BasicDecryptorXor(const std::string &referenceLanguageData)
+    : referenceScorer_(LanguageModel(ByteData(referenceLanguageData, ByteData::Encoding::plain)))
 {
 }
 
-std::tuple<std::string, std::uint8_t, double> DecryptorXor::decipherSingle(const ByteData &cipheredData) const
+template <XorScorer ReferenceScorer>
+BasicDecryptorXor<ReferenceScorer>::BasicDecryptorXor(const LanguageModel &model) : referenceScorer_(model)
 {
-    auto candidate = std::make_tuple(cipheredData, std::uint8_t{0}, std::numeric_limits<double>::max());
-    std::uint8_t curKey = 0;
-    do
-    {
-        auto curDecipher = cipheredData ^ ByteData(curKey);
+}
+
+template <XorScorer ReferenceScorer>
+BasicDecryptorXor<ReferenceScorer>::BasicDecryptorXor(const LanguageModel &model,
+                                                      std::shared_ptr<const NGramModel> ngramModel)
+    : referenceScorer_(model), ngramModel_(std::move(ngramModel))
+{
+}
+
+template <XorScorer ReferenceScorer>
+std::tuple<std::string, std::uint8_t, double>
+BasicDecryptorXor<ReferenceScorer>::decipherSingle(const ByteData &cipheredData) const
+{
+    THROW_IF(cipheredData.size() == 0, "cipheredData is empty", std::invalid_argument);
 
-        auto curConfidence = measureConfidence(curDecipher);
+    auto [key, confidence] = bestTextKey(cipheredData);
 
-        if (curConfidence < std::get<2>(candidate))
+    return std::make_tuple((cipheredData ^ ByteData(key)).str(ByteData::Encoding::plain), key, confidence);
+}
+
+template <XorScorer ReferenceScorer>
+std::vector<std::tuple<std::size_t, std::uint8_t, double>>
+BasicDecryptorXor<ReferenceScorer>::decipherSingleBatch(std::span<const ByteView> cipheredData, std::size_t topK,
+                                                        std::size_t numThreads) const
+{
+    using Candidate = std::tuple<std::size_t, std::uint8_t, double>;
+    auto better = [](const Candidate &left, const Candidate &right) {
+        return std::tie(std::get<2>(left), std::get<0>(left)) < std::tie(std::get<2>(right), std::get<0>(right));
+    };
+
+    // every chunk keeps only its own best topK, so the memory is topK per BATCH_CHUNK_SIZE texts, not one per text
+    auto numChunks = GeneralUtils::ceil(cipheredData.size(), BATCH_CHUNK_SIZE);
+    std::vector<std::vector<Candidate>> chunkBest(numChunks);
+
+    GeneralUtils::parallelFor(numChunks, numThreads, [&](std::size_t chunk) {
+        TopK<Candidate, decltype(better)> best(topK, better);
+        auto end = std::min(cipheredData.size(), (chunk + 1) * BATCH_CHUNK_SIZE);
+        for (auto i = chunk * BATCH_CHUNK_SIZE; i < end; i++)
         {
-            candidate = std::make_tuple(curDecipher, curKey, curConfidence);
-            // a little optimization for the trivial case, if we have exact match, no point in iterating further
-            if (0.0 == curConfidence)
+            if (!cipheredData[i].empty())
             {
-                break;
+                auto [key, confidence] = bestTextKey(cipheredData[i]);
+                best.push(Candidate{i, key, confidence});
             }
         }
+        chunkBest[chunk] = best.extractSorted();
+    });
+
+    TopK<Candidate, decltype(better)> best(topK, better);
+    for (auto const &chunk : chunkBest)
+    {
+        for (auto const &candidate : chunk)
+        {
+            best.push(candidate);
+        }
+    }
+
+    return best.extractSorted();
+}
+
+template <XorScorer ReferenceScorer>
+std::pair<std::uint8_t, double> BasicDecryptorXor<ReferenceScorer>::bestTextKey(ByteView cipheredData) const
+{
+    if (!ngramModel_)
+    {
+        return bestSingleByteKey(cipheredData, referenceScorer_);
+    }
+
+    // the shortlist is sorted, so ties go to the key the byte distribution prefers
+    std::pair<std::uint8_t, double> best(0, std::numeric_limits<double>::max());
+    for (auto [key, ignore] : rankSingleByteKeys(cipheredData, NGRAM_CANDIDATES))
+    {
+        auto confidence = ngramModel_->score(cipheredData, ByteView(&key, 1));
+        if (confidence < best.second)
+        {
+            best = std::make_pair(key, confidence);
+        }
+    }
+
+    return best;
+}
+
+template <XorScorer ReferenceScorer>
+std::vector<std::pair<std::uint8_t, double>>
+BasicDecryptorXor<ReferenceScorer>::rankSingleByteKeys(ByteView cipheredData, std::size_t topK) const
+{
+    return rankSingleByteKeys(cipheredData, topK, referenceScorer_);
+}
+
+template <XorScorer ReferenceScorer>
+std::vector<std::vector<std::pair<std::uint8_t, double>>>
+BasicDecryptorXor<ReferenceScorer>::rankColumnKeys(const ByteData &cipheredData, std::size_t keySize,
+                                                   std::size_t topK) const
+{
+    std::vector<std::vector<std::pair<std::uint8_t, double>>> result;
+    for (auto const &column : cipheredData.extractColumns(keySize))
+    {
+        result.push_back(rankSingleByteKeys(column, topK));
+    }
 
-    } while (++curKey != 0);
+    return result;
+}
 
-    return std::make_tuple(std::get<0>(candidate).str(ByteData::Encoding::plain), std::get<1>(candidate),
-                           std::get<2>(candidate));
+template <XorScorer ReferenceScorer>
+std::array<double, 256> BasicDecryptorXor<ReferenceScorer>::scoreSingleByteKeys(ByteView cipheredData) const
+{
+    return scoreSingleByteKeys(cipheredData, referenceScorer_);
 }
 
+template <XorScorer ReferenceScorer>
 std::tuple<std::string, ByteData, double>
-DecryptorXor::decipherMulti(const ByteData &cipheredData, const std::pair<std::size_t, std::size_t> &keySizeRange) const
+BasicDecryptorXor<ReferenceScorer>::decipherMulti(const ByteData &cipheredData,
+                                                  const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                  std::size_t numThreads) const
+{
+    auto candidates = rankMultiByteKeys(cipheredData, keySizeRange, 3, numThreads);
+    if (candidates.empty())
+    {
+        return std::make_tuple(std::string(), ByteData(), std::numeric_limits<double>::max());
+    }
+
+    auto &[key, confidence] = candidates.front();
+    return std::make_tuple((cipheredData ^ key).str(ByteData::Encoding::plain), key, confidence);
+}
+
+template <XorScorer ReferenceScorer>
+std::vector<std::pair<ByteData, double>>
+BasicDecryptorXor<ReferenceScorer>::rankMultiByteKeys(const ByteData &cipheredData,
+                                                      const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                      std::size_t topK, std::size_t numThreads) const
 {
     auto [keyMin, keyMax] = keySizeRange;
 
     THROW_IF(keyMin < 2, "minimal key size can't be less than 2", std::invalid_argument);
     THROW_IF(keyMax < keyMin, "maximum key size should be bigger than minumum", std::invalid_argument);
+    THROW_IF(cipheredData.size() == 0, "cipheredData is empty", std::invalid_argument);
+
+    std::vector<std::size_t> keySizes;
+    for (auto [keySize, ignore] : rankKeySizes(cipheredData, keySizeRange))
+    {
+        if (keySizes.size() == topK)
+        {
+            break;
+        }
+        keySizes.push_back(keySize);
+    }
+
+    // keys that are multiple of the original key decipher just as well, always prefer the smaller one
+    auto better = [](const std::pair<ByteData, double> &left, const std::pair<ByteData, double> &right) {
+        return std::make_pair(left.second, left.first.size()) < std::make_pair(right.second, right.first.size());
+    };
+
+    auto result = decipherMultiKeySizes(cipheredData, keySizes, numThreads);
+    std::sort(result.begin(), result.end(), better);
+
+    return result;
+}
+
+template <XorScorer ReferenceScorer>
+std::vector<std::pair<std::size_t, double>>
+BasicDecryptorXor<ReferenceScorer>::rankKeySizes(ByteView cipheredData,
+                                                 const std::pair<std::size_t, std::size_t> &keySizeRange)
+{
+    auto [startKeyRange, endKeyRange] = keySizeRange;
+
+    THROW_IF(startKeyRange == 0, "key size can't be 0", std::invalid_argument);
+    THROW_IF(endKeyRange < startKeyRange, "maximum key size should be bigger than minumum", std::invalid_argument);
+
+    // rows i and i + 1 of key size k are the bytes [0, compared) and [k, k + compared) of the data, where compared
+    // covers all the full rows but the last one
+    endKeyRange = std::min(endKeyRange, cipheredData.size() / 2);
+    auto comparedLength = [&](std::size_t keySize) { return (cipheredData.size() / keySize - 1) * keySize; };
+
+    std::vector<std::uint64_t> hammingBits(endKeyRange + 1, 0);
+    std::size_t maxCompared = 0;
+    for (auto keySize = startKeyRange; keySize <= endKeyRange; keySize++)
+    {
+        maxCompared = std::max(maxCompared, comparedLength(keySize));
+    }
+
+    // block by block, so the data of a block is read from the memory once for all the key sizes
+    for (std::size_t blockStart = 0; blockStart < maxCompared; blockStart += KEY_SIZE_BLOCK)
+    {
+        for (auto keySize = startKeyRange; keySize <= endKeyRange; keySize++)
+        {
+            auto compared = comparedLength(keySize);
+            if (blockStart < compared)
+            {
+                auto length = std::min(KEY_SIZE_BLOCK, compared - blockStart);
+                hammingBits[keySize] += cipheredData.subView(blockStart, length)
+                                            .hammingBits(cipheredData.subView(blockStart + keySize, length));
+            }
+        }
+    }
+
+    std::vector<std::pair<std::size_t, double>> result;
+    for (auto keySize = startKeyRange; keySize <= endKeyRange; keySize++)
+    {
+        // the last row with the first one
+        auto compared = comparedLength(keySize);
+        hammingBits[keySize] +=
+            cipheredData.subView(compared, keySize).hammingBits(cipheredData.subView(0, keySize));
+
+        auto numRows = cipheredData.size() / keySize;
+        result.emplace_back(keySize,
+                            static_cast<double>(hammingBits[keySize]) / static_cast<double>(numRows * keySize));
+    }
+
+    std::stable_sort(result.begin(), result.end(),
+                     [](const auto &left, const auto &right) { return left.second < right.second; });
+
+    return result;
+}
+
+template <XorScorer ReferenceScorer>
+double BasicDecryptorXor<ReferenceScorer>::measureConfidence(const ByteData &cipheredData, const ByteData &key) const
+{
+    if (ngramModel_)
+    {
+        return ngramModel_->score(cipheredData, key);
+    }
+
+    auto deciphered = cipheredData ^ key;
+    return referenceScorer_.score(ByteDistribution::histogram(deciphered), deciphered.size(), 0);
+}
+
+template <XorScorer ReferenceScorer>
+std::vector<std::pair<ByteData, double>>
+BasicDecryptorXor<ReferenceScorer>::decipherMultiKeySizes(const ByteData &cipheredData,
+                                                          const std::vector<std::size_t> &keySizes,
+                                                          std::size_t numThreads) const
+{
+    // one task per key byte of every key size
+    std::vector<std::pair<std::size_t, std::size_t>> keyBytes;
+    std::vector<std::vector<ByteData>> columns;
+    std::vector<std::pair<ByteData, double>> result;
+    for (std::size_t i = 0; i < keySizes.size(); i++)
+    {
+        LOGIC_ASSERT(keySizes[i] >= 2);
+
+        columns.push_back(cipheredData.extractColumns(keySizes[i]));
+        result.emplace_back(ByteData(0, columns.back().size()), 0.0);
+        for (std::size_t column = 0; column < columns.back().size(); column++)
+        {
+            keyBytes.emplace_back(i, column);
+        }
+    }
+
+    GeneralUtils::parallelFor(keyBytes.size(), numThreads, [&](std::size_t task) {
+        auto [i, column] = keyBytes[task];
+        result[i].first.secureData()[column] = bestSingleByteKey(columns[i][column], referenceScorer_).first;
+    });
+
+    GeneralUtils::parallelFor(keySizes.size(), numThreads, [&](std::size_t i) {
+        if (ngramModel_)
+        {
+            result[i].first = refineMultiByteKey(cipheredData, result[i].first);
+        }
+        result[i].second = measureConfidence(cipheredData, result[i].first);
+    });
 
-    auto keySizes = guessKeySize(cipheredData, keySizeRange);
+    return result;
+}
+
+template <XorScorer ReferenceScorer>
+ByteData BasicDecryptorXor<ReferenceScorer>::refineMultiByteKey(ByteView cipheredData, const ByteData &key) const
+{
+    THROW_IF(key.size() < 2, "key should be at least 2 bytes long", std::invalid_argument);
+    THROW_IF(!ngramModel_, "refining a key needs the trigram model", std::logic_error);
+
+    constexpr auto CLASSES = NGramModel::CLASSES;
+    auto const &bigrams = ngramModel_->bigrams();
+
+    std::array<std::uint8_t, 256> classOf;
+    for (std::size_t b = 0; b < classOf.size(); b++)
+    {
+        classOf[b] = NGramModel::classOf(static_cast<std::uint8_t>(b));
+    }
+
+    auto refined = key;
+    auto &keyBytes = refined.secureData();
+    auto keySize = keyBytes.size();
+    auto size = cipheredData.size();
 
-    auto result = std::make_tuple(std::string(), ByteData(), std::numeric_limits<double>::max());
-    for (auto keySize : keySizes)
+    // the neighbours of a byte xored with key byte j are xored with other key bytes, so they don't change with it
+    auto neighbourClass = [&](std::size_t i) { return classOf[cipheredData[i] ^ keyBytes[i % keySize]]; };
+
+    for (std::size_t pass = 0; pass < MAX_REFINE_PASSES; pass++)
     {
-        auto [curDecipher, currKey, currConfidence] = decipherMultiKeySize(cipheredData, keySize);
-        if (currConfidence <= std::get<2>(result))
+        bool changed = false;
+        for (std::size_t position = 0; position < keySize; position++)
         {
-            // the keys of keys that are multiple of the original key, always prefer the smaller one
-            if (currConfidence == std::get<2>(result))
+            // log likelihood of the bigrams around the bytes xored with this key byte, for each value of it
+            std::array<double, 256> logLikelihoods{};
+            for (auto i = position; i < size; i += keySize)
             {
-                if (currKey.size() < std::get<1>(result).size())
+                auto hasPrevious = i > 0;
+                auto hasNext = i + 1 < size;
+                auto previous = hasPrevious ? neighbourClass(i - 1) : 0;
+                auto next = hasNext ? neighbourClass(i + 1) : 0;
+
+                for (std::size_t value = 0; value < logLikelihoods.size(); value++)
                 {
-                    result = std::make_tuple(curDecipher, currKey, currConfidence);
+                    auto current = classOf[cipheredData[i] ^ value];
+                    logLikelihoods[value] += (hasPrevious ? bigrams[previous * CLASSES + current] : 0.0f) +
+                                             (hasNext ? bigrams[current * CLASSES + next] : 0.0f);
                 }
             }
-            else
+
+            auto best = std::max_element(logLikelihoods.begin(), logLikelihoods.end()) - logLikelihoods.begin();
+            if (logLikelihoods[static_cast<std::size_t>(best)] > logLikelihoods[keyBytes[position]])
             {
-                result = std::make_tuple(curDecipher, currKey, currConfidence);
+                keyBytes[position] = static_cast<std::uint8_t>(best);
+                changed = true;
             }
         }
+
+        if (!changed)
+        {
+            break;
+        }
     }
 
-    return result;
+    return refined;
 }
 
-std::vector<std::size_t> DecryptorXor::guessKeySize(const ByteData &cipheredData,
-                                                    const std::pair<std::size_t, std::size_t> &keySizeRange,
-                                                    std::size_t numberOfCandidatesToReturn) const
+template <XorScorer ReferenceScorer>
+std::tuple<ByteData, double, double>
+BasicDecryptorXor<ReferenceScorer>::estimateMultiByteKey(ByteView cipheredData,
+                                                         const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                         std::size_t sampleSize, std::size_t numThreads) const
 {
-    auto [startKeyRange, endKeyRange] = keySizeRange;
+    auto [keyMin, keyMax] = keySizeRange;
+
+    THROW_IF(keyMin < 2, "minimal key size can't be less than 2", std::invalid_argument);
+    THROW_IF(keyMax < keyMin, "maximum key size should be bigger than minumum", std::invalid_argument);
+    THROW_IF(cipheredData.empty(), "cipheredData is empty", std::invalid_argument);
+    THROW_IF(sampleSize == 0, "sample size can't be 0", std::invalid_argument);
 
-    auto cmpKeyHummingPairs = [](const std::pair<std::size_t, double> &left,
-                                 const std::pair<std::size_t, double> &right) {
-        return std::get<1>(left) > std::get<1>(right);
+    // the first sample is every stride-th block, the second one - the blocks half way between them
+    auto totalBlocks = GeneralUtils::ceil(cipheredData.size(), SAMPLE_BLOCK);
+    auto blocksPerSample =
+        std::min(GeneralUtils::ceil(sampleSize, SAMPLE_BLOCK), std::max(std::size_t{1}, totalBlocks / 2));
+    auto stride = totalBlocks / blocksPerSample;
+
+    std::vector<std::size_t> first, second;
+    for (std::size_t i = 0; i < blocksPerSample; i++)
+    {
+        first.push_back(i * stride * SAMPLE_BLOCK);
+        second.push_back((i * stride + stride / 2) * SAMPLE_BLOCK);
+    }
+    auto block = [&](std::size_t offset) {
+        return cipheredData.subView(offset, std::min(SAMPLE_BLOCK, cipheredData.size() - offset));
     };
 
-    std::priority_queue<std::pair<std::size_t, double>, std::vector<std::pair<std::size_t, double>>,
-                        decltype(cmpKeyHummingPairs)>
-        bestKeys(cmpKeyHummingPairs);
+    // the key sizes are ranked in every block of the first sample, and the scores are averaged
+    std::vector<std::vector<std::pair<std::size_t, double>>> blockRanks(first.size());
+    GeneralUtils::parallelFor(first.size(), numThreads,
+                              [&](std::size_t i) { blockRanks[i] = rankKeySizes(block(first[i]), keySizeRange); });
+
+    std::vector<double> scoreSums(keyMax + 1, 0);
+    std::vector<std::size_t> scoredBlocks(keyMax + 1, 0);
+    for (auto const &ranks : blockRanks)
+    {
+        for (auto [keySize, score] : ranks)
+        {
+            scoreSums[keySize] += score;
+            scoredBlocks[keySize]++;
+        }
+    }
+
+    std::vector<std::pair<std::size_t, double>> keySizes;
+    for (auto keySize = keyMin; keySize <= keyMax; keySize++)
+    {
+        if (scoredBlocks[keySize] != 0)
+        {
+            keySizes.emplace_back(keySize, scoreSums[keySize] / static_cast<double>(scoredBlocks[keySize]));
+        }
+    }
+    if (keySizes.empty())
+    {
+        return std::make_tuple(ByteData(), std::numeric_limits<double>::max(), 0.0);
+    }
+    std::stable_sort(keySizes.begin(), keySizes.end(),
+                     [](const auto &left, const auto &right) { return left.second < right.second; });
+
+    // the best 3 key sizes are solved on the first sample, like in decipherMulti
+    std::size_t bestKeySize = 0;
+    double bestConfidence = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < std::min(std::size_t{3}, keySizes.size()); i++)
+    {
+        auto keySize = keySizes[i].first;
+        auto confidence = measureSampleConfidence(cipheredData, first,
+                                                  solveColumns(countColumns(cipheredData, first, keySize)));
+        if (std::make_pair(confidence, keySize) < std::make_pair(bestConfidence, bestKeySize))
+        {
+            bestKeySize = keySize;
+            bestConfidence = confidence;
+        }
+    }
+
+    // the key of the first sample is confirmed by solving the second one on its own, and it is the one returned
+    auto key = solveColumns(countColumns(cipheredData, first, bestKeySize));
+    auto secondKey = solveColumns(countColumns(cipheredData, second, bestKeySize));
 
-    for (auto tryKeySize = startKeyRange; tryKeySize <= endKeyRange; tryKeySize++)
+    std::size_t agreed = 0;
+    for (std::size_t i = 0; i < bestKeySize; i++)
     {
-        auto rows = cipheredData.extractRows(tryKeySize);
+        agreed += key.secureData()[i] == secondKey.secureData()[i];
+    }
+
+    auto both = first;
+    if (second != first)
+    {
+        both.insert(both.end(), second.begin(), second.end());
+    }
+    auto confidence = measureSampleConfidence(cipheredData, both, key);
+
+    return std::make_tuple(std::move(key), confidence,
+                           static_cast<double>(agreed) / static_cast<double>(bestKeySize));
+}
+
+template <XorScorer ReferenceScorer>
+std::tuple<ByteData, double, double>
+BasicDecryptorXor<ReferenceScorer>::decipherMultiFile(const std::string &inFileName, const std::string &outFileName,
+                                                      const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                      std::size_t sampleSize, std::size_t numThreads,
+                                                      double minAgreement) const
+{
+    auto result = [&]() {
+        MappedFile in(inFileName);
+        return estimateMultiByteKey(in.view(), keySizeRange, sampleSize, numThreads);
+    }();
+
+    auto const &[key, confidence, agreement] = result;
+    THROW_IF(key.size() == 0, "none of the key sizes fits " + inFileName, std::invalid_argument);
+    THROW_IF(agreement < minAgreement, "the samples of " + inFileName + " disagree on the key", std::invalid_argument);
+
+    XorStream::xorFile(inFileName, outFileName, key);
+
+    return result;
+}
+
+template <XorScorer ReferenceScorer>
+std::pair<ByteData, std::vector<double>>
+BasicDecryptorXor<ReferenceScorer>::decipherSharedKeystream(std::span<const ByteView> cipheredData,
+                                                            std::size_t numThreads) const
+{
+    // the longest ciphertexts first, so row r of every column is the same ciphertext and the columns only get shorter
+    std::vector<std::size_t> order(cipheredData.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return cipheredData[lhs].size() > cipheredData[rhs].size();
+    });
+
+    auto length = order.empty() ? 0 : cipheredData[order.front()].size();
+    ByteData keystream(0, length);
+    std::vector<double> confidence(length);
+    if (length == 0)
+    {
+        return std::make_pair(keystream, confidence);
+    }
+
+    // heights[j] is the number of ciphertexts longer than j, the number of bytes in column j
+    std::vector<std::size_t> heights(length);
+    for (auto const &text : cipheredData)
+    {
+        if (!text.empty())
+        {
+            heights[text.size() - 1]++;
+        }
+    }
+    for (auto j = length - 1; j-- > 0;)
+    {
+        heights[j] += heights[j + 1];
+    }
+    std::vector<std::size_t> offsets(length + 1);
+    std::partial_sum(heights.begin(), heights.end(), offsets.begin() + 1);
 
-        // the last row could have different size, let's ignore it
-        if (rows.front().size() != rows.back().size())
+    // a task writes its own tile of columns, reading the ciphertexts that reach it
+    std::vector<std::uint8_t> columns(offsets.back());
+    GeneralUtils::parallelFor(GeneralUtils::ceil(length, TRANSPOSE_TILE), numThreads, [&](std::size_t tile) {
+        auto first = tile * TRANSPOSE_TILE;
+        auto last = std::min(length, first + TRANSPOSE_TILE);
+        for (std::size_t row = 0; row < heights[first]; row++)
         {
-            rows.pop_back();
+            auto text = cipheredData[order[row]];
+            auto end = std::min(last, text.size());
+            for (auto j = first; j < end; j++)
+            {
+                columns[offsets[j] + row] = text[j];
+            }
         }
+    });
+
+    auto column = [&](std::size_t j) { return ByteView(columns.data() + offsets[j], heights[j]); };
 
-        if (rows.size() < 2)
+    GeneralUtils::parallelFor(length, numThreads, [&](std::size_t j) {
+        keystream.secureData()[j] = bestSingleByteKey(column(j), referenceScorer_).first;
+    });
+
+    if (ngramModel_ && length > 1)
+    {
+        refineSharedKeystream(columns, offsets, keystream, numThreads);
+    }
+
+    GeneralUtils::parallelFor(length, numThreads, [&](std::size_t j) {
+        confidence[j] =
+            referenceScorer_.score(ByteDistribution::histogram(column(j)), heights[j], keystream.secureData()[j]);
+    });
+
+    return std::make_pair(keystream, confidence);
+}
+
+template <XorScorer ReferenceScorer>
+void BasicDecryptorXor<ReferenceScorer>::refineSharedKeystream(const std::vector<std::uint8_t> &columns,
+                                                               const std::vector<std::size_t> &offsets,
+                                                               ByteData &keystream, std::size_t numThreads) const
+{
+    constexpr auto CLASSES = NGramModel::CLASSES;
+    constexpr auto BINS = ByteDistribution::BINS;
+    auto const &bigrams = ngramModel_->bigrams();
+
+    std::array<std::uint8_t, BINS> classOf;
+    for (std::size_t b = 0; b < classOf.size(); b++)
+    {
+        classOf[b] = NGramModel::classOf(static_cast<std::uint8_t>(b));
+    }
+
+    auto &keyBytes = keystream.secureData();
+    auto length = keyBytes.size();
+    auto height = [&](std::size_t j) { return offsets[j + 1] - offsets[j]; };
+
+    // only the keystream bytes of one parity change at a time, the neighbours of each of them stay fixed
+    std::vector<std::uint8_t> changed(length);
+    auto refine = [&](std::size_t position) {
+        // pairs of a neighbour class and a ciphered byte of this column are counted, then each value of the key byte
+        // costs a lookup per distinct pair instead of one per ciphertext
+        std::array<std::uint32_t, CLASSES * BINS> pairs;
+        std::array<double, BINS> logLikelihoods{};
+        auto const *current = columns.data() + offsets[position];
+
+        auto addNeighbour = [&](std::size_t neighbour, bool before) {
+            pairs.fill(0);
+            auto const *other = columns.data() + offsets[neighbour];
+            auto key = keyBytes[neighbour];
+            for (std::size_t row = 0, rows = std::min(height(position), height(neighbour)); row < rows; row++)
+            {
+                pairs[classOf[other[row] ^ key] * BINS + current[row]]++;
+            }
+
+            for (std::size_t pair = 0; pair < pairs.size(); pair++)
+            {
+                if (pairs[pair] == 0)
+                {
+                    continue;
+                }
+
+                auto neighbourClass = pair / BINS;
+                auto byte = pair % BINS;
+                for (std::size_t value = 0; value < BINS; value++)
+                {
+                    auto currentClass = classOf[byte ^ value];
+                    auto bigram = before ? bigrams[neighbourClass * CLASSES + currentClass]
+                                         : bigrams[currentClass * CLASSES + neighbourClass];
+                    logLikelihoods[value] += static_cast<double>(pairs[pair]) * bigram;
+                }
+            }
+        };
+
+        if (position > 0)
         {
-            continue;
+            addNeighbour(position - 1, true);
+        }
+        if (position + 1 < length)
+        {
+            addNeighbour(position + 1, false);
         }
 
-        double currHamming = 0.0;
-        double hammingIncr = 1.0 / static_cast<double>(rows.size());
+        auto best = std::max_element(logLikelihoods.begin(), logLikelihoods.end()) - logLikelihoods.begin();
+        changed[position] = logLikelihoods[static_cast<std::size_t>(best)] > logLikelihoods[keyBytes[position]];
+        if (changed[position])
+        {
+            keyBytes[position] = static_cast<std::uint8_t>(best);
+        }
+    };
 
-        for (std::size_t i = 0; i < rows.size(); i++)
+    for (std::size_t pass = 0; pass < MAX_REFINE_PASSES; pass++)
+    {
+        for (std::size_t parity = 0; parity < 2; parity++)
         {
-            currHamming += rows.at(i).hamming(rows.at((i + 1) % rows.size())) * hammingIncr;
+            GeneralUtils::parallelFor(GeneralUtils::ceil(length - parity, 2), numThreads,
+                                      [&](std::size_t i) { refine(2 * i + parity); });
         }
 
-        bestKeys.push(std::make_pair(tryKeySize, currHamming));
+        if (std::find(changed.begin(), changed.end(), 1) == changed.end())
+        {
+            break;
+        }
     }
+}
+
+template <XorScorer ReferenceScorer>
+typename BasicDecryptorXor<ReferenceScorer>::ColumnCounts
+BasicDecryptorXor<ReferenceScorer>::countColumns(ByteView cipheredData, const std::vector<std::size_t> &blocks,
+                                                 std::size_t keySize)
+{
+    ColumnCounts counts(keySize, ByteDistribution::Histogram{});
 
-    std::vector<std::size_t> result;
-    for (std::size_t i = 0; i < numberOfCandidatesToReturn; i++)
+    for (auto offset : blocks)
     {
-        result.push_back(std::get<0>(bestKeys.top()));
-        bestKeys.pop();
+        auto end = std::min(offset + SAMPLE_BLOCK, cipheredData.size());
+        for (std::size_t i = offset, column = offset % keySize; i < end; i++)
+        {
+            counts[column][cipheredData[i]]++;
+            if (++column == keySize)
+            {
+                column = 0;
+            }
+        }
     }
 
-    return result;
+    return counts;
 }
 
-double DecryptorXor::measureConfidence(const ByteData &decipheredData) const
+template <XorScorer ReferenceScorer>
+ByteData BasicDecryptorXor<ReferenceScorer>::solveColumns(const ColumnCounts &counts) const
 {
-    ByteDistribution curDistribution(decipheredData);
-    return curDistribution.distance(referenceLanguage_);
+    ByteData key(0, counts.size());
+
+    for (std::size_t column = 0; column < counts.size(); column++)
+    {
+        std::size_t total = 0;
+        for (auto count : counts[column])
+        {
+            total += count;
+        }
+
+        auto scores = scoreCounts(counts[column], total, referenceScorer_);
+        key.secureData()[column] =
+            static_cast<std::uint8_t>(std::min_element(scores.begin(), scores.end()) - scores.begin());
+    }
+
+    return key;
 }
 
-std::tuple<std::string, ByteData, double> DecryptorXor::decipherMultiKeySize(const ByteData &cipheredData,
-                                                                             std::size_t keySize) const
+template <XorScorer ReferenceScorer>
+double BasicDecryptorXor<ReferenceScorer>::measureSampleConfidence(ByteView cipheredData,
+                                                                   const std::vector<std::size_t> &blocks,
+                                                                   const ByteData &key) const
 {
-    LOGIC_ASSERT(keySize >= 2);
+    if (ngramModel_)
+    {
+        // the key starting at any position is a contiguous range of the key written twice
+        auto doubledKey = key + key;
+        double sum = 0;
+        std::size_t total = 0;
+        for (auto offset : blocks)
+        {
+            auto size = std::min(SAMPLE_BLOCK, cipheredData.size() - offset);
+            auto phasedKey = ByteView(doubledKey).subView(offset % key.size(), key.size());
+            sum += ngramModel_->score(cipheredData.subView(offset, size), phasedKey) * static_cast<double>(size);
+            total += size;
+        }
 
-    auto columns = cipheredData.extractColumns(keySize);
-    ByteData key;
+        return sum / static_cast<double>(total);
+    }
 
-    for (auto const &bd : columns)
+    // the deciphered bytes of a column are its ciphered bytes permuted by its key byte
+    ByteDistribution::Histogram deciphered{};
+    std::size_t total = 0;
+    auto counts = countColumns(cipheredData, blocks, key.size());
+    for (std::size_t column = 0; column < counts.size(); column++)
     {
-        auto [ignore, keyPart, confidence] = decipherSingle(bd);
-        key += keyPart;
+        for (std::size_t b = 0; b < ByteDistribution::BINS; b++)
+        {
+            deciphered[b ^ key.secureData()[column]] += counts[column][b];
+            total += counts[column][b];
+        }
     }
 
-    auto decipheredStr = (cipheredData ^ key);
-    auto confidence = measureConfidence(decipheredStr);
-    return std::make_tuple(decipheredStr.str(ByteData::Encoding::plain), key, confidence);
-}
\ No newline at end of file
+    return referenceScorer_.score(deciphered, total, 0);
+}
+
+template class BasicDecryptorXor<L1Scorer>;
+template class BasicDecryptorXor<ChiSquaredScorer>;
+template class BasicDecryptorXor<LogLikelihoodScorer>;
@@ -3,13 +3,32 @@
 
 #include "byte_data.h"
 #include "byte_distribution.h"
+#include "language_model.h"
+#include "matasano_asserts.h"
+#include "ngram_model.h"
+#include "top_k.h"
+#include "xor_scorers.h"
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 /**
  * A decryptor for various xor ciphers
+ *
+ * Every method that does not take a scorer scores with a ReferenceScorer of the reference language (@see XorScorer),
+ * L1Scorer by default (@see DecryptorXor). The scorer is a template parameter, so the loops over the keys and the
+ * measures of confidence are compiled for each scorer. The decryptor is compiled in decryptor_xor.cpp for L1Scorer,
+ * ChiSquaredScorer and LogLikelihoodScorer, any other XorScorer that is constructed from a LanguageModel can be added
  */
-class DecryptorXor
+template <XorScorer ReferenceScorer = L1Scorer>
+class BasicDecryptorXor
 {
 public:
     /**
@@ -19,15 +38,35 @@ public:
      * @param referenceLanguageData reference string in the language you believe your ciphered message is. Should be
      * long enough to make statistical analysis possible, the longer it is the more accurate analysis is going to be
      */
-    DecryptorXor(const std::string &referenceLanguageData);
+    BasicDecryptorXor(const std::string &referenceLanguageData);
+
+    /**
+     * @brief Construct a new Decryptor Xor object from a precompiled model of the language you believe your ciphered
+     * message is (@see LanguageModel), so the reference text does not have to be read and counted again
+     *
+     * @param model the model of the reference language
+     */
+    explicit BasicDecryptorXor(const LanguageModel &model);
+
+    /**
+     * @brief Construct a new Decryptor Xor object that also scores with a trigram model of the reference language. The
+     * byte distribution is still used to shortlist keys (and to solve the columns of multi byte keys, whose bytes are
+     * not adjacent in the text), but the shortlisted keys and whole deciphered texts are scored with the trigram model
+     * (@see NGramModel::score), which is much more accurate on short texts. The measures of confidence are then the
+     * trigram scores
+     *
+     * @param model the model of the reference language
+     * @param ngramModel trigram model of the same language, may be shared between decryptors
+     */
+    BasicDecryptorXor(const LanguageModel &model, std::shared_ptr<const NGramModel> ngramModel);
 
     /**
      * @brief Try to decipher given text that was ciphered with single byte key. Return the deciphered string, one byte
-     * key and measure of confidence. The deciphering is done by applying (xoring) all the possible key variants one by
-     * one and comparing the resulting characters distribution to the distribution of the reference data. The result
-     * that has the closest match will be selected as deciphered text. The measure of confidence is a floating point
-     * number, the smaller it is - the higher the confidence (can be used when comparing the results of deciphering
-     * different ciphered data)
+     * key and measure of confidence. The deciphering is done by scoring all the possible key variants one by one,
+     * comparing the resulting characters distribution to the distribution of the reference data (@see
+     * scoreSingleByteKeys). The key that has the closest match will be selected and only its deciphered text is built.
+     * The measure of confidence is a floating point number, the smaller it is - the higher the confidence (can be used
+     * when comparing the results of deciphering different ciphered data)
      *
      * @param cipheredText - one byte key ciphered text, can't be empty
      * @return deciphered text, one-byte xor key, measure of confidence
@@ -35,73 +74,475 @@ public:
      */
     std::tuple<std::string, std::uint8_t, double> decipherSingle(const ByteData &cipheredData) const;
 
+    /**
+     * @brief Same as decipherSingle, but the keys are scored with a given scorer instead of the reference scorer of
+     * this decryptor (and without the trigram model). The multi byte key and batch methods have no such version, they
+     * score with the ReferenceScorer the decryptor is compiled with
+     *
+     * @param cipheredText - one byte key ciphered text, can't be empty
+     * @param scorer - the scorer (@see XorScorer)
+     * @return deciphered text, one-byte xor key, the score of the key
+     * @throw std::invalid_argument if cipheredText is empty
+     */
+    template <XorScorer Scorer>
+    static std::tuple<std::string, std::uint8_t, double> decipherSingle(const ByteData &cipheredData,
+                                                                        const Scorer &scorer);
+
+    /**
+     * @brief Finds which of the given ciphered texts were most likely ciphered with single byte key (@see
+     * decipherSingle). Each text is scored with its best key, and the best 'topK' texts are returned, best first. Only
+     * the scores are computed, decipher the returned texts with their keys to get the deciphered texts
+     *
+     * @param cipheredData - one byte key ciphered texts. Empty ones are skipped
+     * @param topK - the maximum number of results to return
+     * @param numThreads - the number of threads to score the texts with, 0 for the number of hardware threads. The
+     * result does not depend on it
+     *
+     * @return index of the text in cipheredData, one-byte xor key, measure of confidence. Sorted by the measure of
+     * confidence (ties by index)
+     */
+    std::vector<std::tuple<std::size_t, std::uint8_t, double>>
+    decipherSingleBatch(std::span<const ByteView> cipheredData, std::size_t topK = 1, std::size_t numThreads = 1) const;
+
+    /**
+     * @brief Ranks the possible key sizes of data that was ciphered with multi byte key. For key size k the data is
+     * split into rows of k bytes (the last partial row is ignored), and the score is the hamming distance between each
+     * row and the next one (the last row with the first one), normalized per byte. Rows that were xored with the right
+     * key size differ only as much as the plain text does, so the smaller the score - the more likely the key size
+     * The distances are computed for all the key sizes in one pass over the data, in blocks that stay in the cache
+     *
+     * @param cipheredData - the ciphered data
+     * @param keySizeRange - the range of possible key sizes [min, max]. Should be non empty and not include 0
+     *
+     * @return key size and its score for all the key sizes in the range that have at least 2 rows, sorted by the score
+     * (ties by the key size)
+     * @throw std::invalid_argument if range is not according to what is defined above
+     */
+    static std::vector<std::pair<std::size_t, double>>
+    rankKeySizes(ByteView cipheredData, const std::pair<std::size_t, std::size_t> &keySizeRange);
+
+    /**
+     * @brief Measure of confidence (@see decipherSingle) of each of the 256 single byte keys for a given ciphered data
+     * The ciphered data is counted once, each key is scored by permuting the counts, so the cost does not depend on
+     * the key count times the data length
+     *
+     * @param cipheredData one byte key ciphered data
+     * @return measure of confidence of each key, indexed by the key. The lower it is - the higher the confidence
+     */
+    std::array<double, 256> scoreSingleByteKeys(ByteView cipheredData) const;
+
+    /**
+     * @brief Score of each of the 256 single byte keys for a given ciphered data with a given scorer. The ciphered
+     * data is counted once and the loop over the keys is compiled for each scorer
+     *
+     * @param cipheredData one byte key ciphered data
+     * @param scorer the scorer (@see XorScorer)
+     * @return score of each key, indexed by the key. The lower it is - the higher the confidence
+     */
+    template <XorScorer Scorer>
+    static std::array<double, 256> scoreSingleByteKeys(ByteView cipheredData, const Scorer &scorer);
+
+    /**
+     * @brief The best 'topK' single byte keys (@see decipherSingle) for a given ciphered data, without deciphering it
+     *
+     * @param cipheredData - one byte key ciphered data
+     * @param topK - the maximum number of keys to return
+     *
+     * @return key and its measure of confidence, sorted by the measure of confidence (ties by key)
+     */
+    std::vector<std::pair<std::uint8_t, double>> rankSingleByteKeys(ByteView cipheredData, std::size_t topK) const;
+
+    /**
+     * @brief Same as rankSingleByteKeys, with a given scorer
+     *
+     * @param cipheredData - one byte key ciphered data
+     * @param topK - the maximum number of keys to return
+     * @param scorer - the scorer (@see XorScorer)
+     *
+     * @return key and its score, sorted by the score (ties by key)
+     */
+    template <XorScorer Scorer>
+    static std::vector<std::pair<std::uint8_t, double>> rankSingleByteKeys(ByteView cipheredData, std::size_t topK,
+                                                                           const Scorer &scorer);
+
+    /**
+     * @brief The best 'topK' candidates for each byte of a multi byte key of a given size. Byte i of the key is
+     * scored against the column of the bytes that were xored with it (@see rankSingleByteKeys)
+     *
+     * @param cipheredData - multi byte key ciphered data, can't be empty
+     * @param keySize - the key size, can't be 0
+     * @param topK - the maximum number of candidates to return for each key byte
+     *
+     * @return the candidates for each byte of the key (less than keySize if the data is shorter than the key)
+     * @throw std::invalid_argument if cipheredData is empty or keySize is 0
+     */
+    std::vector<std::vector<std::pair<std::uint8_t, double>>>
+    rankColumnKeys(const ByteData &cipheredData, std::size_t keySize, std::size_t topK) const;
+
+    /**
+     * @brief The best 'topK' multi byte keys (@see decipherMulti). The best 'topK' key sizes are solved (@see
+     * rankKeySizes), each one with the best byte for every column, and the keys are ranked by the measure of confidence
+     * of the whole deciphered data. Only the keys are returned, the deciphered strings are not built
+     *
+     * @param cipheredData - multi byte key ciphered data, can't be empty
+     * @param keySizeRange - the range of possible key sizes to try (@see decipherMulti)
+     * @param topK - the maximum number of keys to return
+     * @param numThreads - the number of threads to solve the key columns with, 0 for the number of hardware threads.
+     * The result does not depend on it
+     *
+     * @return key and its measure of confidence, sorted by the measure of confidence (ties by the shorter key)
+     * @throw std::invalid_argument if range is not according to what is defined in decipherMulti
+     */
+    std::vector<std::pair<ByteData, double>> rankMultiByteKeys(const ByteData &cipheredData,
+                                                               const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                               std::size_t topK, std::size_t numThreads = 1) const;
+
     /**
      * @brief Try to decipher given text that was ciphered with multi byte key. Return the deciphered string, multi byte
      * key and measure of confidence. The deciphering is done by first detecting the key size, then guessing each byte
      * of the key separately, using 'decipherSingle' against corresponding part of the encrypted data that was xored
-     * with this specific byte of the key. The measure of confidence is a floating point number, the smaller it is - the
-     * higher the confidence (can be used when comparing the results of deciphering different ciphered data)
+     * with this specific byte of the key. The best 3 key sizes are tried (@see rankMultiByteKeys for more candidates).
+     * The measure of confidence is a floating point number, the smaller it is - the higher the confidence (can be used
+     * when comparing the results of deciphering different ciphered data)
      *
      * @param cipheredText - one byte key ciphered text, can't be empty
      * @param keySizeRange - the range of possible key sizes to try. The minimum should be no less than 2. The maximum
      * should be bigger than minimum. Max key size should be small enough compared to cipheredData size, otherwise
      * chances of decrypting the text correctly - are low
+     * @param numThreads - the number of threads to solve the key columns of all the candidate key sizes with, 0 for
+     * the number of hardware threads. The result does not depend on it
      *
      * @return deciphered text, multi-byte xor key, measure of confidence
      * @throw std::invalid_argument if range is not according to what is defined above or if cipheredText is empty
      */
-    std::tuple<std::string, ByteData, double>
-    decipherMulti(const ByteData &cipheredData, const std::pair<std::size_t, std::size_t> &keySizeRange) const;
+    std::tuple<std::string, ByteData, double> decipherMulti(const ByteData &cipheredData,
+                                                            const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                            std::size_t numThreads = 1) const;
+
+    /**
+     * @brief Improves a multi byte key by hill climbing. The bytes of a key that were solved column by column (@see
+     * decipherMulti) are each the best for their own column, but the columns are never looked at together. Here every
+     * key byte in turn is replaced with the value that maximizes the bigram log likelihood of the whole deciphered
+     * data (@see NGramModel::bigrams), until a full pass over the key changes nothing. Only the bigrams around the
+     * bytes xored with the changed key byte are scored, so each pass costs 256 bigram lookups per ciphered byte, the
+     * whole deciphered data is never scored again. Needs the trigram model (which has the bigram table), the
+     * decryptors that have it refine the keys of decipherMulti and rankMultiByteKeys with this
+     *
+     * @param cipheredData - multi byte key ciphered data
+     * @param key - the initial key, at least 2 bytes long
+     * @return the refined key, the same size as key
+     * @throw std::invalid_argument if key is shorter than 2 bytes
+     * @throw std::logic_error if this decryptor has no trigram model
+     */
+    ByteData refineMultiByteKey(ByteView cipheredData, const ByteData &key) const;
 
-private:
     /**
-     * reference language distribution. Used to 'guess' whether we deciphered the given byte data vector correctly
+     * @brief default number of bytes in each of the samples of estimateMultiByteKey
      */
-    ByteDistribution referenceLanguage_;
+    static constexpr std::size_t DEFAULT_SAMPLE_SIZE = 1024 * 1024;
 
     /**
-     * @brief Tries to guess the key size with which the given ByteData was ciphered.The idea is to try various key
-     * sizes consequently and see for which blocks do we have the least hamming distance. Since this is pretty
-     * innacurate, a couple of best key sizes will be returned and tried out
+     * @brief default fraction of the key bytes the samples of decipherMultiFile should agree on
+     */
+    static constexpr double DEFAULT_MIN_AGREEMENT = 1.0;
+
+    /**
+     * @brief Estimates the key of data that was ciphered with multi byte key from samples of it, so the cost depends
+     * on the sample size and not on the data size (@see decipherMulti for the method). The samples are blocks spread
+     * evenly over the data. The key size and the key are estimated from the first sample, then the key is estimated
+     * again from a second sample of other blocks, and the two estimates are compared. The returned key is the one of
+     * the first sample, the agreement tells how much of it the second sample confirms. If the data is too short for two
+     * samples, its blocks are split between the two
      *
-     * @param cipheredData - the ciphered object
-     * @param keySizeRange - the range of possible key sizes to try. The minimum should be no less than 2. The
-     * maximum should be bigger than minimum. Max key size should be small enough compared to cipheredData size,
-     * otherwise chances of decrypting the text correctly - are low
-     * @param numberOfCandidatesToReturn - the number of candidate key sizes to be in the resulting vector
+     * @param cipheredData - multi byte key ciphered data, can't be empty
+     * @param keySizeRange - the range of possible key sizes to try (@see decipherMulti)
+     * @param sampleSize - number of bytes in each of the samples, rounded up to whole blocks of 16 KiB
+     * @param numThreads - the number of threads to rank the key sizes with, 0 for the number of hardware threads. The
+     * result does not depend on it
      *
-     * @return the vector of best 'numberOfCandidatesToReturn' key sizes
-     * @throw std::invalid_argument if range is not according to what is defined above
+     * @return the key, measure of confidence of it on both samples, and the fraction of the key bytes the two samples
+     * agree on (1 if the data is a single block, there is nothing to compare it with then). If none of the key sizes
+     * fits the data, the key is empty, the confidence is the maximal double and the agreement is 0
+     * @throw std::invalid_argument if range is not according to what is defined in decipherMulti, if cipheredText is
+     * empty or if sampleSize is 0
+     */
+    std::tuple<ByteData, double, double> estimateMultiByteKey(ByteView cipheredData,
+                                                              const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                              std::size_t sampleSize = DEFAULT_SAMPLE_SIZE,
+                                                              std::size_t numThreads = 1) const;
+
+    /**
+     * @brief Deciphers a file that was ciphered with multi byte key into another file. The key is estimated from
+     * samples of the mapped file (@see estimateMultiByteKey) and has to be confirmed by the second sample, only then
+     * the whole file is deciphered as a stream (@see XorStream::xorFile), it is never read into memory
+     *
+     * @param inFileName - the ciphered file, can't be empty
+     * @param outFileName - the file to write the deciphered data to, overwritten if exists
+     * @param keySizeRange - the range of possible key sizes to try (@see decipherMulti)
+     * @param sampleSize - number of bytes in each of the samples
+     * @param numThreads - the number of threads to rank the key sizes with
+     * @param minAgreement - the minimal fraction of the key bytes the second sample should confirm, all of them by
+     * default
+     *
+     * @return the confirmed key, measure of confidence and agreement of the samples (@see estimateMultiByteKey)
+     * @throw std::ios_base::failure if the files can't be opened, created or mapped
+     * @throw std::invalid_argument same as estimateMultiByteKey, or if none of the key sizes fits the file, or the
+     * samples agree on less than minAgreement of the key. Nothing is written then
      */
-    std::vector<std::size_t> guessKeySize(const ByteData &cipheredData,
-                                          const std::pair<std::size_t, std::size_t> &keySizeRange,
-                                          std::size_t numberOfCandidatesToReturn = 3) const;
+    std::tuple<ByteData, double, double> decipherMultiFile(const std::string &inFileName,
+                                                           const std::string &outFileName,
+                                                           const std::pair<std::size_t, std::size_t> &keySizeRange,
+                                                           std::size_t sampleSize = DEFAULT_SAMPLE_SIZE,
+                                                           std::size_t numThreads = 1,
+                                                           double minAgreement = DEFAULT_MIN_AGREEMENT) const;
 
     /**
-     * @brief Measures level of confidence whether a given deciphered data resembles a referenced language
-     * The confidence is actually a distance between distribution of referenced language and distribution of deciphered
-     * data
+     * @brief Recovers the keystream of ciphertexts that were all ciphered with the same keystream (a reused one-time
+     * pad, or a stream cipher like CTR with a fixed nonce). Byte j of every ciphertext was xored with keystream byte
+     * j, so the bytes at position j of all the ciphertexts form a column that was ciphered with a single byte key,
+     * the same way the columns of a multi byte key are in decipherMulti. The ciphertexts are transposed into one
+     * contiguous buffer, column after column, and the columns are solved in parallel (@see bestSingleByteKey). The
+     * ciphertexts may have different lengths: the columns past the end of the shorter ones are shorter, and the
+     * keystream is as long as the longest ciphertext. With a trigram model the keystream is then refined the same
+     * way as in refineMultiByteKey, with the bigrams across neighbouring columns of each ciphertext
+     *
+     * Meant for corpora of up to millions of short ciphertexts: the cost is a transposition and a byte count of the
+     * ciphertexts, plus a fixed cost per keystream byte
      *
-     * @param decipheredData deciphered data
+     * @param cipheredData - the ciphertexts, empty ones are allowed
+     * @param numThreads - the number of threads, 0 for the number of hardware threads. The result does not depend on it
+     *
+     * @return the keystream and the measure of confidence of each of its bytes (the score of its column deciphered
+     * with it by the byte distribution, @see scoreSingleByteKeys). The confidence of the bytes past the first few
+     * ciphertexts is low, there are few bytes in their columns
+     */
+    std::pair<ByteData, std::vector<double>> decipherSharedKeystream(std::span<const ByteView> cipheredData,
+                                                                     std::size_t numThreads = 1) const;
+
+private:
+    /**
+     * number of texts scored by one task in decipherSingleBatch
+     */
+    static constexpr std::size_t BATCH_CHUNK_SIZE = 1024;
+
+    /**
+     * number of bytes rankKeySizes compares for all the key sizes before moving on
+     */
+    static constexpr std::size_t KEY_SIZE_BLOCK = 16 * 1024;
+
+    /**
+     * number of the best single byte keys by the byte distribution that are rescored with the trigram model
+     */
+    static constexpr std::size_t NGRAM_CANDIDATES = 8;
+
+    /**
+     * the maximum number of passes over the key in refineMultiByteKey, it stops much sooner in practice
+     */
+    static constexpr std::size_t MAX_REFINE_PASSES = 64;
+
+    /**
+     * number of bytes in each of the blocks estimateMultiByteKey samples
+     */
+    static constexpr std::size_t SAMPLE_BLOCK = 16 * 1024;
+
+    /**
+     * number of keystream columns decipherSharedKeystream transposes in one task
+     */
+    static constexpr std::size_t TRANSPOSE_TILE = 64;
+
+    /**
+     * byte counts of each column of a key (the bytes that were xored with the same key byte)
+     */
+    using ColumnCounts = std::vector<ByteDistribution::Histogram>;
+
+    /**
+     * scores by the reference language distribution. Used to 'guess' whether we deciphered the given byte data vector
+     * correctly. Every method that does not take a scorer scores with it
+     */
+    ReferenceScorer referenceScorer_;
+
+    /**
+     * trigram model of the reference language, null if the decryptor scores with the byte distribution only
+     */
+    std::shared_ptr<const NGramModel> ngramModel_;
+
+    /**
+     * @brief Measures level of confidence whether given data deciphered with a given key resembles a referenced
+     * language. The confidence is the trigram score of the deciphered data if there is a trigram model, otherwise a
+     * distance between distribution of referenced language and distribution of deciphered data
+     *
+     * @param cipheredData ciphered data
+     * @param key the key that is applied cyclically
      * @return double measure of confidence, the lower it is - the higher the confidence
      */
-    double measureConfidence(const ByteData &decipheredData) const;
+    double measureConfidence(const ByteData &cipheredData, const ByteData &key) const;
+
+    /**
+     * @brief The best single byte key for a given ciphered text (@see decipherSingle). Same as bestSingleByteKey,
+     * except that with a trigram model the best keys by the byte distribution are rescored with it
+     *
+     * @param cipheredData one byte key ciphered text
+     * @return the key and its measure of confidence
+     */
+    std::pair<std::uint8_t, double> bestTextKey(ByteView cipheredData) const;
 
     /**
-     * @brief Try to decipher given text that was ciphered with multi byte key with specific size. Return the deciphered
-     * string, multi byte key and measure of confidence. The deciphering is done by guessing each byte of the key
-     * separately, using 'decipherSingle' against corresponding part of the encrypted data that was xored with this
-     * specific byte of the key. The measure of confidence is a floating point number, the smaller it is - the higher
-     * the confidence (can be used when comparing the results of deciphering different ciphered data)
+     * @brief The best single byte key (@see decipherSingle) for a given ciphered data, without deciphering it
+     *
+     * @param cipheredData one byte key ciphered data
+     * @param scorer the scorer (@see XorScorer)
+     * @return the key and its score
+     */
+    template <XorScorer Scorer>
+    static std::pair<std::uint8_t, double> bestSingleByteKey(ByteView cipheredData, const Scorer &scorer);
+
+    /**
+     * @brief Score of each of the 256 single byte keys for data with the given byte counts (@see scoreSingleByteKeys)
+     *
+     * @param counts the byte counts of the ciphered data
+     * @param total the number of bytes in the ciphered data
+     * @param scorer the scorer (@see XorScorer)
+     * @return score of each key, indexed by the key
+     */
+    template <XorScorer Scorer>
+    static std::array<double, 256> scoreCounts(const ByteDistribution::Histogram &counts, std::size_t total,
+                                               const Scorer &scorer);
+
+    /**
+     * @brief Try to decipher given text that was ciphered with multi byte key, for each of the given key sizes. Return
+     * the multi byte key and measure of confidence for each key size. The deciphering is done by guessing each byte of
+     * the key separately, using 'bestSingleByteKey' against corresponding part of the encrypted data that was xored
+     * with this specific byte of the key. The measure of confidence is a floating point number, the smaller it is - the
+     * higher the confidence (can be used when comparing the results of deciphering different ciphered data)
+     * All the key columns of all the key sizes are independent, so they are spread over numThreads threads
      *
      * @param cipheredText - one byte key ciphered text, can't be empty
-     * @param keySize - The specific key size to try. Assumed to be larger equal than 2
+     * @param keySizes - The specific key sizes to try. Assumed to be larger equal than 2
+     * @param numThreads - the number of threads, 0 for the number of hardware threads
      *
-     * @return deciphered text, multi-byte xor key, measure of confidence
-     * @throw std::invalid_argument if range is not according to what is defined above or if cipheredText is empty
+     * @return multi-byte xor key, measure of confidence for each of keySizes (in the same order)
+     */
+    std::vector<std::pair<ByteData, double>> decipherMultiKeySizes(const ByteData &cipheredData,
+                                                                   const std::vector<std::size_t> &keySizes,
+                                                                   std::size_t numThreads) const;
+
+    /**
+     * @brief Counts the bytes of each key column in the given blocks of data. The column of a byte is its position in
+     * the whole data modulo the key size, so the blocks may start anywhere
+     *
+     * @param cipheredData - the ciphered data
+     * @param blocks - offsets of the blocks, each one is SAMPLE_BLOCK bytes long (or up to the end of the data)
+     * @param keySize - the key size
+     * @return the counts of each column
+     */
+    static ColumnCounts countColumns(ByteView cipheredData, const std::vector<std::size_t> &blocks,
+                                     std::size_t keySize);
+
+    /**
+     * @brief The best key for the given column counts, each byte is solved on its own (@see bestSingleByteKey)
+     *
+     * @param counts - the counts of each column
+     * @return the key
+     */
+    ByteData solveColumns(const ColumnCounts &counts) const;
+
+    /**
+     * @brief Refines a shared keystream (@see decipherSharedKeystream) by hill climbing with the bigrams of the
+     * trigram model, like refineMultiByteKey. Keystream byte j changes the bigrams between columns j - 1, j and j + 1
+     * only, so the even bytes are refined in parallel, then the odd ones, and so on until nothing changes
+     *
+     * @param columns - the transposed ciphertexts, the longest first. Row r of every column is the same ciphertext
+     * @param offsets - offset of each column in columns, and the size of columns at the end
+     * @param keystream - the keystream to refine, one byte per column
+     * @param numThreads - the number of threads
+     */
+    void refineSharedKeystream(const std::vector<std::uint8_t> &columns, const std::vector<std::size_t> &offsets,
+                               ByteData &keystream, std::size_t numThreads) const;
+
+    /**
+     * @brief Measure of confidence (@see measureConfidence) of the given blocks of data deciphered with a given key
+     *
+     * @param cipheredData - the ciphered data
+     * @param blocks - offsets of the blocks, each one is SAMPLE_BLOCK bytes long (or up to the end of the data)
+     * @param key - the key, applied cyclically from the start of the whole data
+     * @return double measure of confidence, the lower it is - the higher the confidence
      */
-    std::tuple<std::string, ByteData, double> decipherMultiKeySize(const ByteData &cipheredData,
-                                                                   std::size_t keySize) const;
+    double measureSampleConfidence(ByteView cipheredData, const std::vector<std::size_t> &blocks,
+                                   const ByteData &key) const;
 };
 
+/**
+ * @brief the decryptor that scores with the L1 distance from the reference language
+ */
+using DecryptorXor = BasicDecryptorXor<>;
+
+template <XorScorer ReferenceScorer>
+template <XorScorer Scorer>
+std::tuple<std::string, std::uint8_t, double>
+BasicDecryptorXor<ReferenceScorer>::decipherSingle(const ByteData &cipheredData, const Scorer &scorer)
+{
+    THROW_IF(cipheredData.size() == 0, "cipheredData is empty", std::invalid_argument);
+
+    auto [key, confidence] = bestSingleByteKey(cipheredData, scorer);
+
+    return std::make_tuple((cipheredData ^ ByteData(key)).str(ByteData::Encoding::plain), key, confidence);
+}
+
+template <XorScorer ReferenceScorer>
+template <XorScorer Scorer>
+std::array<double, 256> BasicDecryptorXor<ReferenceScorer>::scoreSingleByteKeys(ByteView cipheredData,
+                                                                                const Scorer &scorer)
+{
+    return scoreCounts(ByteDistribution::histogram(cipheredData), cipheredData.size(), scorer);
+}
+
+template <XorScorer ReferenceScorer>
+template <XorScorer Scorer>
+std::array<double, 256> BasicDecryptorXor<ReferenceScorer>::scoreCounts(const ByteDistribution::Histogram &counts,
+                                                                        std::size_t total, const Scorer &scorer)
+{
+    std::array<double, 256> scores;
+    for (std::size_t key = 0; key < scores.size(); key++)
+    {
+        scores[key] = scorer.score(counts, total, static_cast<std::uint8_t>(key));
+    }
+
+    return scores;
+}
+
+template <XorScorer ReferenceScorer>
+template <XorScorer Scorer>
+std::vector<std::pair<std::uint8_t, double>>
+BasicDecryptorXor<ReferenceScorer>::rankSingleByteKeys(ByteView cipheredData, std::size_t topK, const Scorer &scorer)
+{
+    auto scores = scoreSingleByteKeys(cipheredData, scorer);
+
+    TopK<std::pair<double, std::uint8_t>> best(topK);
+    for (std::size_t key = 0; key < scores.size(); key++)
+    {
+        best.push(std::make_pair(scores[key], static_cast<std::uint8_t>(key)));
+    }
+
+    std::vector<std::pair<std::uint8_t, double>> result;
+    for (auto [score, key] : best.extractSorted())
+    {
+        result.emplace_back(key, score);
+    }
+
+    return result;
+}
+
+template <XorScorer ReferenceScorer>
+template <XorScorer Scorer>
+std::pair<std::uint8_t, double> BasicDecryptorXor<ReferenceScorer>::bestSingleByteKey(ByteView cipheredData,
+                                                                                      const Scorer &scorer)
+{
+    auto scores = scoreSingleByteKeys(cipheredData, scorer);
+
+    // the first of the best keys, same as trying the keys one by one in order
+    auto best = std::min_element(scores.begin(), scores.end());
+
+    return std::make_pair(static_cast<std::uint8_t>(best - scores.begin()), *best);
+}
+
 #endif
\ No newline at end of file
@@ -19,8 +19,7 @@ std::string FileUtils::read(const std::string &fileName, bool ignoreEOLs)
 
     if (ignoreEOLs)
     {
-        res.erase(std::remove(res.begin(), res.end(), '\n'), res.end());
-        res.erase(std::remove(res.begin(), res.end(), '\r'), res.end());
+        std::erase_if(res, [](char c) { return c == '\n' || c == '\r'; });
     }
 
     return res;
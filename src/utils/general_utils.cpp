@@ -14,4 +14,14 @@ ByteData GeneralUtils::randomData(std::size_t length)
     return res;
 }
 
-std::size_t GeneralUtils::ceil(std::size_t a, std::size_t b) { return a / b + (a % b != 0); }
\ No newline at end of file
+std::size_t GeneralUtils::ceil(std::size_t a, std::size_t b) { return a / b + (a % b != 0); }
+
+std::size_t GeneralUtils::threadCount(std::size_t numThreads)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::thread::hardware_concurrency();
+    }
+
+    return std::max(numThreads, std::size_t{1});
+}
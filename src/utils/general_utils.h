@@ -1,10 +1,16 @@
 #ifndef MATASANO_GENERAL_UTILS_H
 #define MATASANO_GENERAL_UTILS_H
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <mutex>
 #include <random>
 #include <string.h>
+#include <thread>
+#include <vector>
 
 #include "byte_data.h"
 #include "matasano_asserts.h"
@@ -55,6 +61,76 @@ ByteData randomData(std::size_t length);
  */
 std::size_t ceil(std::size_t a, std::size_t b);
 
+/**
+ * @brief The number of threads to use for a given requested number of threads
+ *
+ * @param numThreads requested number of threads, 0 for the number of hardware threads
+ * @return the number of threads, at least 1
+ */
+std::size_t threadCount(std::size_t numThreads);
+
+/**
+ * @brief Calls f(i) for every i in [0, count), spread over up to numThreads threads. Returns when all the calls are
+ * done. With 1 thread (or a single call) everything runs in the calling thread, in order
+ * The calls should be independent of each other, the typical use is to fill the i-th element of a presized vector
+ *
+ * @param count the number of calls
+ * @param numThreads the maximum number of threads, 0 for the number of hardware threads
+ * @param f callable that accepts std::size_t
+ *
+ * @throw the first exception thrown by f, the rest of the calls that did not start yet are skipped
+ */
+template <typename F> void parallelFor(std::size_t count, std::size_t numThreads, F &&f)
+{
+    auto workers = std::min(threadCount(numThreads), count);
+    if (workers <= 1)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            f(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto work = [&]() {
+        for (auto i = next++; i < count; i = next++)
+        {
+            try
+            {
+                f(i);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(errorMutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                next = count;
+            }
+        }
+    };
+
+    // the calling thread is one of the workers
+    std::vector<std::jthread> threads;
+    threads.reserve(workers - 1);
+    for (std::size_t i = 0; i + 1 < workers; i++)
+    {
+        threads.emplace_back(work);
+    }
+    work();
+    threads.clear();
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
 } // namespace GeneralUtils
 
 #endif
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "aes_ni_kernel.h"
+#include "cpu_features.h"
+#include "matasano_asserts.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef MATASANO_X86
+#include <immintrin.h>
+#endif
+
+#ifdef MATASANO_X86
+
+namespace
+{
+constexpr std::size_t ROUND_KEYS = AesNiKernel::ROUNDS + 1;
+
+/**
+ * @brief the next round key of the AES-128 key expansion, generated is AESKEYGENASSIST of the previous round key
+ */
+__attribute__((target("aes,sse4.1"))) inline __m128i expandRoundKey(__m128i key, __m128i generated)
+{
+    generated = _mm_shuffle_epi32(generated, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+
+    return _mm_xor_si128(key, generated);
+}
+
+/**
+ * @brief expands the key into the encryption round keys, then the decryption round keys (@see roundKeys_)
+ */
+__attribute__((target("aes,sse4.1"))) void expandKey(const std::uint8_t *key, std::uint8_t *roundKeys)
+{
+    // the round constant of AESKEYGENASSIST has to be an immediate
+    __m128i keys[ROUND_KEYS];
+    keys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key));
+    keys[1] = expandRoundKey(keys[0], _mm_aeskeygenassist_si128(keys[0], 0x01));
+    keys[2] = expandRoundKey(keys[1], _mm_aeskeygenassist_si128(keys[1], 0x02));
+    keys[3] = expandRoundKey(keys[2], _mm_aeskeygenassist_si128(keys[2], 0x04));
+    keys[4] = expandRoundKey(keys[3], _mm_aeskeygenassist_si128(keys[3], 0x08));
+    keys[5] = expandRoundKey(keys[4], _mm_aeskeygenassist_si128(keys[4], 0x10));
+    keys[6] = expandRoundKey(keys[5], _mm_aeskeygenassist_si128(keys[5], 0x20));
+    keys[7] = expandRoundKey(keys[6], _mm_aeskeygenassist_si128(keys[6], 0x40));
+    keys[8] = expandRoundKey(keys[7], _mm_aeskeygenassist_si128(keys[7], 0x80));
+    keys[9] = expandRoundKey(keys[8], _mm_aeskeygenassist_si128(keys[8], 0x1b));
+    keys[10] = expandRoundKey(keys[9], _mm_aeskeygenassist_si128(keys[9], 0x36));
+
+    auto *encryption = reinterpret_cast<__m128i *>(roundKeys);
+    auto *decryption = encryption + ROUND_KEYS;
+    for (std::size_t round = 0; round < ROUND_KEYS; round++)
+    {
+        _mm_storeu_si128(encryption + round, keys[round]);
+    }
+
+    // the equivalent inverse cipher: the round keys in reverse, the middle ones through InvMixColumns
+    _mm_storeu_si128(decryption, keys[AesNiKernel::ROUNDS]);
+    for (std::size_t round = 1; round < AesNiKernel::ROUNDS; round++)
+    {
+        _mm_storeu_si128(decryption + round, _mm_aesimc_si128(keys[AesNiKernel::ROUNDS - round]));
+    }
+    _mm_storeu_si128(decryption + AesNiKernel::ROUNDS, keys[0]);
+
+    for (auto &roundKey : keys)
+    {
+        roundKey = _mm_setzero_si128();
+    }
+}
+
+/**
+ * @brief the round keys loaded into registers once per call. The loops over the rounds and the blocks below are fully
+ * unrolled, so the round keys and the blocks in flight stay in registers instead of going through the stack
+ */
+struct RoundKeys
+{
+    __m128i keys[ROUND_KEYS];
+};
+
+__attribute__((target("aes,sse4.1"))) inline RoundKeys loadRoundKeys(const std::uint8_t *roundKeys)
+{
+    RoundKeys result;
+#pragma GCC unroll 16
+    for (std::size_t round = 0; round < ROUND_KEYS; round++)
+    {
+        result.keys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(roundKeys) + round);
+    }
+
+    return result;
+}
+
+/**
+ * @brief encrypts one block
+ */
+__attribute__((target("aes,sse4.1"))) inline __m128i encryptBlock(__m128i block, const RoundKeys &keys)
+{
+    block = _mm_xor_si128(block, keys.keys[0]);
+#pragma GCC unroll 16
+    for (std::size_t round = 1; round < AesNiKernel::ROUNDS; round++)
+    {
+        block = _mm_aesenc_si128(block, keys.keys[round]);
+    }
+
+    return _mm_aesenclast_si128(block, keys.keys[AesNiKernel::ROUNDS]);
+}
+
+/**
+ * @brief decrypts one block with the decryption round keys
+ */
+__attribute__((target("aes,sse4.1"))) inline __m128i decryptBlock(__m128i block, const RoundKeys &keys)
+{
+    block = _mm_xor_si128(block, keys.keys[0]);
+#pragma GCC unroll 16
+    for (std::size_t round = 1; round < AesNiKernel::ROUNDS; round++)
+    {
+        block = _mm_aesdec_si128(block, keys.keys[round]);
+    }
+
+    return _mm_aesdeclast_si128(block, keys.keys[AesNiKernel::ROUNDS]);
+}
+
+/**
+ * @brief encrypts INTERLEAVE blocks together: every round is applied to all of them before the next one, so the
+ * AESENC instructions of different blocks do not wait for each other
+ */
+__attribute__((target("aes,sse4.1"))) inline void encryptBlocks(__m128i *blocks, const RoundKeys &keys)
+{
+#pragma GCC unroll 16
+    for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+    {
+        blocks[i] = _mm_xor_si128(blocks[i], keys.keys[0]);
+    }
+#pragma GCC unroll 16
+    for (std::size_t round = 1; round < AesNiKernel::ROUNDS; round++)
+    {
+#pragma GCC unroll 16
+        for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            blocks[i] = _mm_aesenc_si128(blocks[i], keys.keys[round]);
+        }
+    }
+#pragma GCC unroll 16
+    for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+    {
+        blocks[i] = _mm_aesenclast_si128(blocks[i], keys.keys[AesNiKernel::ROUNDS]);
+    }
+}
+
+/**
+ * @brief decryption version of encryptBlocks
+ */
+__attribute__((target("aes,sse4.1"))) inline void decryptBlocks(__m128i *blocks, const RoundKeys &keys)
+{
+#pragma GCC unroll 16
+    for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+    {
+        blocks[i] = _mm_xor_si128(blocks[i], keys.keys[0]);
+    }
+#pragma GCC unroll 16
+    for (std::size_t round = 1; round < AesNiKernel::ROUNDS; round++)
+    {
+#pragma GCC unroll 16
+        for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            blocks[i] = _mm_aesdec_si128(blocks[i], keys.keys[round]);
+        }
+    }
+#pragma GCC unroll 16
+    for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+    {
+        blocks[i] = _mm_aesdeclast_si128(blocks[i], keys.keys[AesNiKernel::ROUNDS]);
+    }
+}
+
+__attribute__((target("aes,sse4.1"))) inline __m128i load(const std::uint8_t *data, std::size_t block)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data) + block);
+}
+
+__attribute__((target("aes,sse4.1"))) inline void store(std::uint8_t *data, std::size_t block, __m128i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data) + block, value);
+}
+
+/**
+ * @brief ECB encryption / decryption of whole blocks, INTERLEAVE at a time and then one by one
+ */
+template <bool ENCRYPT>
+__attribute__((target("aes,sse4.1"))) void processEcb(const std::uint8_t *roundKeys, const std::uint8_t *in,
+                                                      std::size_t blocks, std::uint8_t *out)
+{
+    auto keys = loadRoundKeys(roundKeys);
+
+    std::size_t done = 0;
+    for (; done + AesNiKernel::INTERLEAVE <= blocks; done += AesNiKernel::INTERLEAVE)
+    {
+        __m128i batch[AesNiKernel::INTERLEAVE];
+#pragma GCC unroll 16
+        for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            batch[i] = load(in, done + i);
+        }
+
+        if constexpr (ENCRYPT)
+        {
+            encryptBlocks(batch, keys);
+        }
+        else
+        {
+            decryptBlocks(batch, keys);
+        }
+#pragma GCC unroll 16
+        for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            store(out, done + i, batch[i]);
+        }
+    }
+
+    for (; done < blocks; done++)
+    {
+        store(out, done, ENCRYPT ? encryptBlock(load(in, done), keys) : decryptBlock(load(in, done), keys));
+    }
+}
+
+__attribute__((target("aes,sse4.1"))) void encryptCbcBlocks(const std::uint8_t *roundKeys, const std::uint8_t *iv,
+                                                            const std::uint8_t *in, std::size_t blocks,
+                                                            std::uint8_t *out)
+{
+    auto keys = loadRoundKeys(roundKeys);
+
+    auto previous = _mm_loadu_si128(reinterpret_cast<const __m128i *>(iv));
+    for (std::size_t block = 0; block < blocks; block++)
+    {
+        previous = encryptBlock(_mm_xor_si128(load(in, block), previous), keys);
+        store(out, block, previous);
+    }
+}
+
+__attribute__((target("aes,sse4.1"))) void decryptCbcBlocks(const std::uint8_t *roundKeys, const std::uint8_t *iv,
+                                                            const std::uint8_t *in, std::size_t blocks,
+                                                            std::uint8_t *out)
+{
+    auto keys = loadRoundKeys(roundKeys);
+
+    // all the cipher blocks of a batch are loaded before any output is stored, so it works in place
+    auto previous = _mm_loadu_si128(reinterpret_cast<const __m128i *>(iv));
+    std::size_t done = 0;
+    for (; done + AesNiKernel::INTERLEAVE <= blocks; done += AesNiKernel::INTERLEAVE)
+    {
+        __m128i cipher[AesNiKernel::INTERLEAVE];
+        __m128i batch[AesNiKernel::INTERLEAVE];
+#pragma GCC unroll 16
+        for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            cipher[i] = load(in, done + i);
+            batch[i] = cipher[i];
+        }
+
+        decryptBlocks(batch, keys);
+
+        store(out, done, _mm_xor_si128(batch[0], previous));
+#pragma GCC unroll 16
+        for (std::size_t i = 1; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            store(out, done + i, _mm_xor_si128(batch[i], cipher[i - 1]));
+        }
+        previous = cipher[AesNiKernel::INTERLEAVE - 1];
+    }
+
+    for (; done < blocks; done++)
+    {
+        auto cipher = load(in, done);
+        store(out, done, _mm_xor_si128(decryptBlock(cipher, keys), previous));
+        previous = cipher;
+    }
+}
+
+__attribute__((target("aes,sse4.1"))) void transformCtrBlocks(const std::uint8_t *roundKeys, const std::uint8_t *nonce,
+                                                              std::uint64_t counter, const std::uint8_t *in,
+                                                              std::size_t blocks, std::uint8_t *out)
+{
+    auto keys = loadRoundKeys(roundKeys);
+
+    // the nonce is the low half of the counter block, the counter the high half (x86 is little endian)
+    std::int64_t nonceHalf;
+    std::memcpy(&nonceHalf, nonce, sizeof(nonceHalf));
+    auto counterBlock = [&](std::size_t block) {
+        return _mm_set_epi64x(static_cast<std::int64_t>(counter + block), nonceHalf);
+    };
+
+    std::size_t done = 0;
+    for (; done + AesNiKernel::INTERLEAVE <= blocks; done += AesNiKernel::INTERLEAVE)
+    {
+        __m128i batch[AesNiKernel::INTERLEAVE];
+#pragma GCC unroll 16
+        for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            batch[i] = counterBlock(done + i);
+        }
+
+        encryptBlocks(batch, keys);
+
+#pragma GCC unroll 16
+        for (std::size_t i = 0; i < AesNiKernel::INTERLEAVE; i++)
+        {
+            store(out, done + i, _mm_xor_si128(batch[i], load(in, done + i)));
+        }
+    }
+
+    for (; done < blocks; done++)
+    {
+        store(out, done, _mm_xor_si128(encryptBlock(counterBlock(done), keys), load(in, done)));
+    }
+}
+} // namespace
+
+bool AesNiKernel::supported() { return CpuFeatures::hasAesNi(); }
+
+AesNiKernel::AesNiKernel(const std::uint8_t *key) : roundKeys_(2 * ROUND_KEYS * BLOCK_SIZE)
+{
+    THROW_IF(!supported(), "AES-NI is not supported by this CPU", std::logic_error);
+
+    expandKey(key, roundKeys_.data());
+}
+
+void AesNiKernel::encryptEcb(const std::uint8_t *in, std::size_t blocks, std::uint8_t *out) const
+{
+    processEcb<true>(roundKeys_.data(), in, blocks, out);
+}
+
+void AesNiKernel::decryptEcb(const std::uint8_t *in, std::size_t blocks, std::uint8_t *out) const
+{
+    processEcb<false>(roundKeys_.data() + ROUND_KEYS * BLOCK_SIZE, in, blocks, out);
+}
+
+void AesNiKernel::encryptCbc(const std::uint8_t *iv, const std::uint8_t *in, std::size_t blocks,
+                             std::uint8_t *out) const
+{
+    encryptCbcBlocks(roundKeys_.data(), iv, in, blocks, out);
+}
+
+void AesNiKernel::decryptCbc(const std::uint8_t *iv, const std::uint8_t *in, std::size_t blocks,
+                             std::uint8_t *out) const
+{
+    decryptCbcBlocks(roundKeys_.data() + ROUND_KEYS * BLOCK_SIZE, iv, in, blocks, out);
+}
+
+void AesNiKernel::transformCtr(const std::uint8_t *nonce, std::uint64_t counter, const std::uint8_t *in,
+                               std::size_t blocks, std::uint8_t *out) const
+{
+    transformCtrBlocks(roundKeys_.data(), nonce, counter, in, blocks, out);
+}
+
+#else
+
+bool AesNiKernel::supported() { return false; }
+
+AesNiKernel::AesNiKernel(const std::uint8_t *)
+{
+    THROW_IF(true, "AES-NI is not supported on this platform", std::logic_error);
+}
+
+void AesNiKernel::encryptEcb(const std::uint8_t *, std::size_t, std::uint8_t *) const {}
+
+void AesNiKernel::decryptEcb(const std::uint8_t *, std::size_t, std::uint8_t *) const {}
+
+void AesNiKernel::encryptCbc(const std::uint8_t *, const std::uint8_t *, std::size_t, std::uint8_t *) const {}
+
+void AesNiKernel::decryptCbc(const std::uint8_t *, const std::uint8_t *, std::size_t, std::uint8_t *) const {}
+
+void AesNiKernel::transformCtr(const std::uint8_t *, std::uint64_t, const std::uint8_t *, std::size_t,
+                               std::uint8_t *) const
+{
+}
+
+#endif
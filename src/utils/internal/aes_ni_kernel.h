@@ -0,0 +1,112 @@
+#ifndef MATASANO_AES_NI_KERNEL_H
+#define MATASANO_AES_NI_KERNEL_H
+
+#include <botan/secmem.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Native AES-128 with the x86 AES-NI instructions, used by Aes when the CPU supports them (@see supported)
+ * The key schedule is expanded once on construction. The bulk operations keep INTERLEAVE independent blocks in flight,
+ * so the latency of the AESENC / AESDEC instructions is hidden behind the blocks that follow: ECB in both directions,
+ * CBC decryption and CTR are interleaved, CBC encryption is inherently one block after another
+ *
+ * All the operations work on whole 16 byte blocks and may work in place (out is the same memory as in)
+ */
+class AesNiKernel
+{
+public:
+    /**
+     * @brief the block size in bytes
+     */
+    static constexpr std::size_t BLOCK_SIZE = 16;
+
+    /**
+     * @brief the key size in bytes
+     */
+    static constexpr std::size_t KEY_SIZE = 16;
+
+    /**
+     * @brief number of rounds of AES-128
+     */
+    static constexpr std::size_t ROUNDS = 10;
+
+    /**
+     * @brief number of blocks processed together in the interleaved pipeline
+     */
+    static constexpr std::size_t INTERLEAVE = 8;
+
+    /**
+     * @brief whether the CPU supports the instructions the kernel needs (AES-NI and SSE4.1). False on non x86-64
+     * platforms
+     */
+    static bool supported();
+
+    /**
+     * @brief Construct a new Aes Ni Kernel object, expands the encryption and decryption key schedules
+     *
+     * @param key KEY_SIZE bytes of the key
+     * @throw std::logic_error if the CPU does not support AES-NI
+     */
+    explicit AesNiKernel(const std::uint8_t *key);
+
+    /**
+     * @brief encrypts blocks in ECB mode
+     *
+     * @param in the blocks to encrypt
+     * @param blocks number of blocks
+     * @param out output buffer, should have room for blocks * BLOCK_SIZE bytes (may be the same memory as in)
+     */
+    void encryptEcb(const std::uint8_t *in, std::size_t blocks, std::uint8_t *out) const;
+
+    /**
+     * @brief decrypts blocks in ECB mode
+     *
+     * @param in the blocks to decrypt
+     * @param blocks number of blocks
+     * @param out output buffer, should have room for blocks * BLOCK_SIZE bytes (may be the same memory as in)
+     */
+    void decryptEcb(const std::uint8_t *in, std::size_t blocks, std::uint8_t *out) const;
+
+    /**
+     * @brief encrypts blocks in CBC mode, each plain block is xored with the previous cipher block before encryption
+     *
+     * @param iv BLOCK_SIZE bytes, the cipher block before the first one
+     * @param in the blocks to encrypt
+     * @param blocks number of blocks
+     * @param out output buffer, should have room for blocks * BLOCK_SIZE bytes (may be the same memory as in)
+     */
+    void encryptCbc(const std::uint8_t *iv, const std::uint8_t *in, std::size_t blocks, std::uint8_t *out) const;
+
+    /**
+     * @brief decrypts blocks in CBC mode, each decrypted block is xored with the previous cipher block
+     *
+     * @param iv BLOCK_SIZE bytes, the cipher block before the first one
+     * @param in the blocks to decrypt
+     * @param blocks number of blocks
+     * @param out output buffer, should have room for blocks * BLOCK_SIZE bytes (may be the same memory as in)
+     */
+    void decryptCbc(const std::uint8_t *iv, const std::uint8_t *in, std::size_t blocks, std::uint8_t *out) const;
+
+    /**
+     * @brief CTR mode: xors the input with the encryption of consecutive counter blocks. A counter block is the 8 byte
+     * nonce followed by the 64 bit block counter in little endian (the counter wraps around)
+     *
+     * @param nonce 8 bytes, the first half of every counter block
+     * @param counter the counter of the first block
+     * @param in the blocks to encrypt / decrypt
+     * @param blocks number of blocks
+     * @param out output buffer, should have room for blocks * BLOCK_SIZE bytes (may be the same memory as in)
+     */
+    void transformCtr(const std::uint8_t *nonce, std::uint64_t counter, const std::uint8_t *in, std::size_t blocks,
+                      std::uint8_t *out) const;
+
+private:
+    /**
+     * the encryption round keys followed by the decryption round keys (in the order they are applied, already passed
+     * through AESIMC), (ROUNDS + 1) * BLOCK_SIZE bytes each. Held in secure memory like the keys in ByteData
+     */
+    Botan::secure_vector<std::uint8_t> roundKeys_;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "cpu_features.h"
+
+#ifdef MATASANO_X86
+
+bool CpuFeatures::hasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+bool CpuFeatures::hasAvx512()
+{
+    static const bool supported = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    return supported;
+}
+
+bool CpuFeatures::hasAvx512Popcount()
+{
+    static const bool supported = hasAvx512() && __builtin_cpu_supports("avx512vpopcntdq");
+    return supported;
+}
+
+bool CpuFeatures::hasPopcount()
+{
+    static const bool supported = __builtin_cpu_supports("popcnt");
+    return supported;
+}
+
+bool CpuFeatures::hasAesNi()
+{
+    static const bool supported = __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse4.1");
+    return supported;
+}
+
+#else
+
+bool CpuFeatures::hasAvx2() { return false; }
+
+bool CpuFeatures::hasAvx512() { return false; }
+
+bool CpuFeatures::hasAvx512Popcount() { return false; }
+
+bool CpuFeatures::hasPopcount() { return false; }
+
+bool CpuFeatures::hasAesNi() { return false; }
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef MATASANO_CPU_FEATURES_H
+#define MATASANO_CPU_FEATURES_H
+
+/**
+ * @brief Defined when compiling for x86-64, where the vectorized kernels are available (SSE2 is always there)
+ */
+#if defined(__x86_64__)
+#define MATASANO_X86 1
+#endif
+
+/**
+ * @brief Runtime detection of the instruction set extensions used by the vectorized kernels
+ * All the queries are evaluated once and cached. On non x86-64 platforms all of them return false
+ */
+class CpuFeatures
+{
+public:
+    /**
+     * @brief whether AVX2 instructions are supported
+     */
+    static bool hasAvx2();
+
+    /**
+     * @brief whether AVX-512 foundation and byte / word instructions are supported
+     */
+    static bool hasAvx512();
+
+    /**
+     * @brief whether AVX-512 VPOPCNTDQ (vector popcount) instructions are supported
+     */
+    static bool hasAvx512Popcount();
+
+    /**
+     * @brief whether the POPCNT instruction is supported
+     */
+    static bool hasPopcount();
+
+    /**
+     * @brief whether AES-NI instructions are supported
+     */
+    static bool hasAesNi();
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "mapped_file.h"
+#include "matasano_asserts.h"
+
+#include <ios>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &fileName, Mode mode)
+{
+    auto fd = ::open(fileName.c_str(), mode == Mode::read ? O_RDONLY : O_RDWR);
+    THROW_IF(fd < 0, "can't open " + fileName, std::ios_base::failure);
+
+    map(fd, fileName, mode);
+}
+
+MappedFile MappedFile::create(const std::string &fileName, std::size_t size)
+{
+    auto fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    THROW_IF(fd < 0, "can't create " + fileName, std::ios_base::failure);
+
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd);
+        throw std::ios_base::failure("can't resize " + fileName);
+    }
+
+    MappedFile result;
+    result.map(fd, fileName, Mode::readWrite);
+    return result;
+}
+
+void MappedFile::map(int fd, const std::string &fileName, Mode mode)
+{
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw std::ios_base::failure("can't stat " + fileName);
+    }
+
+    size_ = static_cast<std::size_t>(st.st_size);
+    void *mapped = nullptr;
+    if (size_ != 0)
+    {
+        auto protection = mode == Mode::read ? PROT_READ : PROT_READ | PROT_WRITE;
+        mapped = ::mmap(nullptr, size_, protection, mode == Mode::read ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+
+    THROW_IF(mapped == MAP_FAILED, "can't map " + fileName, std::ios_base::failure);
+    data_ = static_cast<std::uint8_t *>(mapped);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(data_, size_);
+    }
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+}
+
+void MappedFile::adviseSequential() const
+{
+    if (data_ != nullptr)
+    {
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+}
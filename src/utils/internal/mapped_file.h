@@ -0,0 +1,102 @@
+#ifndef MATASANO_MAPPED_FILE_H
+#define MATASANO_MAPPED_FILE_H
+
+#include "byte_view.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Memory mapping of a whole file, unmapped when destroyed. Changes to a file mapped for writing go straight to
+ * the file, there is no copy of its contents in the process memory
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief how the file is mapped
+     */
+    enum class Mode
+    {
+        read,
+        readWrite
+    };
+
+    /**
+     * @brief Maps an existing file
+     *
+     * @param fileName filename or path of the file
+     * @param mode whether the mapping is read only
+     *
+     * @throw std::ios_base::failure if the file can't be opened or mapped
+     */
+    explicit MappedFile(const std::string &fileName, Mode mode = Mode::read);
+
+    /**
+     * @brief Creates a file of a given size (truncates it if exists) and maps it for writing
+     *
+     * @param fileName filename or path of the file
+     * @param size the size of the file
+     * @return the mapping
+     *
+     * @throw std::ios_base::failure if the file can't be created, resized or mapped
+     */
+    static MappedFile create(const std::string &fileName, std::size_t size);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /**
+     * @brief the mapped bytes, null for an empty file
+     */
+    inline const std::uint8_t *data() const { return data_; }
+
+    /**
+     * @brief the mapped bytes, null for an empty file. Should not be written to if the file is mapped read only
+     */
+    inline std::uint8_t *data() { return data_; }
+
+    /**
+     * @brief the size of the file
+     */
+    inline std::size_t size() const { return size_; }
+
+    /**
+     * @brief the mapped bytes as a view
+     */
+    inline ByteView view() const { return data_ == nullptr ? ByteView() : ByteView(data_, size_); }
+
+    /**
+     * @brief tells the kernel the file is going to be read sequentially, so it reads ahead more aggressively and
+     * drops the pages behind sooner
+     */
+    void adviseSequential() const;
+
+private:
+    MappedFile() = default;
+
+    /**
+     * @brief Maps an open file and closes it
+     *
+     * @param fd the file descriptor
+     * @param fileName the file name, for the error messages
+     * @param mode whether the mapping is read only
+     */
+    void map(int fd, const std::string &fileName, Mode mode);
+
+    /**
+     * the mapped bytes
+     */
+    std::uint8_t *data_ = nullptr;
+
+    /**
+     * the size of the file
+     */
+    std::size_t size_ = 0;
+};
+
+#endif
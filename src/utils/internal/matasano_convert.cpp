@@ -1,117 +1,399 @@
 #include "matasano_convert.h"
+#include "cpu_features.h"
 #include "matasano_asserts.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <charconv>
 #include <iomanip>
 #include <sstream>
 
-char Convert::numToBase64(unsigned long long longNum)
-{
-    LOGIC_ASSERT(longNum <= 63);
-
-    char num = static_cast<char>(longNum);
+#ifdef MATASANO_X86
+#include <immintrin.h>
+#endif
 
-    if (num <= 25)
+namespace
+{
+/**
+ * @brief marks characters that are not hex digits in HEX_DECODE_TABLE
+ */
+constexpr std::uint8_t INVALID_NIBBLE = 0xff;
+
+/**
+ * @brief maps hex character to its value, or INVALID_NIBBLE
+ */
+constexpr auto HEX_DECODE_TABLE = []() {
+    std::array<std::uint8_t, 256> table{};
+    table.fill(INVALID_NIBBLE);
+    for (int i = 0; i < 10; i++)
     {
-        return num +'A';
+        table['0' + i] = static_cast<std::uint8_t>(i);
     }
-
-    if (num <= 51)
+    for (int i = 0; i < 6; i++)
     {
-        return (num - 26) + 'a';
+        table['a' + i] = static_cast<std::uint8_t>(10 + i);
+        table['A' + i] = static_cast<std::uint8_t>(10 + i);
     }
-
-    if (num <= 61)
+    return table;
+}();
+
+/**
+ * @brief maps byte to its two lower case hex characters
+ */
+constexpr auto HEX_ENCODE_TABLE = []() {
+    constexpr char digits[] = "0123456789abcdef";
+    std::array<std::array<char, 2>, 256> table{};
+    for (std::size_t i = 0; i < table.size(); i++)
     {
-        return (num - 52) + '0';
+        table[i] = {digits[i >> 4], digits[i & 0xf]};
     }
-
-    if (num == 62)
+    return table;
+}();
+
+/**
+ * @brief the base64 alphabet
+ */
+constexpr char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * @brief special values of BASE64_DECODE_TABLE, all of them have bit 0x80 set
+ */
+constexpr std::uint8_t BASE64_INVALID = 0x80;
+constexpr std::uint8_t BASE64_PAD = 0x81;
+constexpr std::uint8_t BASE64_WHITESPACE = 0x82;
+
+/**
+ * @brief maps base64 character to its 6 bit value, or to one of the special values above
+ */
+constexpr auto BASE64_DECODE_TABLE = []() {
+    std::array<std::uint8_t, 256> table{};
+    table.fill(BASE64_INVALID);
+    for (std::size_t i = 0; i < 64; i++)
     {
-        return '+';
+        table[static_cast<unsigned char>(BASE64_ALPHABET[i])] = static_cast<std::uint8_t>(i);
     }
+    table['='] = BASE64_PAD;
+    for (char c : {' ', '\t', '\n', '\v', '\f', '\r'})
+    {
+        table[static_cast<unsigned char>(c)] = BASE64_WHITESPACE;
+    }
+    return table;
+}();
 
-    // num == 63
-    return '/';
+/**
+ * @brief writes 3 bytes held in the lower 24 bits of quad
+ */
+inline void storeBase64Quad(std::uint32_t quad, std::uint8_t *out)
+{
+    out[0] = static_cast<std::uint8_t>(quad >> 16);
+    out[1] = static_cast<std::uint8_t>(quad >> 8);
+    out[2] = static_cast<std::uint8_t>(quad);
 }
 
-unsigned int Convert::base64ToNum(char base64)
+#ifdef MATASANO_X86
+
+/**
+ * @brief converts 16 hex characters to their nibble values
+ *
+ * @param chars hex characters
+ * @param valid set to all ones for every character that is a hex digit
+ * @return nibble values (garbage where the character is not valid)
+ */
+__attribute__((target("sse2"))) inline __m128i hexNibblesSse2(__m128i chars, __m128i &valid)
 {
-    if ('=' == base64)
-    {
-        return 0;
-    }
+    auto digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    auto isDigit = _mm_cmpeq_epi8(_mm_subs_epu8(digit, _mm_set1_epi8(9)), _mm_setzero_si128());
 
-    if (base64 >= 'A' && base64 <= 'Z')
-    {
-        return base64 - 'A';
-    }
+    auto letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    auto isLetter = _mm_cmpeq_epi8(_mm_subs_epu8(letter, _mm_set1_epi8(5)), _mm_setzero_si128());
 
-    if (base64 >= 'a' && base64 <= 'z')
-    {
-        return base64 - 'a' + 26;
-    }
+    valid = _mm_or_si128(isDigit, isLetter);
+    return _mm_or_si128(_mm_and_si128(digit, isDigit),
+                        _mm_and_si128(_mm_add_epi8(letter, _mm_set1_epi8(10)), isLetter));
+}
 
-    if (base64 >= '0' && base64 <= '9')
-    {
-        return base64 - '0' + 52;
-    }
+/**
+ * @brief joins pairs of nibbles (high one first) into 16 bit lanes holding one byte each
+ */
+__attribute__((target("sse2"))) inline __m128i joinNibblesSse2(__m128i nibbles)
+{
+    return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4),
+                        _mm_srli_epi16(nibbles, 8));
+}
 
-    if ('+' == base64)
+/**
+ * @brief decodes hex 32 characters at a time, stops before the first block that has invalid characters
+ *
+ * @return the number of characters decoded
+ */
+__attribute__((target("sse2"))) std::size_t hexToBytesSse2(const char *hex, std::size_t length, std::uint8_t *out)
+{
+    std::size_t i = 0;
+    for (; i + 32 <= length; i += 32)
     {
-        return 62;
+        __m128i valid1, valid2;
+        auto nibbles1 = hexNibblesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hex + i)), valid1);
+        auto nibbles2 = hexNibblesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hex + i + 16)), valid2);
+        if (_mm_movemask_epi8(_mm_and_si128(valid1, valid2)) != 0xffff)
+        {
+            break;
+        }
+
+        auto bytes = _mm_packus_epi16(joinNibblesSse2(nibbles1), joinNibblesSse2(nibbles2));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i / 2), bytes);
     }
 
-    if ('/' == base64)
+    return i;
+}
+
+/**
+ * @brief AVX2 version of hexNibblesSse2 for 32 characters
+ */
+__attribute__((target("avx2"))) inline __m256i hexNibblesAvx2(__m256i chars, __m256i &valid)
+{
+    auto digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    auto isDigit = _mm256_cmpeq_epi8(_mm256_subs_epu8(digit, _mm256_set1_epi8(9)), _mm256_setzero_si256());
+
+    auto letter = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    auto isLetter = _mm256_cmpeq_epi8(_mm256_subs_epu8(letter, _mm256_set1_epi8(5)), _mm256_setzero_si256());
+
+    valid = _mm256_or_si256(isDigit, isLetter);
+    return _mm256_or_si256(_mm256_and_si256(digit, isDigit),
+                           _mm256_and_si256(_mm256_add_epi8(letter, _mm256_set1_epi8(10)), isLetter));
+}
+
+/**
+ * @brief AVX2 version of joinNibblesSse2
+ */
+__attribute__((target("avx2"))) inline __m256i joinNibblesAvx2(__m256i nibbles)
+{
+    return _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00ff)), 4),
+                           _mm256_srli_epi16(nibbles, 8));
+}
+
+/**
+ * @brief AVX2 version of hexToBytesSse2, 64 characters at a time
+ */
+__attribute__((target("avx2"))) std::size_t hexToBytesAvx2(const char *hex, std::size_t length, std::uint8_t *out)
+{
+    std::size_t i = 0;
+    for (; i + 64 <= length; i += 64)
     {
-        return 63;
+        __m256i valid1, valid2;
+        auto nibbles1 = hexNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(hex + i)), valid1);
+        auto nibbles2 = hexNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(hex + i + 32)), valid2);
+        if (_mm256_movemask_epi8(_mm256_and_si256(valid1, valid2)) != -1)
+        {
+            break;
+        }
+
+        // packing works inside 128 bit lanes, restore the order of the 64 bit quarters afterwards
+        auto bytes = _mm256_packus_epi16(joinNibblesAvx2(nibbles1), joinNibblesAvx2(nibbles2));
+        bytes = _mm256_permute4x64_epi64(bytes, 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i / 2), bytes);
     }
 
-    // we should not have got here
-    THROW_IF(true, base64 + " is not a valid base64 char", std::invalid_argument);
+    return i;
+}
 
-    // this is never reached
-    return 0;
+/**
+ * @brief converts 16 nibbles to lower case hex characters
+ */
+__attribute__((target("sse2"))) inline __m128i hexCharsSse2(__m128i nibbles)
+{
+    auto isLetter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    auto chars = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+    return _mm_add_epi8(chars, _mm_and_si128(isLetter, _mm_set1_epi8('a' - '0' - 10)));
 }
 
-std::string Convert::hex3ToBase64_4(const std::string &hex)
+/**
+ * @brief encodes bytes 16 at a time
+ *
+ * @return the number of bytes encoded
+ */
+__attribute__((target("sse2"))) std::size_t bytesToHexSse2(const std::uint8_t *bytes, std::size_t size, char *out)
 {
-    LOGIC_ASSERT(hex.length() == 6);
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        auto data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+        auto high = hexCharsSse2(_mm_and_si128(_mm_srli_epi16(data, 4), _mm_set1_epi8(0x0f)));
+        auto low = hexCharsSse2(_mm_and_si128(data, _mm_set1_epi8(0x0f)));
 
-    unsigned long number = parseNumFromStr(hex, 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
 
-    auto octal = numToStr(number, 8, 8);
+    return i;
+}
 
-    LOGIC_ASSERT(octal.length() == 8);
+/**
+ * @brief AVX2 version of hexCharsSse2
+ */
+__attribute__((target("avx2"))) inline __m256i hexCharsAvx2(__m256i nibbles)
+{
+    auto isLetter = _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9));
+    auto chars = _mm256_add_epi8(nibbles, _mm256_set1_epi8('0'));
+    return _mm256_add_epi8(chars, _mm256_and_si256(isLetter, _mm256_set1_epi8('a' - '0' - 10)));
+}
 
-    std::string base64;
-    for (std::size_t i = 0; i < octal.length(); i += 2)
+/**
+ * @brief AVX2 version of bytesToHexSse2, 32 bytes at a time
+ */
+__attribute__((target("avx2"))) std::size_t bytesToHexAvx2(const std::uint8_t *bytes, std::size_t size, char *out)
+{
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
     {
-        auto num = parseNumFromStr(octal.substr(i, 2), 8);
-        base64 += numToBase64(num);
+        auto data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+        auto high = hexCharsAvx2(_mm256_and_si256(_mm256_srli_epi16(data, 4), _mm256_set1_epi8(0x0f)));
+        auto low = hexCharsAvx2(_mm256_and_si256(data, _mm256_set1_epi8(0x0f)));
+
+        // unpacking works inside 128 bit lanes, put the lanes back in order when storing
+        auto first = _mm256_unpacklo_epi8(high, low);
+        auto second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
     }
 
-    return base64;
+    return i;
 }
 
-std::string Convert::base64_4ToHex3(const std::string &base64)
+/**
+ * @brief decodes base64 32 characters at a time (Mula / Lemire lookup scheme), stops before the first block that has
+ * anything other than the 64 alphabet characters (padding, whitespace, invalid characters)
+ *
+ * @return the number of characters decoded, always multiple of 4
+ */
+__attribute__((target("avx2"))) std::size_t base64ToBytesAvx2(const char *base64, std::size_t length,
+                                                              std::uint8_t *out)
 {
-    LOGIC_ASSERT(base64.length() == 4);
+    // lo / hi nibble lookups have a common bit set only for characters outside the alphabet
+    const auto lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b,
+                                        0x1b, 0x1b, 0x1a, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const auto lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    // offset to add to a character to get its value, selected by high nibble ('/' is special cased)
+    const auto lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65,
+                                          -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const auto nibbleMask = _mm256_set1_epi8(0x2f);
+    const auto packBytes = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4,
+                                            10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const auto packLanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+    std::size_t i = 0;
+    std::size_t written = 0;
+    for (; i + 32 <= length; i += 32, written += 24)
+    {
+        auto chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base64 + i));
+
+        auto hiNibbles = _mm256_and_si256(_mm256_srli_epi32(chars, 4), nibbleMask);
+        auto loNibbles = _mm256_and_si256(chars, nibbleMask);
+        auto lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        auto hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm256_testz_si256(lo, hi))
+        {
+            break;
+        }
+
+        auto isSlash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+        auto roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(isSlash, hiNibbles));
+        auto values = _mm256_add_epi8(chars, roll);
+
+        // join 4 x 6 bits into 24 bits inside each 32 bit lane, then squeeze out the 4th byte of every lane
+        auto pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        auto quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        auto bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(quads, packBytes), packLanes);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + written), _mm256_castsi256_si128(bytes));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + written + 16), _mm256_extracti128_si256(bytes, 1));
+    }
+
+    return i;
+}
 
-    std::string octalStr;
+/**
+ * @brief number of characters base64ToBytesSkipWhitespaceAvx2 compacts before decoding them
+ */
+constexpr std::size_t BASE64_COMPACT_BUFFER = 4096;
+
+/**
+ * @brief decodes base64 with whitespace in it (e.g. line wrapped) 32 characters at a time. Up to the first whitespace
+ * the characters are decoded in place, from there they are compacted into a buffer that is decoded with
+ * base64ToBytesAvx2: a vector is stored as it is, and the characters after each of its whitespace characters are
+ * stored again one position back over it. The stores read and write up to 32 bytes past the vector, so the last 64
+ * characters are left to the scalar version. Every round of the buffer ends on a whole vector of compacted characters,
+ * so the scalar version can take over right after it. A round that base64ToBytesAvx2 does not finish (padding or
+ * invalid characters) is left to the scalar version too
+ *
+ * @param consumed the number of characters decoded
+ * @return the number of bytes written
+ */
+__attribute__((target("avx2"))) std::size_t base64ToBytesSkipWhitespaceAvx2(const char *base64, std::size_t length,
+                                                                            std::uint8_t *out, std::size_t &consumed)
+{
+    std::array<char, BASE64_COMPACT_BUFFER> compact;
+    std::size_t in = 0;
+    std::size_t written = 0;
 
-    for (auto c : base64)
+    while (in + 64 <= length)
     {
-        auto num = base64ToNum(c);
-        octalStr += numToStr(num, 2, 8);
+        // whatever has no whitespace is decoded in place
+        auto direct = base64ToBytesAvx2(base64 + in, length - in, out + written);
+        in += direct;
+        written += direct / 4 * 3;
+
+        auto roundStart = in;
+        std::size_t compacted = 0;
+        for (; in + 64 <= length && compacted + 64 <= compact.size(); in += 32)
+        {
+            // ' ' or '\t' .. '\r'
+            auto chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base64 + in));
+            auto control = _mm256_sub_epi8(chars, _mm256_set1_epi8('\t'));
+            auto isControl = _mm256_cmpeq_epi8(_mm256_min_epu8(control, _mm256_set1_epi8(4)), control);
+            auto isWhitespace = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')), isControl);
+            auto whitespace = static_cast<std::uint32_t>(_mm256_movemask_epi8(isWhitespace));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(compact.data() + compacted), chars);
+            std::size_t removed = 0;
+            for (; whitespace != 0; whitespace &= whitespace - 1)
+            {
+                auto next = static_cast<std::size_t>(std::countr_zero(whitespace)) + 1;
+                removed++;
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(compact.data() + compacted + next - removed),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base64 + in + next)));
+            }
+            compacted += 32 - removed;
+        }
+
+        // base64ToBytesAvx2 decodes whole vectors, give the characters of a partial one back to the next round
+        for (auto partial = compacted % 32; partial != 0; compacted--, partial--)
+        {
+            do
+            {
+                in--;
+            } while (BASE64_DECODE_TABLE[static_cast<unsigned char>(base64[in])] == BASE64_WHITESPACE);
+        }
+
+        if (in == roundStart || base64ToBytesAvx2(compact.data(), compacted, out + written) != compacted)
+        {
+            in = roundStart;
+            break;
+        }
+        written += compacted / 4 * 3;
     }
 
-    LOGIC_ASSERT(octalStr.length() == 8);
+    consumed = in;
+    return written;
+}
 
-    unsigned long octalNumber = parseNumFromStr(octalStr, 8);
+#endif
 
-    return numToStr(octalNumber, 6, 16);
-}
+} // namespace
 
 unsigned long long Convert::parseNumFromStr(const std::string &str, int base)
 {
@@ -145,4 +427,178 @@ std::string Convert::numToStr(unsigned long long num, int min_width, int base)
     os << std::setbase(base) << std::setfill('0') << std::setw(min_width) << num;
 
     return os.str();
-}
\ No newline at end of file
+}
+
+void Convert::hexToBytes(const char *hex, std::size_t length, std::uint8_t *out)
+{
+    THROW_IF(length % 2 != 0, std::string(hex, length) + " has uneven length", std::invalid_argument);
+
+    std::size_t done = 0;
+
+#ifdef MATASANO_X86
+    if (CpuFeatures::hasAvx2())
+    {
+        done = hexToBytesAvx2(hex, length, out);
+    }
+    done += hexToBytesSse2(hex + done, length - done, out + done / 2);
+#endif
+
+    hexToBytesScalar(hex + done, length - done, out + done / 2);
+}
+
+void Convert::hexToBytesScalar(const char *hex, std::size_t length, std::uint8_t *out)
+{
+    for (std::size_t i = 0; i + 1 < length; i += 2)
+    {
+        auto high = HEX_DECODE_TABLE[static_cast<unsigned char>(hex[i])];
+        auto low = HEX_DECODE_TABLE[static_cast<unsigned char>(hex[i + 1])];
+        THROW_IF(((high | low) & 0xf0) != 0,
+                 "can't parse 16 number from " + std::string(hex + i, 2), std::invalid_argument);
+
+        out[i / 2] = static_cast<std::uint8_t>((high << 4) | low);
+    }
+}
+
+void Convert::bytesToHex(const std::uint8_t *bytes, std::size_t size, char *out)
+{
+    std::size_t done = 0;
+
+#ifdef MATASANO_X86
+    if (CpuFeatures::hasAvx2())
+    {
+        done = bytesToHexAvx2(bytes, size, out);
+    }
+    done += bytesToHexSse2(bytes + done, size - done, out + 2 * done);
+#endif
+
+    bytesToHexScalar(bytes + done, size - done, out + 2 * done);
+}
+
+void Convert::bytesToHexScalar(const std::uint8_t *bytes, std::size_t size, char *out)
+{
+    for (std::size_t i = 0; i < size; i++)
+    {
+        out[2 * i] = HEX_ENCODE_TABLE[bytes[i]][0];
+        out[2 * i + 1] = HEX_ENCODE_TABLE[bytes[i]][1];
+    }
+}
+
+std::size_t Convert::base64ToBytes(const char *base64, std::size_t length, std::uint8_t *out, bool skipWhitespace)
+{
+    std::size_t done = 0;
+    std::size_t written = 0;
+
+#ifdef MATASANO_X86
+    if (CpuFeatures::hasAvx2())
+    {
+        if (skipWhitespace)
+        {
+            written = base64ToBytesSkipWhitespaceAvx2(base64, length, out, done);
+        }
+        else
+        {
+            done = base64ToBytesAvx2(base64, length, out);
+            written = done / 4 * 3;
+        }
+    }
+#endif
+
+    return written + base64ToBytesScalar(base64 + done, length - done, out + written, skipWhitespace);
+}
+
+std::size_t Convert::base64ToBytesScalar(const char *base64, std::size_t length, std::uint8_t *out,
+                                         bool skipWhitespace)
+{
+    const auto *chars = reinterpret_cast<const unsigned char *>(base64);
+    auto errorMsg = [&]() { return std::string(base64, length) + " is not in correct base64 format"; };
+
+    std::size_t written = 0;
+    std::uint32_t quad = 0;
+    std::size_t inQuad = 0;
+    std::size_t padding = 0;
+
+    for (std::size_t i = 0; i < length; i++)
+    {
+        // fast path: a whole quad of alphabet characters
+        if (inQuad == 0 && i + 4 <= length)
+        {
+            auto a = BASE64_DECODE_TABLE[chars[i]];
+            auto b = BASE64_DECODE_TABLE[chars[i + 1]];
+            auto c = BASE64_DECODE_TABLE[chars[i + 2]];
+            auto d = BASE64_DECODE_TABLE[chars[i + 3]];
+            if (((a | b | c | d) & 0x80) == 0)
+            {
+                THROW_IF(padding != 0, errorMsg(), std::invalid_argument);
+                storeBase64Quad((std::uint32_t{a} << 18) | (std::uint32_t{b} << 12) | (std::uint32_t{c} << 6) | d,
+                                out + written);
+                written += 3;
+                i += 3;
+                continue;
+            }
+        }
+
+        auto value = BASE64_DECODE_TABLE[chars[i]];
+        if (value == BASE64_WHITESPACE && skipWhitespace)
+        {
+            continue;
+        }
+
+        if (value == BASE64_PAD)
+        {
+            // padding can only be the 3rd and 4th character of the last quad
+            padding++;
+            THROW_IF(inQuad < 2, errorMsg(), std::invalid_argument);
+            value = 0;
+        }
+        else
+        {
+            THROW_IF((value & 0x80) != 0 || padding != 0, errorMsg(), std::invalid_argument);
+        }
+
+        quad = (quad << 6) | value;
+        if (++inQuad == 4)
+        {
+            std::uint8_t bytes[3];
+            storeBase64Quad(quad, bytes);
+            for (std::size_t j = 0; j < 3 - padding; j++)
+            {
+                out[written++] = bytes[j];
+            }
+            quad = 0;
+            inQuad = 0;
+        }
+    }
+
+    THROW_IF(inQuad != 0, std::string(base64, length) + " has length that is not multiply of 4",
+             std::invalid_argument);
+
+    return written;
+}
+
+void Convert::bytesToBase64(const std::uint8_t *bytes, std::size_t size, char *out)
+{
+    std::size_t i = 0;
+    for (; i + 3 <= size; i += 3, out += 4)
+    {
+        std::uint32_t triple = (std::uint32_t{bytes[i]} << 16) | (std::uint32_t{bytes[i + 1]} << 8) | bytes[i + 2];
+        out[0] = BASE64_ALPHABET[(triple >> 18) & 0x3f];
+        out[1] = BASE64_ALPHABET[(triple >> 12) & 0x3f];
+        out[2] = BASE64_ALPHABET[(triple >> 6) & 0x3f];
+        out[3] = BASE64_ALPHABET[triple & 0x3f];
+    }
+
+    if (i < size)
+    {
+        // the remaining 1 or 2 bytes are padded with zeroes, and the characters that encode only padding become '='
+        std::uint32_t triple = std::uint32_t{bytes[i]} << 16;
+        if (i + 1 < size)
+        {
+            triple |= std::uint32_t{bytes[i + 1]} << 8;
+        }
+
+        out[0] = BASE64_ALPHABET[(triple >> 18) & 0x3f];
+        out[1] = BASE64_ALPHABET[(triple >> 12) & 0x3f];
+        out[2] = (i + 1 < size) ? BASE64_ALPHABET[(triple >> 6) & 0x3f] : '=';
+        out[3] = '=';
+    }
+}
@@ -1,6 +1,8 @@
 #ifndef MATASANO_CONVERT_H
 #define MATASANO_CONVERT_H
 
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <stdexcept>
 #include <string>
@@ -36,56 +38,91 @@ public:
     static std::string numToStr(unsigned long long num, int min_width = 0, int base = 16);
 
     /**
-     * @brief Converts hex string of 3 bytes (6 length) to base64
-     * string of 4 symbols
+     * @brief pad the given string the the given amount of pad string iterations
+     *
+     * @param str string to pad
+     * @param pad string to pad with
+     * @param iterations number of times to repead the pad
+     * @return padded string
+     */
+    static std::string padWith(const std::string &str, const std::string &pad, std::size_t iterations);
+
+    /**
+     * @brief Decodes hex string into bytes. Both lower and upper case digits are accepted
+     * Long inputs are decoded with SSE2 / AVX2 when available
+     *
+     * @param hex hex characters (without 0x)
+     * @param length number of hex characters, should be even
+     * @param out output buffer, should have room for length / 2 bytes
      *
-     * @param hex Hex string (without 0x). Assumes the length is 6
-     * @return base64 string
+     * @throw std::invalid_argument if length is not even or hex contains non hex characters
+     */
+    static void hexToBytes(const char *hex, std::size_t length, std::uint8_t *out);
+
+    /**
+     * @brief Encodes bytes into lower case hex string
+     * Long inputs are encoded with SSE2 / AVX2 when available
      *
-     * @throw std::invalid_argument if hex is not in hex format
+     * @param bytes bytes to encode
+     * @param size number of bytes
+     * @param out output buffer, should have room for size * 2 characters
      */
-    static std::string hex3ToBase64_4(const std::string &hex);
+    static void bytesToHex(const std::uint8_t *bytes, std::size_t size, char *out);
 
     /**
-     * @brief Converts base64 string of 4 bytes to hex string of 3 symbol
+     * @brief Decodes base64 string into bytes in one pass, padding ('=') is validated and removed on the way
+     * Long inputs are decoded with AVX2 when available, also when whitespace is skipped: it is cut out of the vectors
+     * before they are decoded, so line wrapped base64 stays on the vector path
      *
-     * @param base64 base64 string. Assumes the length is 4
-     * @return hex string
+     * @param base64 base64 characters
+     * @param length number of base64 characters, should be multiple of 4 (not counting whitespace if it is skipped)
+     * @param out output buffer, should have room for length / 4 * 3 bytes
+     * @param skipWhitespace if true, whitespace and line breaks are skipped, otherwise they are invalid characters
+     * @return the number of decoded bytes written to out
      *
-     * @throw std::invalid_argument if base64 is not in base64 format
+     * @throw std::invalid_argument if base64 is not in correct base64 format
      */
-    static std::string base64_4ToHex3(const std::string &base64);
+    static std::size_t base64ToBytes(const char *base64, std::size_t length, std::uint8_t *out,
+                                     bool skipWhitespace = false);
 
     /**
-     * @brief pad the given string the the given amount of pad string iterations
+     * @brief Encodes bytes into padded base64 string
      *
-     * @param str string to pad
-     * @param pad string to pad with
-     * @param iterations number of times to repead the pad
-     * @return padded string
+     * @param bytes bytes to encode
+     * @param size number of bytes
+     * @param out output buffer, should have room for base64Length(size) characters
      */
-    static std::string padWith(const std::string &str, const std::string &pad, std::size_t iterations);
+    static void bytesToBase64(const std::uint8_t *bytes, std::size_t size, char *out);
 
-private:
     /**
-     * @brief convert a number into a single bas64 char
-     * assumes the number is in range[0, 63]
+     * @brief The length of padded base64 encoding of a given number of bytes
      *
-     * @param num number to convert
-     * @return base64 char
+     * @param size number of bytes
+     * @return number of base64 characters
      */
-    static char numToBase64(unsigned long long num);
+    static constexpr std::size_t base64Length(std::size_t size) { return (size + 2) / 3 * 4; }
 
+private:
     /**
-     * @brief convert a base64 char into number
-     * assumes char is a valid bas64 char
+     * @brief scalar version of hexToBytes, also used to finish what the vectorized version did not process
      *
-     * @param base64 char to convert
-     * @return number in range [0, 63]
+     * @throw std::invalid_argument if hex contains non hex characters
+     */
+    static void hexToBytesScalar(const char *hex, std::size_t length, std::uint8_t *out);
+
+    /**
+     * @brief scalar version of bytesToHex, also used to finish what the vectorized version did not process
+     */
+    static void bytesToHexScalar(const std::uint8_t *bytes, std::size_t size, char *out);
+
+    /**
+     * @brief scalar version of base64ToBytes, also used to finish what the vectorized version did not process
      *
-     * @throw std::invalid_argument if base64 is not in base64 format
+     * @return the number of decoded bytes written to out
+     * @throw std::invalid_argument if base64 is not in correct base64 format
      */
-    static unsigned int base64ToNum(char base64);
+    static std::size_t base64ToBytesScalar(const char *base64, std::size_t length, std::uint8_t *out,
+                                           bool skipWhitespace);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef MATASANO_STREAM_BUFFER_H
+#define MATASANO_STREAM_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+
+/**
+ * @brief Heap buffer the stream versions of the ciphers read and write through. It holds plain text or key stream, so
+ * it is wiped when destroyed, also when the processing throws
+ */
+class StreamBuffer
+{
+public:
+    /**
+     * @brief Construct a new Stream Buffer object
+     *
+     * @param size number of bytes
+     */
+    explicit StreamBuffer(std::size_t size) : buffer_(std::make_unique<char[]>(size)), size_(size) {}
+
+    ~StreamBuffer() { std::fill_n(static_cast<volatile char *>(buffer_.get()), size_, 0); }
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    /**
+     * @brief the buffer, for reading and writing streams
+     */
+    inline char *chars() { return buffer_.get(); }
+
+    /**
+     * @brief the buffer, for processing
+     */
+    inline std::uint8_t *bytes() { return reinterpret_cast<std::uint8_t *>(buffer_.get()); }
+
+    /**
+     * @brief number of bytes in the buffer
+     */
+    inline std::size_t size() const { return size_; }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    std::size_t size_;
+};
+
+/**
+ * @brief Makes a stream throw on failure for as long as it lives, and restores its original exception mask when it is
+ * destroyed, also when the processing throws
+ */
+class StreamExceptionsGuard
+{
+public:
+    /**
+     * @brief Construct a new Stream Exceptions Guard object
+     *
+     * @param stream the stream, should outlive the guard
+     * @param exceptions the exception mask to set
+     */
+    StreamExceptionsGuard(std::ios &stream, std::ios::iostate exceptions)
+        : stream_(stream), original_(stream.exceptions())
+    {
+        stream_.exceptions(exceptions);
+    }
+
+    ~StreamExceptionsGuard()
+    {
+        // setting a mask throws if the stream state already has one of its bits, a destructor must not throw
+        try
+        {
+            stream_.exceptions(original_);
+        }
+        catch (const std::ios::failure &)
+        {
+        }
+    }
+
+    StreamExceptionsGuard(const StreamExceptionsGuard &) = delete;
+    StreamExceptionsGuard &operator=(const StreamExceptionsGuard &) = delete;
+
+private:
+    std::ios &stream_;
+    std::ios::iostate original_;
+};
+
+#endif
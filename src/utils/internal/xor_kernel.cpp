@@ -0,0 +1,282 @@
+#include "xor_kernel.h"
+#include "cpu_features.h"
+#include "matasano_asserts.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#ifdef MATASANO_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+/**
+ * @brief keys shorter than this are repeated until they are at least that long, so the scalar tail of every key
+ * period is negligible
+ */
+constexpr std::size_t MIN_KEY_PERIOD = 4096;
+
+#ifdef MATASANO_X86
+
+/**
+ * @brief xors 16 bytes at a time
+ *
+ * @return the number of bytes processed
+ */
+__attribute__((target("sse2"))) std::size_t xorBlocksSse2(const std::uint8_t *lhs, const std::uint8_t *rhs,
+                                                          std::size_t size, std::uint8_t *out)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_xor_si128(a, b));
+    }
+
+    return i;
+}
+
+/**
+ * @brief AVX2 version of xorBlocksSse2, 64 bytes (two vectors) at a time
+ */
+__attribute__((target("avx2"))) std::size_t xorBlocksAvx2(const std::uint8_t *lhs, const std::uint8_t *rhs,
+                                                          std::size_t size, std::uint8_t *out)
+{
+    std::size_t i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        auto a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i));
+        auto a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i + 32));
+        auto b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i));
+        auto b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_xor_si256(a1, b1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + 32), _mm256_xor_si256(a2, b2));
+    }
+
+    return i;
+}
+
+/**
+ * @brief AVX-512 version of xorBlocksSse2, 64 bytes at a time
+ */
+__attribute__((target("avx512f"))) std::size_t xorBlocksAvx512(const std::uint8_t *lhs, const std::uint8_t *rhs,
+                                                               std::size_t size, std::uint8_t *out)
+{
+    std::size_t i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        auto a = _mm512_loadu_si512(lhs + i);
+        auto b = _mm512_loadu_si512(rhs + i);
+        _mm512_storeu_si512(out + i, _mm512_xor_si512(a, b));
+    }
+
+    return i;
+}
+
+/**
+ * @brief hamming distance 64 bits at a time with the POPCNT instruction
+ *
+ * @param count incremented by the number of differing bits
+ * @return the number of bytes processed
+ */
+__attribute__((target("popcnt"))) std::size_t hammingPopcnt(const std::uint8_t *lhs, const std::uint8_t *rhs,
+                                                            std::size_t size, std::uint64_t &count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t a, b;
+        std::memcpy(&a, lhs + i, sizeof(a));
+        std::memcpy(&b, rhs + i, sizeof(b));
+        count += static_cast<std::uint64_t>(__builtin_popcountll(a ^ b));
+    }
+
+    return i;
+}
+
+/**
+ * @brief hamming distance 32 bytes at a time: nibble popcounts are looked up with a shuffle and summed per 64 bit
+ * lane with SAD (Mula's method)
+ *
+ * @param count incremented by the number of differing bits
+ * @return the number of bytes processed
+ */
+__attribute__((target("avx2"))) std::size_t hammingAvx2(const std::uint8_t *lhs, const std::uint8_t *rhs,
+                                                        std::size_t size, std::uint64_t &count)
+{
+    const auto lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                         2, 3, 2, 3, 3, 4);
+    const auto lowMask = _mm256_set1_epi8(0x0f);
+    auto total = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        auto diff = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i)));
+        auto low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(diff, lowMask));
+        auto high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(diff, 4), lowMask));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+
+    count += static_cast<std::uint64_t>(_mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) +
+                                        _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3));
+    return i;
+}
+
+/**
+ * @brief hamming distance 64 bytes at a time with AVX-512 VPOPCNTQ
+ *
+ * @param count incremented by the number of differing bits
+ * @return the number of bytes processed
+ */
+__attribute__((target("avx512f,avx512vpopcntdq"))) std::size_t
+hammingAvx512(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size, std::uint64_t &count)
+{
+    auto total = _mm512_setzero_si512();
+
+    std::size_t i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        auto diff = _mm512_xor_si512(_mm512_loadu_si512(lhs + i), _mm512_loadu_si512(rhs + i));
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(diff));
+    }
+
+    // summed by hand, _mm512_reduce_add_epi64 trips -Wuninitialized on some gcc versions
+    alignas(64) std::uint64_t lanes[8];
+    _mm512_store_si512(lanes, total);
+    for (auto lane : lanes)
+    {
+        count += lane;
+    }
+    return i;
+}
+
+#endif
+
+} // namespace
+
+void XorKernel::xorBlocks(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size, std::uint8_t *out)
+{
+    std::size_t done = 0;
+
+#ifdef MATASANO_X86
+    if (CpuFeatures::hasAvx512())
+    {
+        done = xorBlocksAvx512(lhs, rhs, size, out);
+    }
+    else if (CpuFeatures::hasAvx2())
+    {
+        done = xorBlocksAvx2(lhs, rhs, size, out);
+    }
+    done += xorBlocksSse2(lhs + done, rhs + done, size - done, out + done);
+#endif
+
+    for (; done < size; done++)
+    {
+        out[done] = lhs[done] ^ rhs[done];
+    }
+}
+
+void XorKernel::xorRepeating(const std::uint8_t *data, std::size_t size, const std::uint8_t *key,
+                             std::size_t keySize, std::uint8_t *out)
+{
+    LOGIC_ASSERT(keySize != 0);
+
+    if (size < 2 * MAX_VECTOR_BYTES)
+    {
+        xorRepeatingScalar(data, size, key, keySize, out);
+        return;
+    }
+
+    if (keySize >= MIN_KEY_PERIOD)
+    {
+        // the key itself is long enough to be xored a key period at a time
+        for (std::size_t i = 0; i < size; i += keySize)
+        {
+            xorBlocks(data + i, key, std::min(keySize, size - i), out + i);
+        }
+        return;
+    }
+
+    // repeat the key a whole number of times, until it is long enough (but no longer than needed for the data)
+    auto periodSize = (std::min(size, MIN_KEY_PERIOD) + keySize - 1) / keySize * keySize;
+
+    std::array<std::uint8_t, 2 * MIN_KEY_PERIOD> expandedKey;
+    std::copy(key, key + keySize, expandedKey.data());
+    for (std::size_t filled = keySize; filled < periodSize; filled *= 2)
+    {
+        std::copy(expandedKey.data(), expandedKey.data() + std::min(filled, periodSize - filled),
+                  expandedKey.data() + filled);
+    }
+
+    for (std::size_t i = 0; i < size; i += periodSize)
+    {
+        xorBlocks(data + i, expandedKey.data(), std::min(periodSize, size - i), out + i);
+    }
+
+    // the expanded key is as secret as the key itself
+    std::fill_n(static_cast<volatile std::uint8_t *>(expandedKey.data()), periodSize, 0);
+}
+
+void XorKernel::xorRepeatingScalar(const std::uint8_t *data, std::size_t size, const std::uint8_t *key,
+                                   std::size_t keySize, std::uint8_t *out)
+{
+    for (std::size_t i = 0, k = 0; i < size; i++)
+    {
+        out[i] = data[i] ^ key[k];
+        if (++k == keySize)
+        {
+            k = 0;
+        }
+    }
+}
+
+std::uint64_t XorKernel::hammingDistance(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size)
+{
+    std::uint64_t count = 0;
+    std::size_t done = 0;
+
+#ifdef MATASANO_X86
+    if (CpuFeatures::hasAvx512Popcount())
+    {
+        done = hammingAvx512(lhs, rhs, size, count);
+    }
+    else if (CpuFeatures::hasAvx2())
+    {
+        done = hammingAvx2(lhs, rhs, size, count);
+    }
+
+    if (CpuFeatures::hasPopcount())
+    {
+        done += hammingPopcnt(lhs + done, rhs + done, size - done, count);
+    }
+#endif
+
+    return count + hammingDistanceScalar(lhs + done, rhs + done, size - done);
+}
+
+std::uint64_t XorKernel::hammingDistanceScalar(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size)
+{
+    std::uint64_t count = 0;
+
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t a, b;
+        std::memcpy(&a, lhs + i, sizeof(a));
+        std::memcpy(&b, rhs + i, sizeof(b));
+        count += static_cast<std::uint64_t>(std::popcount(a ^ b));
+    }
+
+    for (; i < size; i++)
+    {
+        count += static_cast<std::uint64_t>(std::popcount(static_cast<std::uint8_t>(lhs[i] ^ rhs[i])));
+    }
+
+    return count;
+}
@@ -0,0 +1,68 @@
+#ifndef MATASANO_XOR_KERNEL_H
+#define MATASANO_XOR_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Vectorized xor kernels used by ByteData and the xor breakers
+ */
+class XorKernel
+{
+public:
+    /**
+     * @brief The widest vector (in bytes) the kernels work with
+     */
+    static constexpr std::size_t MAX_VECTOR_BYTES = 64;
+
+    /**
+     * @brief xors data with a key that is applied cyclically: out[i] = data[i] ^ key[i % keySize]
+     * Short keys are first repeated into a buffer of a few KiB, and then the data is xored with that buffer (or with
+     * a long key as is) one period at a time, 16 / 32 / 64 bytes per step. SSE2 / AVX2 / AVX-512 is chosen at runtime
+     *
+     * @param data data to xor
+     * @param size number of bytes in data
+     * @param key key bytes
+     * @param keySize number of bytes in key, should not be 0
+     * @param out output buffer, should have room for size bytes (may be the same memory as data, but should not
+     * partially overlap with it)
+     */
+    static void xorRepeating(const std::uint8_t *data, std::size_t size, const std::uint8_t *key, std::size_t keySize,
+                             std::uint8_t *out);
+
+    /**
+     * @brief xors two buffers of the same size: out[i] = lhs[i] ^ rhs[i]
+     *
+     * @param lhs the first argument
+     * @param rhs the second argument
+     * @param size number of bytes in each of the arguments
+     * @param out output buffer, should have room for size bytes (may be the same memory as lhs or rhs)
+     */
+    static void xorBlocks(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size, std::uint8_t *out);
+
+    /**
+     * @brief hamming distance (number of differing bits) between two buffers of the same size, nothing is allocated
+     * Counts with AVX-512 VPOPCNTQ, AVX2 nibble lookup or 64 bit POPCNT, chosen at runtime
+     *
+     * @param lhs the first argument
+     * @param rhs the second argument
+     * @param size number of bytes in each of the arguments
+     * @return the number of bits that differ
+     */
+    static std::uint64_t hammingDistance(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size);
+
+private:
+    /**
+     * @brief scalar version of xorRepeating, also used for inputs that are too short to be worth the key expansion
+     */
+    static void xorRepeatingScalar(const std::uint8_t *data, std::size_t size, const std::uint8_t *key,
+                                   std::size_t keySize, std::uint8_t *out);
+
+    /**
+     * @brief portable version of hammingDistance, 64 bits at a time, also used to finish what the vectorized version
+     * did not process
+     */
+    static std::uint64_t hammingDistanceScalar(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size);
+};
+
+#endif
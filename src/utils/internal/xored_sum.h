@@ -0,0 +1,58 @@
+#ifndef MATASANO_XORED_SUM_H
+#define MATASANO_XORED_SUM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The summing loop shared by ByteDistribution::distance and the xor scorers (@see XorScorer): both compare a
+ * table of the 256 byte values against a reference as if the data was xored with a single byte key first
+ */
+class XoredSum
+{
+public:
+    /**
+     * @brief number of partial sums, independent so the compiler can keep them in vector registers
+     */
+    static constexpr std::size_t LANES = 8;
+
+    /**
+     * @brief sums f(values[b ^ key], b) over all the indices b of values. The high bits of key move whole groups of
+     * lanes, the low bits shuffle the lanes inside a group, so the loop stays vectorizable for every key
+     *
+     * @param values the table, its size a multiple of LANES and of the key range
+     * @param key the xor key
+     * @param f the summed function of the xored value (as a double) and of its index
+     * @return the sum
+     */
+    template <typename T, std::size_t N, typename F>
+    static double sum(const std::array<T, N> &values, std::uint8_t key, F &&f)
+    {
+        static_assert(N % LANES == 0 && N >= 256, "the table should be whole groups of lanes and cover every key");
+
+        std::array<double, LANES> sums{};
+
+        const std::size_t groupKey = key & ~(LANES - 1);
+        const std::size_t laneKey = key & (LANES - 1);
+
+        for (std::size_t i = 0; i < N; i += LANES)
+        {
+            const T *group = values.data() + (i ^ groupKey);
+            for (std::size_t lane = 0; lane < LANES; lane++)
+            {
+                sums[lane] += f(static_cast<double>(group[lane ^ laneKey]), i + lane);
+            }
+        }
+
+        double result = 0;
+        for (auto partial : sums)
+        {
+            result += partial;
+        }
+
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "language_model.h"
+#include "internal/mapped_file.h"
+#include "matasano_asserts.h"
+
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+/**
+ * @brief the magic the model file starts with
+ */
+constexpr std::array<std::uint8_t, 4> MAGIC = {'M', 'L', 'M', '1'};
+
+/**
+ * @brief the only supported format version
+ */
+constexpr std::uint32_t VERSION = 1;
+
+template <typename T> T readLittleEndian(const std::uint8_t *data)
+{
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        value |= static_cast<T>(static_cast<T>(data[i]) << (8 * i));
+    }
+    return value;
+}
+
+template <typename T> void writeLittleEndian(T value, std::ofstream &file)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        file.put(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+} // namespace
+
+LanguageModel::LanguageModel(ByteView referenceText)
+    : histogram_(ByteDistribution::histogram(referenceText)), total_(referenceText.size())
+{
+}
+
+LanguageModel LanguageModel::load(const std::string &fileName)
+{
+    MappedFile file(fileName);
+    return parse(file.view());
+}
+
+LanguageModel LanguageModel::parse(ByteView data)
+{
+    THROW_IF(data.size() != FILE_SIZE,
+             "language model should be " + std::to_string(FILE_SIZE) + " bytes, got " + std::to_string(data.size()),
+             std::invalid_argument);
+    THROW_IF(!std::equal(MAGIC.begin(), MAGIC.end(), data.begin()), "not a language model", std::invalid_argument);
+
+    auto version = readLittleEndian<std::uint32_t>(data.data() + 4);
+    THROW_IF(version != VERSION, "unsupported language model version " + std::to_string(version),
+             std::invalid_argument);
+
+    LanguageModel model(ByteDistribution::Histogram{}, readLittleEndian<std::uint64_t>(data.data() + 8));
+
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < ByteDistribution::BINS; i++)
+    {
+        model.histogram_[i] = readLittleEndian<std::uint32_t>(data.data() + 16 + 4 * i);
+        sum += model.histogram_[i];
+    }
+    THROW_IF(sum != model.total_, "language model counts do not add up to its total", std::invalid_argument);
+
+    return model;
+}
+
+void LanguageModel::save(const std::string &fileName) const
+{
+    std::ofstream file;
+    file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    file.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    file.write(reinterpret_cast<const char *>(MAGIC.data()), MAGIC.size());
+    writeLittleEndian(VERSION, file);
+    writeLittleEndian(total_, file);
+    for (auto count : histogram_)
+    {
+        writeLittleEndian(count, file);
+    }
+
+    file.close();
+}
@@ -0,0 +1,99 @@
+#ifndef MATASANO_LANGUAGE_MODEL_H
+#define MATASANO_LANGUAGE_MODEL_H
+
+#include "byte_distribution.h"
+#include "byte_view.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Precompiled statistics of a reference language, so a large reference text does not have to be read and counted
+ * every time a decryptor is created
+ *
+ * The binary file format (all the numbers are little endian):
+ * offset  size      field
+ * 0       4         magic "MLM1"
+ * 4       4         format version, 1
+ * 8       8         total number of bytes in the reference text
+ * 16      256 * 4   number of times each byte value appears in the reference text
+ */
+class LanguageModel
+{
+public:
+    /**
+     * @brief Construct a new Language Model object by counting a reference text
+     *
+     * @param referenceText reference text in the language to model
+     */
+    explicit LanguageModel(ByteView referenceText);
+
+    /**
+     * @brief Loads a model that was saved with save(). The file is memory mapped, so only the model itself is read
+     *
+     * @param fileName filename or path to read from
+     * @return the model
+     *
+     * @throw std::ifstream::failure if the file can't be opened or mapped
+     * @throw std::invalid_argument if the file is not a model of a supported version
+     */
+    static LanguageModel load(const std::string &fileName);
+
+    /**
+     * @brief Saves the model in the binary format described above
+     *
+     * @param fileName filename or path to write to, overwritten if exists
+     *
+     * @throw std::ofstream::failure on any failure during writing the file
+     */
+    void save(const std::string &fileName) const;
+
+    /**
+     * @brief the byte distribution of the reference text
+     */
+    inline ByteDistribution distribution() const { return ByteDistribution(histogram_, total_); }
+
+    /**
+     * @brief number of times each byte value appears in the reference text
+     */
+    inline const ByteDistribution::Histogram &histogram() const { return histogram_; }
+
+    /**
+     * @brief total number of bytes in the reference text
+     */
+    inline std::uint64_t total() const { return total_; }
+
+    /**
+     * @brief size of the model file in bytes
+     */
+    static constexpr std::size_t FILE_SIZE = 16 + ByteDistribution::BINS * 4;
+
+private:
+    /**
+     * @brief Construct a new Language Model object from already known counts
+     */
+    LanguageModel(const ByteDistribution::Histogram &histogram, std::uint64_t total)
+        : histogram_(histogram), total_(total){};
+
+    /**
+     * @brief parses the binary format described above
+     *
+     * @param data file contents
+     * @return the model
+     *
+     * @throw std::invalid_argument if data is not a model of a supported version
+     */
+    static LanguageModel parse(ByteView data);
+
+    /**
+     * number of times each byte value appears in the reference text
+     */
+    ByteDistribution::Histogram histogram_{};
+
+    /**
+     * total number of bytes in the reference text
+     */
+    std::uint64_t total_ = 0;
+};
+
+#endif
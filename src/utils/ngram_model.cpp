@@ -0,0 +1,375 @@
+#include "ngram_model.h"
+#include "internal/cpu_features.h"
+#include "matasano_asserts.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#ifdef MATASANO_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+constexpr std::size_t CLASSES = NGramModel::CLASSES;
+
+/**
+ * @brief builds the byte to class table: 0 - anything else, 1 - space, 2..27 - letters, 28 - digits,
+ * 29 - punctuation, 30 - other printable characters, 31 - line breaks and tabs
+ */
+constexpr std::array<std::uint8_t, 256> makeClassTable()
+{
+    std::array<std::uint8_t, 256> table{};
+    for (std::size_t byte = 0x21; byte < 0x7f; byte++)
+    {
+        table[byte] = 30;
+    }
+    for (std::size_t letter = 0; letter < 26; letter++)
+    {
+        table['a' + letter] = static_cast<std::uint8_t>(2 + letter);
+        table['A' + letter] = static_cast<std::uint8_t>(2 + letter);
+    }
+    for (std::size_t digit = 0; digit < 10; digit++)
+    {
+        table['0' + digit] = 28;
+    }
+    for (auto punctuation : {'.', ',', ';', ':', '!', '?', '\'', '"', '-'})
+    {
+        table[static_cast<std::uint8_t>(punctuation)] = 29;
+    }
+    table[' '] = 1;
+    table['\n'] = 31;
+    table['\r'] = 31;
+    table['\t'] = 31;
+
+    return table;
+}
+
+constexpr std::array<std::uint8_t, 256> CLASS_OF = makeClassTable();
+
+/**
+ * @brief index of trigram a b c in the trigram table
+ */
+inline std::size_t trigramIndex(std::uint8_t a, std::uint8_t b, std::uint8_t c)
+{
+    return (static_cast<std::size_t>(a) * CLASSES + b) * CLASSES + c;
+}
+
+#ifdef MATASANO_X86
+
+/**
+ * @brief sums the trigram log probabilities of 8 trigrams at a time (classes [i, i + 3) for 8 consecutive i) with
+ * AVX2 gathers
+ *
+ * @param sum incremented by the sum
+ * @return the number of trigrams processed
+ */
+__attribute__((target("avx2"))) std::size_t sumTrigramsAvx2(const std::uint8_t *classes, std::size_t numTrigrams,
+                                                            const float *table, double &sum)
+{
+    auto total = _mm256_setzero_ps();
+
+    std::size_t i = 0;
+    for (; i + 8 <= numTrigrams; i += 8)
+    {
+        auto a = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(classes + i)));
+        auto b = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(classes + i + 1)));
+        auto c = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(classes + i + 2)));
+        auto index = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a, 10), _mm256_slli_epi32(b, 5)), c);
+        total = _mm256_add_ps(total, _mm256_i32gather_ps(table, index, 4));
+    }
+
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, total);
+    for (auto lane : lanes)
+    {
+        sum += lane;
+    }
+    return i;
+}
+
+/**
+ * @brief AVX-512 version of sumTrigramsAvx2, 16 trigrams at a time
+ */
+__attribute__((target("avx512f"))) std::size_t sumTrigramsAvx512(const std::uint8_t *classes, std::size_t numTrigrams,
+                                                                 const float *table, double &sum)
+{
+    // the masked forms with all the lanes on, the plain ones trip -Wmaybe-uninitialized on some gcc versions
+    const __mmask16 all = 0xffff;
+    auto total = _mm512_setzero_ps();
+
+    std::size_t i = 0;
+    for (; i + 16 <= numTrigrams; i += 16)
+    {
+        auto a = _mm512_maskz_cvtepu8_epi32(all, _mm_loadu_si128(reinterpret_cast<const __m128i *>(classes + i)));
+        auto b = _mm512_maskz_cvtepu8_epi32(all, _mm_loadu_si128(reinterpret_cast<const __m128i *>(classes + i + 1)));
+        auto c = _mm512_maskz_cvtepu8_epi32(all, _mm_loadu_si128(reinterpret_cast<const __m128i *>(classes + i + 2)));
+        auto ab = _mm512_or_si512(_mm512_maskz_slli_epi32(all, a, 10), _mm512_maskz_slli_epi32(all, b, 5));
+        auto index = _mm512_or_si512(ab, c);
+        total = _mm512_add_ps(total, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), all, index, table, 4));
+    }
+
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, total);
+    for (auto lane : lanes)
+    {
+        sum += lane;
+    }
+    return i;
+}
+
+/**
+ * @brief adds the trigram log probabilities of (a[i], b[i], c[i]) to sums[i], 8 at a time with AVX2 gathers
+ *
+ * @return the number of trigrams processed
+ */
+__attribute__((target("avx2"))) std::size_t accumulateTrigramsAvx2(const std::uint8_t *a, const std::uint8_t *b,
+                                                                   const std::uint8_t *c, std::size_t size,
+                                                                   const float *table, float *sums)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        auto va = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(a + i)));
+        auto vb = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(b + i)));
+        auto vc = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(c + i)));
+        auto index = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(va, 10), _mm256_slli_epi32(vb, 5)), vc);
+        auto sum = _mm256_add_ps(_mm256_loadu_ps(sums + i), _mm256_i32gather_ps(table, index, 4));
+        _mm256_storeu_ps(sums + i, sum);
+    }
+
+    return i;
+}
+
+/**
+ * @brief AVX-512 version of accumulateTrigramsAvx2, 16 at a time
+ */
+__attribute__((target("avx512f"))) std::size_t accumulateTrigramsAvx512(const std::uint8_t *a, const std::uint8_t *b,
+                                                                        const std::uint8_t *c, std::size_t size,
+                                                                        const float *table, float *sums)
+{
+    // the masked forms with all the lanes on, like in sumTrigramsAvx512
+    const __mmask16 all = 0xffff;
+
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        auto va = _mm512_maskz_cvtepu8_epi32(all, _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+        auto vb = _mm512_maskz_cvtepu8_epi32(all, _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+        auto vc = _mm512_maskz_cvtepu8_epi32(all, _mm_loadu_si128(reinterpret_cast<const __m128i *>(c + i)));
+        auto ab = _mm512_or_si512(_mm512_maskz_slli_epi32(all, va, 10), _mm512_maskz_slli_epi32(all, vb, 5));
+        auto gathered = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), all, _mm512_or_si512(ab, vc), table, 4);
+        _mm512_storeu_ps(sums + i, _mm512_add_ps(_mm512_loadu_ps(sums + i), gathered));
+    }
+
+    return i;
+}
+
+#endif
+
+/**
+ * @brief adds the trigram log probabilities of (a[i], b[i], c[i]) to sums[i] for all i in [0, size)
+ */
+void accumulateTrigrams(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c, std::size_t size,
+                        const float *table, float *sums)
+{
+    std::size_t done = 0;
+
+#ifdef MATASANO_X86
+    if (CpuFeatures::hasAvx512())
+    {
+        done = accumulateTrigramsAvx512(a, b, c, size, table, sums);
+    }
+    if (CpuFeatures::hasAvx2())
+    {
+        done += accumulateTrigramsAvx2(a + done, b + done, c + done, size - done, table, sums + done);
+    }
+#endif
+
+    for (; done < size; done++)
+    {
+        sums[done] += table[trigramIndex(a[done], b[done], c[done])];
+    }
+}
+
+/**
+ * @brief sum of the trigram log probabilities of classes [i, i + 3) for all i in [0, numTrigrams)
+ *
+ * @param classes character classes, numTrigrams + 2 of them
+ * @param numTrigrams number of trigrams to score
+ * @param table the trigram table
+ * @return the sum
+ */
+double sumTrigrams(const std::uint8_t *classes, std::size_t numTrigrams, const float *table)
+{
+    double sum = 0;
+    std::size_t done = 0;
+
+#ifdef MATASANO_X86
+    if (CpuFeatures::hasAvx512())
+    {
+        done = sumTrigramsAvx512(classes, numTrigrams, table, sum);
+    }
+    if (CpuFeatures::hasAvx2())
+    {
+        done += sumTrigramsAvx2(classes + done, numTrigrams - done, table, sum);
+    }
+#endif
+
+    for (; done < numTrigrams; done++)
+    {
+        sum += table[trigramIndex(classes[done], classes[done + 1], classes[done + 2])];
+    }
+
+    return sum;
+}
+} // namespace
+
+NGramModel::NGramModel(ByteView referenceText) : trigrams_(CLASSES * CLASSES * CLASSES)
+{
+    std::array<std::uint64_t, CLASSES> unigramCounts{};
+    std::array<std::uint64_t, CLASSES * CLASSES> bigramCounts{};
+    std::vector<std::uint64_t> trigramCounts(trigrams_.size(), 0);
+
+    std::uint8_t a = 0, b = 0;
+    for (std::size_t i = 0; i < referenceText.size(); i++)
+    {
+        auto c = CLASS_OF[referenceText[i]];
+        unigramCounts[c]++;
+        if (i >= 1)
+        {
+            bigramCounts[b * CLASSES + c]++;
+        }
+        if (i >= 2)
+        {
+            trigramCounts[trigramIndex(a, b, c)]++;
+        }
+        a = b;
+        b = c;
+    }
+
+    // add-one smoothing, so that n-grams that never appear in the reference text are unlikely but not impossible
+    auto logProbability = [](std::uint64_t count, std::uint64_t contextCount) {
+        auto probability = static_cast<double>(count + 1) / static_cast<double>(contextCount + CLASSES);
+        return static_cast<float>(std::log(probability));
+    };
+
+    for (std::size_t x = 0; x < CLASSES; x++)
+    {
+        unigrams_[x] = logProbability(unigramCounts[x], referenceText.size());
+
+        std::uint64_t bigramContext = 0;
+        for (std::size_t y = 0; y < CLASSES; y++)
+        {
+            bigramContext += bigramCounts[x * CLASSES + y];
+        }
+        for (std::size_t y = 0; y < CLASSES; y++)
+        {
+            bigrams_[x * CLASSES + y] = logProbability(bigramCounts[x * CLASSES + y], bigramContext);
+
+            auto context = (x * CLASSES + y) * CLASSES;
+            std::uint64_t trigramContext = 0;
+            for (std::size_t z = 0; z < CLASSES; z++)
+            {
+                trigramContext += trigramCounts[context + z];
+            }
+            for (std::size_t z = 0; z < CLASSES; z++)
+            {
+                trigrams_[context + z] = logProbability(trigramCounts[context + z], trigramContext);
+            }
+        }
+    }
+}
+
+std::uint8_t NGramModel::classOf(std::uint8_t byte) { return CLASS_OF[byte]; }
+
+double NGramModel::score(ByteView text) const
+{
+    static const std::uint8_t noKey = 0;
+    return score(text, ByteView(&noKey, 1));
+}
+
+double NGramModel::score(ByteView cipheredData, ByteView key) const
+{
+    THROW_IF(cipheredData.empty(), "can't score empty data", std::invalid_argument);
+    THROW_IF(key.empty(), "key is empty", std::invalid_argument);
+
+    // the last 2 classes of the previous chunk, followed by the classes of the current one
+    std::array<std::uint8_t, 2 + SCORE_CHUNK> classes;
+    std::size_t keyIndex = 0;
+    auto decode = [&](std::size_t from, std::size_t count, std::uint8_t *out) {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            out[i] = CLASS_OF[cipheredData[from + i] ^ key[keyIndex]];
+            if (++keyIndex == key.size())
+            {
+                keyIndex = 0;
+            }
+        }
+    };
+
+    decode(0, std::min<std::size_t>(2, cipheredData.size()), classes.data());
+    double logLikelihood = unigrams_[classes[0]];
+    if (cipheredData.size() > 1)
+    {
+        logLikelihood += bigrams_[classes[0] * CLASSES + classes[1]];
+    }
+
+    for (std::size_t position = 2; position < cipheredData.size(); position += SCORE_CHUNK)
+    {
+        auto count = std::min(SCORE_CHUNK, cipheredData.size() - position);
+        decode(position, count, classes.data() + 2);
+        logLikelihood += sumTrigrams(classes.data(), count, trigrams_.data());
+
+        classes[0] = classes[count];
+        classes[1] = classes[count + 1];
+    }
+
+    return -logLikelihood / static_cast<double>(cipheredData.size());
+}
+
+void NGramModel::scoreWindows(const std::uint8_t *data, std::size_t numWindows, ByteView key, double *scores) const
+{
+    THROW_IF(key.empty(), "key is empty", std::invalid_argument);
+    THROW_IF(numWindows > MAX_WINDOWS, "too many windows", std::invalid_argument);
+
+    // classes of the last 3 key positions of all the windows: rows[r][o] is the class of data[o + j] ^ key[j]
+    std::array<std::array<std::uint8_t, MAX_WINDOWS>, 3> rows;
+    std::array<float, MAX_WINDOWS> sums;
+
+    auto fillRow = [&](std::uint8_t *row, std::size_t j) {
+        for (std::size_t o = 0; o < numWindows; o++)
+        {
+            row[o] = CLASS_OF[data[o + j] ^ key[j]];
+        }
+    };
+
+    fillRow(rows[0].data(), 0);
+    for (std::size_t o = 0; o < numWindows; o++)
+    {
+        sums[o] = unigrams_[rows[0][o]];
+    }
+
+    if (key.size() > 1)
+    {
+        fillRow(rows[1].data(), 1);
+        for (std::size_t o = 0; o < numWindows; o++)
+        {
+            sums[o] += bigrams_[rows[0][o] * CLASSES + rows[1][o]];
+        }
+    }
+
+    for (std::size_t j = 2; j < key.size(); j++)
+    {
+        auto *a = rows[(j - 2) % 3].data();
+        auto *b = rows[(j - 1) % 3].data();
+        auto *c = rows[j % 3].data();
+        fillRow(c, j);
+        accumulateTrigrams(a, b, c, numWindows, trigrams_.data(), sums.data());
+    }
+
+    for (std::size_t o = 0; o < numWindows; o++)
+    {
+        scores[o] = -static_cast<double>(sums[o]) / static_cast<double>(key.size());
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef MATASANO_NGRAM_MODEL_H
+#define MATASANO_NGRAM_MODEL_H
+
+#include "byte_view.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Character trigram model of a reference language, used to tell how likely a text is in that language
+ * Unlike a byte distribution, it looks at the order of the characters, so it can tell the right key from a wrong one
+ * on much shorter texts.
+ *
+ * The bytes are folded into CLASSES character classes (letters regardless of case, space, digits, punctuation,
+ * line breaks, other printable characters, and everything else), so the tables are small enough to stay in the cache:
+ * the trigram table is CLASSES^3 floats (128 KiB). The tables hold log probabilities with add-one smoothing
+ */
+class NGramModel
+{
+public:
+    /**
+     * @brief number of character classes
+     */
+    static constexpr std::size_t CLASSES = 32;
+
+    /**
+     * @brief Construct a new NGram Model object by counting the n-grams of a reference text
+     *
+     * @param referenceText reference text in the language to model
+     */
+    explicit NGramModel(ByteView referenceText);
+
+    /**
+     * @brief character class of a byte
+     *
+     * @param byte the byte
+     * @return its class, less than CLASSES
+     */
+    static std::uint8_t classOf(std::uint8_t byte);
+
+    /**
+     * @brief Measure of how unlikely a text is in the reference language: the negative log likelihood of the text
+     * under the model, per byte. The first byte is scored with the unigram table, the second one with the bigram
+     * table and the rest with the trigram table. Nothing is allocated, the trigrams are looked up with vector gathers
+     * (AVX-512 / AVX2, chosen at runtime)
+     *
+     * @param text the text to score, can't be empty
+     * @return non-negative score, the lower it is - the more likely the text is
+     * @throw std::invalid_argument if text is empty
+     */
+    double score(ByteView text) const;
+
+    /**
+     * @brief same as score(cipheredData ^ key) with a repeating key, without building the deciphered text
+     *
+     * @param cipheredData the ciphered text, can't be empty
+     * @param key the key that is applied cyclically, can't be empty
+     * @return non-negative score, the lower it is - the more likely the deciphered text is
+     * @throw std::invalid_argument if cipheredData or key is empty
+     */
+    double score(ByteView cipheredData, ByteView key) const;
+
+    /**
+     * @brief the maximum number of windows scoreWindows scores in one call
+     */
+    static constexpr std::size_t MAX_WINDOWS = 4096;
+
+    /**
+     * @brief Scores every window of data xored with a key of the same length: scores[o] = score(data[o, o + key size)
+     * ^ key) for each o in [0, numWindows). The windows are scored together, one key position at a time, so the class
+     * rows and the partial sums of all of them stay in the L1 cache and the trigram lookups of neighbouring windows are
+     * done with vector gathers (AVX-512 / AVX2, chosen at runtime). Nothing is allocated
+     *
+     * @param data the data, numWindows + key size - 1 bytes of it are read
+     * @param numWindows number of windows to score, at most MAX_WINDOWS
+     * @param key the key (a crib), can't be empty
+     * @param scores output, numWindows scores (@see score)
+     * @throw std::invalid_argument if key is empty or numWindows is more than MAX_WINDOWS
+     */
+    void scoreWindows(const std::uint8_t *data, std::size_t numWindows, ByteView key, double *scores) const;
+
+    /**
+     * @brief log P(class b | class a), the bigram table indexed by a * CLASSES + b (@see classOf)
+     */
+    inline const std::array<float, CLASSES * CLASSES> &bigrams() const { return bigrams_; }
+
+private:
+    /**
+     * number of bytes that are converted to classes and scored at a time
+     */
+    static constexpr std::size_t SCORE_CHUNK = 256;
+
+    /**
+     * log P(a), indexed by a
+     */
+    std::array<float, CLASSES> unigrams_{};
+
+    /**
+     * log P(b | a), indexed by a * CLASSES + b
+     */
+    std::array<float, CLASSES * CLASSES> bigrams_{};
+
+    /**
+     * log P(c | a b), indexed by (a * CLASSES + b) * CLASSES + c
+     */
+    std::vector<float> trigrams_;
+};
+
+#endif
@@ -27,13 +27,18 @@ ByteData Padder::padToBlockSize(const ByteData &unpaddedBlock, std::uint8_t bloc
 }
 
 ByteData Padder::removePadding(const ByteData &paddedBlock)
+{
+    return paddedBlock.subData(0, paddedBlock.size() - paddingSize(paddedBlock));
+}
+
+std::size_t Padder::paddingSize(ByteView paddedBlock)
 {
     if (paddedBlock.size() == 0)
     {
-        return paddedBlock;
+        return 0;
     }
 
-    std::uint8_t bytesToRemove = paddedBlock.secureData().back();
+    std::uint8_t bytesToRemove = paddedBlock[paddedBlock.size() - 1];
 
     THROW_IF(bytesToRemove > paddedBlock.size(),
              "the padding is wrong, there are " + std::to_string(bytesToRemove) +
@@ -43,13 +48,13 @@ ByteData Padder::removePadding(const ByteData &paddedBlock)
 
     validatePadding(paddedBlock, bytesToRemove);
 
-    return paddedBlock.subData(0, paddedBlock.size() - bytesToRemove);
+    return bytesToRemove;
 }
 
-void Padder::validatePadding(const ByteData &paddedBlock, std::uint8_t padByte)
+void Padder::validatePadding(ByteView paddedBlock, std::uint8_t padByte)
 {
     for (std::size_t i = paddedBlock.size() - padByte; i < paddedBlock.size(); i++)
     {
-        THROW_IF(paddedBlock.secureData().at(i) != padByte, "the padding is wrong", std::invalid_argument);
+        THROW_IF(paddedBlock[i] != padByte, "the padding is wrong", std::invalid_argument);
     }
-}
\ No newline at end of file
+}
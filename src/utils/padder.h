@@ -2,7 +2,9 @@
 #define MATASANO_PADDER_H
 
 #include "byte_data.h"
+#include "byte_view.h"
 #include "crypto_constants.h"
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -46,6 +48,17 @@ public:
      */
     static ByteData removePadding(const ByteData &paddedBlock);
 
+    /**
+     * @brief The number of padding bytes at the end of a block padded according to PKCS#7 format, checked the same way
+     * as removePadding does, without copying the block
+     *
+     * @param paddedBlock padded block
+     * @return the number of bytes to remove from its end, 0 if the block is empty
+     *
+     * @throw std::invalid_argument if padding is invalid
+     */
+    static std::size_t paddingSize(ByteView paddedBlock);
+
 private:
     /**
      * @brief Make sure the padding is according to pkcs#7 format (@see padToBlockSize)
@@ -56,7 +69,7 @@ private:
      *
      * @throw std::invalid_argument if the padding is invalid
      */
-    static void validatePadding(const ByteData &paddedBlock, std::uint8_t bytesNumToPad);
+    static void validatePadding(ByteView paddedBlock, std::uint8_t bytesNumToPad);
 };
 
 #endif
@@ -0,0 +1,87 @@
+#ifndef MATASANO_TOP_K_H
+#define MATASANO_TOP_K_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Keeps the best 'capacity' values out of all the values pushed into it. The values are held in a heap of a
+ * fixed capacity (the worst kept value on top), so pushing is O(log capacity) and nothing is allocated after the first
+ * 'capacity' pushes
+ *
+ * @tparam T type of the values
+ * @tparam Better strict weak ordering, Better(a, b) is true if a should be ranked before b
+ */
+template <typename T, typename Better = std::less<T>> class TopK
+{
+public:
+    /**
+     * @brief Construct a new TopK object
+     *
+     * @param capacity the maximum number of values to keep, may be 0
+     * @param better the ordering
+     */
+    explicit TopK(std::size_t capacity, Better better = Better{}) : capacity_(capacity), better_(std::move(better))
+    {
+        heap_.reserve(capacity_);
+    }
+
+    /**
+     * @brief Offers a value, it is kept only if it is better than the worst kept value (or there is still room)
+     *
+     * @param value the value
+     */
+    void push(T value)
+    {
+        if (heap_.size() < capacity_)
+        {
+            heap_.push_back(std::move(value));
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+        }
+        else if (capacity_ != 0 && better_(value, heap_.front()))
+        {
+            std::pop_heap(heap_.begin(), heap_.end(), better_);
+            heap_.back() = std::move(value);
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+        }
+    }
+
+    /**
+     * @brief the number of values kept
+     */
+    inline std::size_t size() const { return heap_.size(); }
+
+    /**
+     * @brief Returns the kept values, best first. This object is left empty
+     *
+     * @return the values
+     */
+    std::vector<T> extractSorted()
+    {
+        std::sort_heap(heap_.begin(), heap_.end(), better_);
+
+        std::vector<T> result;
+        result.swap(heap_);
+        return result;
+    }
+
+private:
+    /**
+     * the maximum number of values to keep
+     */
+    std::size_t capacity_;
+
+    /**
+     * the ordering
+     */
+    Better better_;
+
+    /**
+     * the kept values, a heap with the worst of them on top
+     */
+    std::vector<T> heap_;
+};
+
+#endif
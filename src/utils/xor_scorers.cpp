@@ -0,0 +1,97 @@
+#include "xor_scorers.h"
+#include "internal/xored_sum.h"
+
+#include <cmath>
+
+namespace
+{
+constexpr std::size_t BINS = ByteDistribution::BINS;
+
+/**
+ * @brief probability of each byte value in the reference language, with add-one smoothing
+ */
+std::array<double, BINS> smoothedProbabilities(const LanguageModel &model)
+{
+    std::array<double, BINS> probabilities;
+    for (std::size_t b = 0; b < BINS; b++)
+    {
+        probabilities[b] =
+            static_cast<double>(model.histogram()[b] + 1) / static_cast<double>(model.total() + BINS);
+    }
+
+    return probabilities;
+}
+} // namespace
+
+L1Scorer::L1Scorer(const ByteDistribution &reference)
+{
+    for (std::size_t b = 0; b < BINS; b++)
+    {
+        referencePercentages_[b] = reference.at(static_cast<std::uint8_t>(b));
+    }
+}
+
+double L1Scorer::score(const ByteDistribution::Histogram &counts, std::size_t total, std::uint8_t key) const
+{
+    // an empty data has all the percentages 0, like an empty ByteDistribution
+    double oneElmPercentage = total == 0 ? 0.0 : 100.0 / static_cast<double>(total);
+
+    return XoredSum::sum(counts, key, [&](double count, std::size_t b) {
+        return std::abs(count * oneElmPercentage - referencePercentages_[b]);
+    });
+}
+
+ChiSquaredScorer::ChiSquaredScorer(const LanguageModel &model) : probabilities_(smoothedProbabilities(model)) {}
+
+double ChiSquaredScorer::score(const ByteDistribution::Histogram &counts, std::size_t total, std::uint8_t key) const
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    // sum((observed - expected)^2 / expected) / total, with expected = total * p
+    auto n = static_cast<double>(total);
+    return XoredSum::sum(counts, key, [&](double count, std::size_t b) {
+               auto expected = n * probabilities_[b];
+               return (count - expected) * (count - expected) / expected;
+           }) /
+           n;
+}
+
+LogLikelihoodScorer::LogLikelihoodScorer(const LanguageModel &model)
+{
+    auto probabilities = smoothedProbabilities(model);
+    for (std::size_t b = 0; b < BINS; b++)
+    {
+        negativeLogProbabilities_[b] = -std::log(probabilities[b]);
+    }
+}
+
+double LogLikelihoodScorer::score(const ByteDistribution::Histogram &counts, std::size_t total,
+                                  std::uint8_t key) const
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    auto sum =
+        XoredSum::sum(counts, key, [&](double count, std::size_t b) { return count * negativeLogProbabilities_[b]; });
+    return sum / static_cast<double>(total);
+}
+
+double PrintableScorer::score(const ByteDistribution::Histogram &counts, std::size_t total, std::uint8_t key) const
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    auto notPrintable = XoredSum::sum(counts, key, [](double count, std::size_t b) {
+        auto printable = (b >= 0x20 && b < 0x7f) || b == '\n' || b == '\r' || b == '\t';
+        return printable ? 0.0 : count;
+    });
+
+    return notPrintable / static_cast<double>(total);
+}
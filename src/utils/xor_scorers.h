@@ -0,0 +1,129 @@
+#ifndef MATASANO_XOR_SCORERS_H
+#define MATASANO_XOR_SCORERS_H
+
+#include "byte_distribution.h"
+#include "language_model.h"
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A strategy that scores single byte xor keys by the byte counts of the ciphered data: score(counts, total, key)
+ * tells how unlikely the data deciphered with key is in the reference language, the lower - the more likely. Xor with
+ * a constant byte only permutes the counts, so the data itself is not needed: the deciphered data has counts[b ^ key]
+ * bytes of value b
+ *
+ * The scorers are template parameters, so the loop over the keys is compiled for each scorer and there is no virtual
+ * call per key. The static single byte key methods of BasicDecryptorXor take a scorer (decipherSingle,
+ * scoreSingleByteKeys, rankSingleByteKeys), all its other methods (the batch and multi byte key ones, the measures of
+ * confidence) score with the ReferenceScorer the decryptor is instantiated with, L1Scorer by default
+ */
+template <typename Scorer>
+concept XorScorer = requires(const Scorer &scorer, const ByteDistribution::Histogram &counts, std::size_t total,
+                             std::uint8_t key) {
+    {
+        scorer.score(counts, total, key)
+    } -> std::same_as<double>;
+};
+
+/**
+ * @brief L1 distance between the percentages of the deciphered bytes and of the reference language, same as
+ * ByteDistribution::distance. This is what DecryptorXor uses by default
+ */
+class L1Scorer
+{
+public:
+    /**
+     * @brief Construct a new L1 Scorer object
+     *
+     * @param reference the byte distribution of the reference language
+     */
+    explicit L1Scorer(const ByteDistribution &reference);
+
+    /**
+     * @brief Construct a new L1 Scorer object
+     *
+     * @param model the model of the reference language
+     */
+    explicit L1Scorer(const LanguageModel &model) : L1Scorer(model.distribution()) {}
+
+    /**
+     * @brief @see XorScorer
+     */
+    double score(const ByteDistribution::Histogram &counts, std::size_t total, std::uint8_t key) const;
+
+private:
+    /**
+     * percentage of each byte value in the reference language
+     */
+    std::array<double, ByteDistribution::BINS> referencePercentages_{};
+};
+
+/**
+ * @brief Pearson's chi-squared statistic of the deciphered bytes against the reference language, per byte (so that
+ * scores of data of different lengths can be compared). Punishes bytes that are rare in the reference language much
+ * harder than L1 does
+ */
+class ChiSquaredScorer
+{
+public:
+    /**
+     * @brief Construct a new Chi Squared Scorer object
+     *
+     * @param model the model of the reference language
+     */
+    explicit ChiSquaredScorer(const LanguageModel &model);
+
+    /**
+     * @brief @see XorScorer
+     */
+    double score(const ByteDistribution::Histogram &counts, std::size_t total, std::uint8_t key) const;
+
+private:
+    /**
+     * probability of each byte value in the reference language, with add-one smoothing so none of them is 0
+     */
+    std::array<double, ByteDistribution::BINS> probabilities_{};
+};
+
+/**
+ * @brief Negative log likelihood of the deciphered bytes under the byte distribution of the reference language, per
+ * byte. This is the unigram version of NGramModel::score
+ */
+class LogLikelihoodScorer
+{
+public:
+    /**
+     * @brief Construct a new Log Likelihood Scorer object
+     *
+     * @param model the model of the reference language
+     */
+    explicit LogLikelihoodScorer(const LanguageModel &model);
+
+    /**
+     * @brief @see XorScorer
+     */
+    double score(const ByteDistribution::Histogram &counts, std::size_t total, std::uint8_t key) const;
+
+private:
+    /**
+     * negative log probability of each byte value in the reference language, with add-one smoothing
+     */
+    std::array<double, ByteDistribution::BINS> negativeLogProbabilities_{};
+};
+
+/**
+ * @brief Fraction of the deciphered bytes that are not printable ASCII (or tabs and line breaks). Needs no reference
+ * language and is the cheapest of the scorers, but can't tell apart keys that both produce printable text
+ */
+class PrintableScorer
+{
+public:
+    /**
+     * @brief @see XorScorer
+     */
+    double score(const ByteDistribution::Histogram &counts, std::size_t total, std::uint8_t key) const;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "xor_stream.h"
+#include "internal/mapped_file.h"
+#include "internal/stream_buffer.h"
+#include "internal/xor_kernel.h"
+#include "matasano_asserts.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+XorStream::XorStream(ByteView key) : doubledKey_(ByteData(key) + ByteData(key)), keySize_(key.size())
+{
+    THROW_IF(key.empty(), "key is empty", std::invalid_argument);
+}
+
+void XorStream::process(const std::uint8_t *in, std::size_t size, std::uint8_t *out)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    XorKernel::xorRepeating(in, size, doubledKey_.secureData().data() + phase_, keySize_, out);
+    phase_ = (phase_ + size) % keySize_;
+}
+
+std::size_t XorStream::process(std::istream &in, std::ostream &out)
+{
+    // the buffer holds the plain text or the key stream, it is wiped and the mask of out is restored even on failure
+    StreamBuffer buffer(STREAM_BUFFER_SIZE);
+    StreamExceptionsGuard outExceptions(out, std::ios_base::failbit | std::ios_base::badbit);
+    std::size_t total = 0;
+
+    while (in)
+    {
+        in.read(buffer.chars(), static_cast<std::streamsize>(buffer.size()));
+        auto count = static_cast<std::size_t>(in.gcount());
+
+        process(buffer.bytes(), count);
+        out.write(buffer.chars(), static_cast<std::streamsize>(count));
+        total += count;
+    }
+
+    return total;
+}
+
+void XorStream::xorFile(const std::string &inFileName, const std::string &outFileName, ByteView key)
+{
+    // the output is truncated when it is created, which would destroy the input if it is the same file
+    std::error_code error;
+    if (std::filesystem::equivalent(inFileName, outFileName, error))
+    {
+        xorFileInPlace(inFileName, key);
+        return;
+    }
+
+    XorStream stream(key);
+
+    MappedFile in(inFileName);
+    in.adviseSequential();
+    auto out = MappedFile::create(outFileName, in.size());
+
+    for (std::size_t offset = 0; offset < in.size(); offset += CHUNK_SIZE)
+    {
+        stream.process(in.data() + offset, std::min(CHUNK_SIZE, in.size() - offset), out.data() + offset);
+    }
+}
+
+void XorStream::xorFileInPlace(const std::string &fileName, ByteView key)
+{
+    XorStream stream(key);
+
+    MappedFile file(fileName, MappedFile::Mode::readWrite);
+    file.adviseSequential();
+
+    for (std::size_t offset = 0; offset < file.size(); offset += CHUNK_SIZE)
+    {
+        stream.process(file.data() + offset, std::min(CHUNK_SIZE, file.size() - offset));
+    }
+}
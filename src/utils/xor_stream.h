@@ -0,0 +1,115 @@
+#ifndef MATASANO_XOR_STREAM_H
+#define MATASANO_XOR_STREAM_H
+
+#include "byte_data.h"
+#include "byte_view.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Repeating key xor applied to data that comes in chunks of any size. The position in the key carries over from
+ * one chunk to the next, so xoring the chunks one after another gives the same result as xoring all of the data at
+ * once (@see ByteData::operator^). Nothing is allocated per chunk, and whole files are xored through memory mappings,
+ * without reading them into memory
+ */
+class XorStream
+{
+public:
+    /**
+     * @brief Construct a new Xor Stream object
+     *
+     * @param key the key that is applied cyclically, can't be empty
+     * @throw std::invalid_argument if key is empty
+     */
+    explicit XorStream(ByteView key);
+
+    /**
+     * @brief xors the next chunk of the data: out[i] = in[i] ^ key[(phase() + i) % key size]
+     *
+     * @param in the chunk
+     * @param size number of bytes in the chunk
+     * @param out output buffer, should have room for size bytes (may be the same memory as in, but should not
+     * partially overlap with it)
+     */
+    void process(const std::uint8_t *in, std::size_t size, std::uint8_t *out);
+
+    /**
+     * @brief xors the next chunk of the data in place
+     *
+     * @param data the chunk
+     * @param size number of bytes in the chunk
+     */
+    inline void process(std::uint8_t *data, std::size_t size) { process(data, size, data); }
+
+    /**
+     * @brief xors everything that is left in a stream into another stream, through one fixed size buffer. For
+     * streams that can't be mapped, like pipes
+     *
+     * @param in the stream to read
+     * @param out the stream to write
+     * @return number of bytes processed
+     * @throw std::ios_base::failure if writing fails
+     */
+    std::size_t process(std::istream &in, std::ostream &out);
+
+    /**
+     * @brief position in the key the next byte is going to be xored with
+     */
+    inline std::size_t phase() const { return phase_; }
+
+    /**
+     * @brief Xors a file into another file. Both of them are memory mapped, the output is written straight into its
+     * mapping
+     *
+     * @param inFileName the file to xor
+     * @param outFileName the file to write to, overwritten if exists. If it is the same file as inFileName (through any
+     * path or link), the file is xored in place instead (@see xorFileInPlace)
+     * @param key the key that is applied cyclically, can't be empty
+     *
+     * @throw std::ios_base::failure if the files can't be opened, created or mapped
+     * @throw std::invalid_argument if key is empty
+     */
+    static void xorFile(const std::string &inFileName, const std::string &outFileName, ByteView key);
+
+    /**
+     * @brief Xors a file in place, through a shared memory mapping
+     *
+     * @param fileName the file to xor
+     * @param key the key that is applied cyclically, can't be empty
+     *
+     * @throw std::ios_base::failure if the file can't be opened or mapped
+     * @throw std::invalid_argument if key is empty
+     */
+    static void xorFileInPlace(const std::string &fileName, ByteView key);
+
+private:
+    /**
+     * number of bytes xored at a time, so a mapped chunk is written while it is still in the cache
+     */
+    static constexpr std::size_t CHUNK_SIZE = 1024 * 1024;
+
+    /**
+     * size of the buffer the stream version reads into
+     */
+    static constexpr std::size_t STREAM_BUFFER_SIZE = 1024 * 1024;
+
+    /**
+     * the key written twice, so the key starting at any phase is a contiguous range of it
+     */
+    ByteData doubledKey_;
+
+    /**
+     * the size of the key
+     */
+    std::size_t keySize_;
+
+    /**
+     * position in the key the next byte is going to be xored with
+     */
+    std::size_t phase_ = 0;
+};
+
+#endif
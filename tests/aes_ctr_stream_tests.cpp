@@ -0,0 +1,37 @@
+#include "aes.h"
+#include "aes_ctr_stream.h"
+#include "byte_data.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+TEST(AesCtrStreamTest, ChunksAndSeek)
+{
+    Aes aes(TestUtils::KEY, TestUtils::NONCE, Aes::Mode::ctr);
+
+    auto plain = TestUtils::patternData(1000);
+    auto reference = aes.encrypt(plain);
+
+    AesCtrStream stream(aes);
+    ByteData out(0, plain.size());
+    std::size_t done = 0;
+    for (std::size_t chunk : {0, 1, 7, 16, 33, 200, 743})
+    {
+        stream.process(plain.secureData().data() + done, chunk, out.secureData().data() + done);
+        done += chunk;
+        ASSERT_EQ(done, stream.position());
+    }
+    ASSERT_EQ(reference, out);
+
+    // decrypt a range in place after seeking to it
+    auto part = reference.subData(500, 123);
+    stream.seek(500);
+    stream.process(part.secureData().data(), part.size());
+    ASSERT_EQ(plain.subData(500, 123), part);
+    ASSERT_EQ(623u, stream.position());
+}
+
+TEST(AesCtrStreamTest, WrongMode)
+{
+    Aes cbc(TestUtils::KEY, TestUtils::IV, Aes::Mode::cbc);
+    ASSERT_THROW(AesCtrStream{cbc}, std::invalid_argument);
+}
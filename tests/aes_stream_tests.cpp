@@ -0,0 +1,168 @@
+#include "aes.h"
+#include "aes_stream.h"
+#include "byte_data.h"
+#include "crypto_constants.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include <sstream>
+#include <vector>
+
+namespace
+{
+Aes testAes(Aes::Mode mode)
+{
+    return Aes(TestUtils::KEY, mode == Aes::Mode::ctr ? TestUtils::NONCE : TestUtils::IV, mode);
+}
+
+/**
+ * @brief runs all of data through the stream in chunks of chunkSize bytes and finalizes
+ */
+ByteData streamInChunks(AesStream &stream, const ByteData &data, std::size_t chunkSize)
+{
+    std::vector<std::uint8_t> out(data.size() + 2 * CryptoConstants::BLOCK_SIZE_BYTES);
+    std::size_t written = 0;
+    for (std::size_t offset = 0; offset < data.size(); offset += chunkSize)
+    {
+        auto size = std::min(chunkSize, data.size() - offset);
+        written += stream.update(ByteView(data).subView(offset, size), std::span(out).subspan(written));
+    }
+    written += stream.finalize(std::span(out).subspan(written));
+
+    return ByteData(ByteView(out.data(), written));
+}
+} // namespace
+
+TEST(AesStreamTest, ChunksSameAsWhole)
+{
+    for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc, Aes::Mode::ctr})
+    {
+        auto aes = testAes(mode);
+
+        // sizes around whole blocks, chunks smaller and larger than a block and not multiples of it
+        for (std::size_t size : {1, 15, 16, 17, 32, 1000})
+        {
+            auto plain = TestUtils::patternData(size);
+            auto cipher = aes.encrypt(plain);
+
+            for (std::size_t chunkSize : {1, 5, 16, 17, 100, 1000})
+            {
+                AesStream encryptor(aes, AesStream::Direction::encrypt);
+                ASSERT_EQ(cipher, streamInChunks(encryptor, plain, chunkSize)) << size << " " << chunkSize;
+
+                AesStream decryptor(aes, AesStream::Direction::decrypt);
+                ASSERT_EQ(plain, streamInChunks(decryptor, cipher, chunkSize)) << size << " " << chunkSize;
+            }
+        }
+    }
+}
+
+TEST(AesStreamTest, HoldsBackLastBlock)
+{
+    auto aes = testAes(Aes::Mode::cbc);
+    auto cipher = aes.encrypt(TestUtils::patternData(40));
+    ASSERT_EQ(48u, cipher.size());
+
+    std::vector<std::uint8_t> out(64);
+    AesStream decryptor(aes, AesStream::Direction::decrypt);
+    ASSERT_EQ(0u, decryptor.update(ByteView(cipher).subView(0, 16), out));
+    ASSERT_EQ(32u, decryptor.update(ByteView(cipher).subView(16, 32), out));
+    ASSERT_EQ(8u, decryptor.finalize(out));
+}
+
+TEST(AesStreamTest, NoPadding)
+{
+    auto aes = testAes(Aes::Mode::cbc);
+    auto plain = TestUtils::patternData(64);
+    std::vector<std::uint8_t> cipher(64);
+    aes.encrypt(plain, cipher, Aes::Padding::none);
+
+    AesStream encryptor(aes, AesStream::Direction::encrypt, Aes::Padding::none);
+    ASSERT_EQ(ByteData(cipher), streamInChunks(encryptor, plain, 7));
+    AesStream decryptor(aes, AesStream::Direction::decrypt, Aes::Padding::none);
+    ASSERT_EQ(plain, streamInChunks(decryptor, ByteData(cipher), 33));
+
+    std::vector<std::uint8_t> out(32);
+    encryptor.update(ByteView(plain).subView(0, 20), out);
+    ASSERT_THROW(encryptor.finalize(out), std::invalid_argument);
+}
+
+TEST(AesStreamTest, Errors)
+{
+    auto aes = testAes(Aes::Mode::ecb);
+    auto cipher = aes.encrypt(TestUtils::patternData(20));
+    std::vector<std::uint8_t> out(64);
+
+    // empty, not whole blocks, wrong padding
+    AesStream empty(aes, AesStream::Direction::decrypt);
+    ASSERT_THROW(empty.finalize(out), std::invalid_argument);
+
+    AesStream partial(aes, AesStream::Direction::decrypt);
+    partial.update(ByteView(cipher).subView(0, 31), out);
+    ASSERT_THROW(partial.finalize(out), std::invalid_argument);
+
+    cipher.secureData().back() ^= 1;
+    AesStream wrongPadding(aes, AesStream::Direction::decrypt);
+    ASSERT_THROW(streamInChunks(wrongPadding, cipher, 32), std::invalid_argument);
+
+    AesStream encryptor(aes, AesStream::Direction::encrypt);
+    ASSERT_THROW(encryptor.update(ByteView(cipher), std::span(out).first(31)), std::invalid_argument);
+    ASSERT_THROW(encryptor.finalize(std::span(out).first(15)), std::invalid_argument);
+}
+
+TEST(AesStreamTest, StartsOverAfterWrongPadding)
+{
+    auto aes = testAes(Aes::Mode::cbc);
+    auto plain = TestUtils::patternData(40);
+    auto cipher = aes.encrypt(plain);
+    auto wrongCipher = cipher;
+    wrongCipher.secureData().back() ^= 1;
+
+    // the failed data leaves no chaining value or pending block behind
+    AesStream decryptor(aes, AesStream::Direction::decrypt);
+    ASSERT_THROW(streamInChunks(decryptor, wrongCipher, 7), std::invalid_argument);
+    ASSERT_EQ(plain, streamInChunks(decryptor, cipher, 7));
+}
+
+TEST(AesStreamTest, StreamWriteFails)
+{
+    struct FullBuffer : std::streambuf
+    {
+        int_type overflow(int_type) override { return traits_type::eof(); }
+    } full;
+    std::ostream out(&full);
+
+    auto aes = testAes(Aes::Mode::cbc);
+    auto plain = TestUtils::patternData(1000);
+    AesStream encryptor(aes, AesStream::Direction::encrypt);
+    std::istringstream in(plain.str(ByteData::Encoding::plain));
+    ASSERT_THROW(encryptor.process(in, out), std::ios_base::failure);
+    ASSERT_EQ(std::ios_base::goodbit, out.exceptions());
+
+    // and the stream starts over from the iv
+    ASSERT_EQ(aes.encrypt(plain), streamInChunks(encryptor, plain, 100));
+}
+
+TEST(AesStreamTest, Streams)
+{
+    // a few stream buffers and a partial one, with threads
+    auto plain = TestUtils::patternData(3 * 16 * Aes::PARALLEL_CHUNK + 21);
+
+    for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc, Aes::Mode::ctr})
+    {
+        auto aes = testAes(mode);
+        auto cipher = aes.encrypt(plain);
+
+        std::istringstream plainIn(plain.str(ByteData::Encoding::plain));
+        std::ostringstream cipherOut;
+        ASSERT_EQ(cipher.size(), AesStream(aes, AesStream::Direction::encrypt, Aes::Padding::pkcs7, 0)
+                                     .process(plainIn, cipherOut));
+        ASSERT_EQ(cipher.str(ByteData::Encoding::plain), cipherOut.str());
+
+        std::istringstream cipherIn(cipherOut.str());
+        std::ostringstream plainOut;
+        ASSERT_EQ(plain.size(), AesStream(aes, AesStream::Direction::decrypt, Aes::Padding::pkcs7, 3)
+                                    .process(cipherIn, plainOut));
+        ASSERT_EQ(plain.str(ByteData::Encoding::plain), plainOut.str());
+    }
+}
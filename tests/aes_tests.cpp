@@ -1,13 +1,16 @@
 #include "aes.h"
 #include "gtest/gtest.h"
+#include "test_utils.h"
+#include <array>
+#include <span>
+#include <vector>
 
 TEST(AesTest, EncryptDecryptEcb)
 {
     ByteData b1("This is a test data to encrypt", ByteData::Encoding::plain);
     ByteData b2("0123456789abcdef0123456789abcdef", ByteData::Encoding::plain);
-    ByteData key("0123456789abcdef", ByteData::Encoding::plain);
 
-    Aes aes(key, ByteData(), Aes::Mode::ecb);
+    Aes aes(TestUtils::KEY, ByteData(), Aes::Mode::ecb);
 
     auto encrypted = aes.encrypt(b1);
     auto decrypted = aes.decrypt(encrypted);
@@ -24,19 +27,16 @@ TEST(AesTest, EncryptDecryptCbcWrongIv)
 {
     ByteData b1("This is a test data to encrypt", ByteData::Encoding::plain);
 
-    ByteData key("0123456789abcdef", ByteData::Encoding::plain);
 
-    ASSERT_THROW(Aes(key, ByteData(), Aes::Mode::cbc), std::invalid_argument);
+    ASSERT_THROW(Aes(TestUtils::KEY, ByteData(), Aes::Mode::cbc), std::invalid_argument);
 }
 
 TEST(AesTest, EncryptDecryptCbc)
 {
     ByteData b1("This is a test data to encrypt", ByteData::Encoding::plain);
     ByteData b2("0123456789abcdef0123456789abcdef", ByteData::Encoding::plain);
-    ByteData key("0123456789abcdef", ByteData::Encoding::plain);
-    ByteData iv("fedcba9876543210", ByteData::Encoding::plain);
 
-    Aes aes(key, iv, Aes::Mode::cbc);
+    Aes aes(TestUtils::KEY, TestUtils::IV, Aes::Mode::cbc);
 
     auto encrypted = aes.encrypt(b1);
     auto decrypted = aes.decrypt(encrypted);
@@ -48,3 +48,393 @@ TEST(AesTest, EncryptDecryptCbc)
 
     ASSERT_EQ(b2, decrypted);
 }
+
+namespace
+{
+// NIST SP 800-38A, F.1.1 ECB-AES128 and F.2.1 CBC-AES128
+const ByteData VECTOR_KEY("2b7e151628aed2a6abf7158809cf4f3c");
+const ByteData VECTOR_IV("000102030405060708090a0b0c0d0e0f");
+const ByteData VECTOR_PLAIN("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                            "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+const ByteData VECTOR_ECB("3ad77bb40d7a3660a89ecaf32466ef97f5d3d58503b9699de785895a96fdbaaf"
+                          "43b1cd7f598ece23881b00e3ed0306887b0c785e27e8ad3f8223207104725dd4");
+const ByteData VECTOR_CBC("7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+                          "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+
+/**
+ * @brief the backends this CPU can run
+ */
+std::vector<Aes::Backend> availableBackends()
+{
+    std::vector<Aes::Backend> backends{Aes::Backend::cryptoPp};
+    if (Aes(VECTOR_KEY, ByteData(), Aes::Mode::ecb).backend() == Aes::Backend::aesNi)
+    {
+        backends.push_back(Aes::Backend::aesNi);
+    }
+    return backends;
+}
+} // namespace
+
+TEST(AesTest, KnownAnswerEcb)
+{
+    for (auto backend : availableBackends())
+    {
+        Aes aes(VECTOR_KEY, ByteData(), Aes::Mode::ecb, Aes::KeySize::bit128, backend);
+        ASSERT_EQ(backend, aes.backend());
+
+        // the vector is whole blocks, so a whole block of padding is added after it
+        auto encrypted = aes.encrypt(VECTOR_PLAIN);
+        ASSERT_EQ(VECTOR_PLAIN.size() + 16, encrypted.size());
+        ASSERT_EQ(VECTOR_ECB, encrypted.subData(0, VECTOR_PLAIN.size()));
+        ASSERT_EQ(VECTOR_PLAIN, aes.decrypt(encrypted));
+    }
+}
+
+TEST(AesTest, KnownAnswerCbc)
+{
+    for (auto backend : availableBackends())
+    {
+        Aes aes(VECTOR_KEY, VECTOR_IV, Aes::Mode::cbc, Aes::KeySize::bit128, backend);
+
+        auto encrypted = aes.encrypt(VECTOR_PLAIN);
+        ASSERT_EQ(VECTOR_PLAIN.size() + 16, encrypted.size());
+        ASSERT_EQ(VECTOR_CBC, encrypted.subData(0, VECTOR_PLAIN.size()));
+        ASSERT_EQ(VECTOR_PLAIN, aes.decrypt(encrypted));
+    }
+}
+
+TEST(AesTest, BackendsSameOutput)
+{
+    // sizes around the number of blocks the native kernel interleaves
+    for (std::size_t size : {1, 15, 16, 17, 127, 128, 129, 255, 1000, 4096})
+    {
+        auto plain = TestUtils::patternData(size);
+
+        for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc})
+        {
+            Aes reference(TestUtils::KEY, TestUtils::IV, mode, Aes::KeySize::bit128, Aes::Backend::cryptoPp);
+            auto encrypted = reference.encrypt(plain);
+            ASSERT_EQ(plain, reference.decrypt(encrypted));
+
+            for (auto backend : availableBackends())
+            {
+                Aes aes(TestUtils::KEY, TestUtils::IV, mode, Aes::KeySize::bit128, backend);
+                ASSERT_EQ(encrypted, aes.encrypt(plain));
+                ASSERT_EQ(plain, aes.decrypt(encrypted));
+            }
+        }
+    }
+}
+
+TEST(AesTest, DecryptWrongSize)
+{
+    for (auto backend : availableBackends())
+    {
+        for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc})
+        {
+            Aes aes(TestUtils::KEY, TestUtils::IV, mode, Aes::KeySize::bit128, backend);
+            auto encrypted = aes.encrypt(ByteData("some data", ByteData::Encoding::plain));
+            encrypted.secureData().pop_back();
+            ASSERT_THROW(aes.decrypt(encrypted), std::invalid_argument);
+        }
+    }
+}
+
+TEST(AesTest, ParallelSameAsSerial)
+{
+    // a few chunks and a partial one, so the ivs of the cbc chunks and the padding of the last one are exercised
+    for (auto size : {Aes::PARALLEL_CHUNK - 1, 4 * Aes::PARALLEL_CHUNK, 3 * Aes::PARALLEL_CHUNK + 5})
+    {
+        auto plain = TestUtils::patternData(size);
+
+        for (auto backend : availableBackends())
+        {
+            for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc})
+            {
+                Aes aes(TestUtils::KEY, TestUtils::IV, mode, Aes::KeySize::bit128, backend);
+                auto encrypted = aes.encrypt(plain);
+
+                for (std::size_t numThreads : {2, 4, 0})
+                {
+                    ASSERT_EQ(encrypted, aes.encrypt(plain, numThreads));
+                    ASSERT_EQ(plain, aes.decrypt(encrypted, numThreads));
+                }
+            }
+        }
+    }
+}
+
+TEST(AesTest, CryptoPpParallel)
+{
+    // the CryptoPP backend on many threads, each thread has to work on its own copy of the cipher
+    auto size = 8 * Aes::PARALLEL_CHUNK + 3;
+    auto plain = TestUtils::patternData(size);
+
+    for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc})
+    {
+        Aes aes(TestUtils::KEY, TestUtils::IV, mode, Aes::KeySize::bit128, Aes::Backend::cryptoPp);
+        auto encrypted = aes.encrypt(plain);
+        ASSERT_EQ(plain, aes.decrypt(encrypted));
+
+        for (std::size_t numThreads : {4, 8, 0})
+        {
+            ASSERT_EQ(encrypted, aes.encrypt(plain, numThreads));
+            ASSERT_EQ(plain, aes.decrypt(encrypted, numThreads));
+        }
+    }
+
+    Aes ctr(TestUtils::KEY, TestUtils::NONCE, Aes::Mode::ctr, Aes::KeySize::bit128, Aes::Backend::cryptoPp);
+    auto encrypted = ctr.encrypt(plain);
+    for (std::size_t numThreads : {4, 8, 0})
+    {
+        ASSERT_EQ(encrypted, ctr.encrypt(plain, numThreads));
+
+        // a range that starts inside a block, so every chunk has a partial head block
+        std::vector<std::uint8_t> range(size - 7);
+        ctr.transformAt(7, ByteView(encrypted).subView(7, range.size()), range, numThreads);
+        ASSERT_EQ(plain.subData(7, range.size()), ByteData(range));
+    }
+}
+
+TEST(AesTest, CryptoPpSwitchingKeys)
+{
+    // the thread keeps a copy of the last cipher it used, it should not be used for another object
+    Aes vector(VECTOR_KEY, ByteData(), Aes::Mode::ecb, Aes::KeySize::bit128, Aes::Backend::cryptoPp);
+    Aes other(TestUtils::KEY, ByteData(), Aes::Mode::ecb, Aes::KeySize::bit128, Aes::Backend::cryptoPp);
+    auto otherEncrypted = other.encrypt(VECTOR_PLAIN);
+
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_EQ(VECTOR_ECB, vector.encrypt(VECTOR_PLAIN).subData(0, VECTOR_PLAIN.size()));
+        ASSERT_EQ(otherEncrypted, other.encrypt(VECTOR_PLAIN));
+    }
+
+    // objects created one after another, each may get the memory of the one destroyed before it
+    for (auto const *key : {&TestUtils::KEY, &VECTOR_KEY, &TestUtils::KEY})
+    {
+        Aes aes(*key, ByteData(), Aes::Mode::ecb, Aes::KeySize::bit128, Aes::Backend::cryptoPp);
+        ASSERT_EQ(key == &VECTOR_KEY ? VECTOR_ECB : otherEncrypted.subData(0, VECTOR_PLAIN.size()),
+                  aes.encrypt(VECTOR_PLAIN).subData(0, VECTOR_PLAIN.size()));
+    }
+}
+
+TEST(AesTest, KnownAnswerCtr)
+{
+    // cryptopals challenge 18: 8 byte nonce followed by a 64 bit little endian block counter
+    ByteData cipher("L77na/nrFsKvynd6HzOoG7GHTLXsTVu9qvY/2syLXzhPweyyMTJULu/6/kXX0KSvoOLSFQ==",
+                    ByteData::Encoding::base64);
+    ByteData key("YELLOW SUBMARINE", ByteData::Encoding::plain);
+
+    for (auto backend : availableBackends())
+    {
+        Aes aes(key, ByteData(0, 8), Aes::Mode::ctr, Aes::KeySize::bit128, backend);
+
+        auto plain = aes.decrypt(cipher);
+        ASSERT_EQ(cipher.size(), plain.size());
+        ASSERT_EQ("Yo, VIP Let's kick it Ice, Ice, baby Ice, Ice, baby ", plain.str(ByteData::Encoding::plain));
+        ASSERT_EQ(cipher, aes.encrypt(plain));
+    }
+}
+
+TEST(AesTest, CtrWrongNonceOrMode)
+{
+    ASSERT_THROW(Aes(TestUtils::KEY, TestUtils::IV, Aes::Mode::ctr), std::invalid_argument);
+    ASSERT_THROW(Aes(TestUtils::KEY, ByteData(), Aes::Mode::ctr), std::invalid_argument);
+
+    Aes cbc(TestUtils::KEY, TestUtils::IV, Aes::Mode::cbc);
+    std::vector<std::uint8_t> data(16);
+    ASSERT_THROW(cbc.transformAt(0, data), std::logic_error);
+
+    Aes ctr(TestUtils::KEY, ByteData(0, 8), Aes::Mode::ctr);
+    ASSERT_THROW(ctr.transformAt(0, ByteView(data.data(), 16), std::span<std::uint8_t>(data.data(), 15)),
+                 std::invalid_argument);
+}
+
+TEST(AesTest, CtrTransformAt)
+{
+    auto size = 2 * Aes::PARALLEL_CHUNK + 1000;
+    auto plain = TestUtils::patternData(size);
+
+    Aes cryptoPp(TestUtils::KEY, TestUtils::NONCE, Aes::Mode::ctr, Aes::KeySize::bit128, Aes::Backend::cryptoPp);
+    auto reference = cryptoPp.encrypt(plain);
+    ASSERT_EQ(size, reference.size());
+
+    for (auto backend : availableBackends())
+    {
+        Aes aes(TestUtils::KEY, TestUtils::NONCE, Aes::Mode::ctr, Aes::KeySize::bit128, backend);
+        ASSERT_EQ(reference, aes.encrypt(plain, 0));
+
+        // ranges that start and end inside blocks and span chunks
+        for (std::size_t begin : {std::size_t{0}, std::size_t{5}, std::size_t{16}, std::size_t{1000},
+                                  Aes::PARALLEL_CHUNK - 3, Aes::PARALLEL_CHUNK + 8})
+        {
+            for (std::size_t length : {std::size_t{1}, std::size_t{11}, std::size_t{300}, Aes::PARALLEL_CHUNK + 17})
+            {
+                for (std::size_t numThreads : {1, 3})
+                {
+                    std::vector<std::uint8_t> out(length);
+                    aes.transformAt(begin, ByteView(plain).subView(begin, length), out, numThreads);
+                    ASSERT_EQ(reference.subData(begin, length), ByteData(out));
+                }
+            }
+        }
+    }
+}
+
+TEST(AesTest, CtrLargeOffset)
+{
+    // the counter crosses the boundary of its lower 32 bits and wraps around at the end of the 64 bit space
+    for (std::uint64_t offset : {(std::uint64_t{1} << 36) - 40, ~std::uint64_t{0} - 20})
+    {
+        std::vector<std::uint8_t> reference(100, 0xaa);
+        Aes(TestUtils::KEY, TestUtils::NONCE, Aes::Mode::ctr, Aes::KeySize::bit128, Aes::Backend::cryptoPp)
+            .transformAt(offset, reference);
+
+        for (auto backend : availableBackends())
+        {
+            std::vector<std::uint8_t> data(100, 0xaa);
+            Aes(TestUtils::KEY, TestUtils::NONCE, Aes::Mode::ctr, Aes::KeySize::bit128, backend)
+                .transformAt(offset, data);
+            ASSERT_EQ(reference, data);
+        }
+    }
+}
+
+TEST(AesTest, SpanSameAsByteData)
+{
+    for (std::size_t size : {1, 15, 16, 17, 100})
+    {
+        auto plain = TestUtils::patternData(size);
+
+        for (auto backend : availableBackends())
+        {
+            for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc, Aes::Mode::ctr})
+            {
+                Aes aes(TestUtils::KEY, mode == Aes::Mode::ctr ? TestUtils::NONCE : TestUtils::IV, mode,
+                        Aes::KeySize::bit128, backend);
+                auto expected = aes.encrypt(plain);
+
+                // the buffers are one byte longer than needed, that byte should not be touched
+                std::vector<std::uint8_t> cipher(aes.cipherSize(size) + 1, 0xee);
+                ASSERT_EQ(expected.size(), aes.encrypt(plain, cipher));
+                ASSERT_EQ(expected, ByteData(ByteView(cipher.data(), expected.size())));
+                ASSERT_EQ(0xee, cipher.back());
+
+                std::vector<std::uint8_t> decrypted(size + 1, 0xee);
+                ASSERT_EQ(size, aes.decrypt(ByteView(cipher.data(), expected.size()), decrypted));
+                ASSERT_EQ(plain, ByteData(ByteView(decrypted.data(), size)));
+                ASSERT_EQ(0xee, decrypted.back());
+            }
+        }
+    }
+}
+
+TEST(AesTest, SpanEmptyAndNoPadding)
+{
+    for (auto backend : availableBackends())
+    {
+        // with no padding the NIST vectors come out exactly
+        Aes ecb(VECTOR_KEY, ByteData(), Aes::Mode::ecb, Aes::KeySize::bit128, backend);
+        Aes cbc(VECTOR_KEY, VECTOR_IV, Aes::Mode::cbc, Aes::KeySize::bit128, backend);
+        for (auto [aes, vector] : {std::pair{&ecb, &VECTOR_ECB}, std::pair{&cbc, &VECTOR_CBC}})
+        {
+            std::vector<std::uint8_t> out(VECTOR_PLAIN.size());
+            ASSERT_EQ(out.size(), aes->encrypt(VECTOR_PLAIN, out, Aes::Padding::none));
+            ASSERT_EQ(*vector, ByteData(out));
+            ASSERT_EQ(out.size(), aes->decryptInPlace(out, Aes::Padding::none));
+            ASSERT_EQ(VECTOR_PLAIN, ByteData(out));
+
+            ASSERT_THROW(aes->cipherSize(17, Aes::Padding::none), std::invalid_argument);
+            ASSERT_THROW(aes->encrypt(ByteView(out.data(), 17), out, Aes::Padding::none), std::invalid_argument);
+
+            // empty plain data is a whole block of padding
+            std::array<std::uint8_t, 16> block{};
+            ASSERT_EQ(16u, aes->encrypt(ByteView(), block));
+            ASSERT_EQ(0u, aes->decrypt(ByteView(block), std::span<std::uint8_t>()));
+            ASSERT_THROW(aes->decrypt(ByteView(), block), std::invalid_argument);
+        }
+    }
+}
+
+TEST(AesTest, SpanErrors)
+{
+    Aes aes(TestUtils::KEY, TestUtils::IV, Aes::Mode::cbc);
+    ByteData plain("some data to encrypt", ByteData::Encoding::plain);
+
+    std::vector<std::uint8_t> cipher(aes.cipherSize(plain.size()));
+    ASSERT_THROW(aes.encrypt(plain, std::span(cipher).first(cipher.size() - 1)), std::invalid_argument);
+    aes.encrypt(plain, cipher);
+
+    std::vector<std::uint8_t> out(plain.size() - 1);
+    ASSERT_THROW(aes.decrypt(ByteView(cipher), out), std::invalid_argument);
+    ASSERT_THROW(aes.decrypt(ByteView(cipher.data(), cipher.size() - 1), cipher), std::invalid_argument);
+
+    // a wrong padding is found before anything is written
+    cipher[cipher.size() - 17] ^= 1;
+    out.assign(cipher.size(), 0xee);
+    ASSERT_THROW(aes.decrypt(ByteView(cipher), out), std::invalid_argument);
+    ASSERT_EQ(std::vector<std::uint8_t>(cipher.size(), 0xee), out);
+
+    std::vector<std::uint8_t> buffer(20);
+    ASSERT_THROW(aes.encryptInPlace(buffer, 21), std::invalid_argument);
+    ASSERT_THROW(aes.encryptInPlace(buffer, 16), std::invalid_argument);
+}
+
+TEST(AesTest, InPlace)
+{
+    // more than a chunk, so the chunk ivs of in place cbc decryption are exercised
+    for (auto size : {std::size_t{33}, 2 * Aes::PARALLEL_CHUNK + 40})
+    {
+        auto plain = TestUtils::patternData(size);
+
+        for (auto backend : availableBackends())
+        {
+            for (auto mode : {Aes::Mode::ecb, Aes::Mode::cbc, Aes::Mode::ctr})
+            {
+                Aes aes(TestUtils::KEY, mode == Aes::Mode::ctr ? TestUtils::NONCE : TestUtils::IV, mode,
+                        Aes::KeySize::bit128, backend);
+                auto expected = aes.encrypt(plain);
+
+                for (std::size_t numThreads : {1, 3})
+                {
+                    std::vector<std::uint8_t> buffer(aes.cipherSize(size));
+                    std::copy(plain.secureData().begin(), plain.secureData().end(), buffer.begin());
+
+                    ASSERT_EQ(expected.size(), aes.encryptInPlace(buffer, size, Aes::Padding::pkcs7, numThreads));
+                    ASSERT_EQ(expected, ByteData(buffer));
+                    ASSERT_EQ(size, aes.decryptInPlace(buffer, Aes::Padding::pkcs7, numThreads));
+                    ASSERT_EQ(plain, ByteData(ByteView(buffer.data(), size)));
+                }
+            }
+        }
+    }
+}
+
+TEST(AesTest, EncryptDecryptBlocksChained)
+{
+    for (auto backend : availableBackends())
+    {
+        Aes aes(VECTOR_KEY, VECTOR_IV, Aes::Mode::cbc, Aes::KeySize::bit128, backend);
+        ASSERT_EQ(VECTOR_IV, aes.iv());
+
+        // the second block chains from the last cipher block of the first, as if it was one call
+        std::vector<std::uint8_t> cipher(VECTOR_PLAIN.size());
+        aes.encryptDecryptBlocks(aes.iv(), VECTOR_PLAIN.subData(0, 16), std::span(cipher).first(16), true);
+        aes.encryptDecryptBlocks(ByteView(cipher.data(), 16), VECTOR_PLAIN.subData(16, VECTOR_PLAIN.size() - 16),
+                                 std::span(cipher).subspan(16), true);
+        ASSERT_EQ(VECTOR_CBC, ByteData(cipher));
+
+        aes.encryptDecryptBlocks(aes.iv(), ByteView(cipher), cipher, false, 0);
+        ASSERT_EQ(VECTOR_PLAIN, ByteData(cipher));
+    }
+
+    Aes aes(VECTOR_KEY, VECTOR_IV, Aes::Mode::cbc);
+    std::vector<std::uint8_t> out(32);
+    ASSERT_THROW(aes.encryptDecryptBlocks(aes.iv(), VECTOR_PLAIN.subData(0, 17), out, true), std::invalid_argument);
+    ASSERT_THROW(aes.encryptDecryptBlocks(aes.iv(), VECTOR_PLAIN.subData(0, 32), std::span(out).first(16), true),
+                 std::invalid_argument);
+    ASSERT_THROW(aes.encryptDecryptBlocks(ByteView(), VECTOR_PLAIN.subData(0, 16), out, true), std::invalid_argument);
+
+    Aes ctr(VECTOR_KEY, VECTOR_IV.subData(0, 8), Aes::Mode::ctr);
+    ASSERT_THROW(ctr.encryptDecryptBlocks(ctr.iv(), VECTOR_PLAIN.subData(0, 16), out, true), std::logic_error);
+}
@@ -0,0 +1,74 @@
+#include "byte_data.h"
+#include "byte_view.h"
+#include "gtest/gtest.h"
+
+#include <unordered_set>
+
+TEST(ByteViewTest, EmptyView)
+{
+    ByteView view;
+    ASSERT_TRUE(view.empty());
+    ASSERT_EQ(0, view.size());
+    ASSERT_EQ(ByteView(), ByteData());
+}
+
+TEST(ByteViewTest, ViewsByteData)
+{
+    ByteData bd("1234", ByteData::Encoding::plain);
+    ByteView view = bd;
+
+    ASSERT_EQ(bd.size(), view.size());
+    ASSERT_EQ(bd.secureData().data(), view.data());
+    ASSERT_EQ(bd, ByteData(view));
+}
+
+TEST(ByteViewTest, SubView)
+{
+    ByteData bd("1234", ByteData::Encoding::plain);
+    ByteView view = bd;
+
+    ASSERT_EQ(ByteData("23", ByteData::Encoding::plain), ByteData(view.subView(1, 2)));
+    ASSERT_EQ(view.data() + 1, view.subView(1, 2).data());
+    ASSERT_TRUE(view.subView(4, 0).empty());
+    ASSERT_THROW(view.subView(5, 0), std::invalid_argument);
+    ASSERT_THROW(view.subView(3, 2), std::invalid_argument);
+}
+
+TEST(ByteViewTest, CompareBytesNotPointers)
+{
+    ByteData b1("abcabd", ByteData::Encoding::plain);
+    ByteView view = b1;
+
+    ASSERT_EQ(view.subView(0, 2), view.subView(3, 2));
+    ASSERT_NE(view.subView(0, 3), view.subView(3, 3));
+    ASSERT_LT(view.subView(0, 3), view.subView(3, 3));
+    ASSERT_LT(view.subView(0, 2), view.subView(3, 3));
+}
+
+TEST(ByteViewTest, Hash)
+{
+    ByteData bd("0123456789abcdef0123456789abcdefXYZ", ByteData::Encoding::plain);
+    auto rows = bd.extractRowViews(16);
+    ASSERT_EQ(3, rows.size());
+
+    std::hash<ByteView> hasher;
+    ASSERT_EQ(hasher(rows.at(0)), hasher(rows.at(1)));
+    ASSERT_NE(hasher(rows.at(0)), hasher(rows.at(2)));
+    ASSERT_EQ(std::hash<ByteData>()(bd), hasher(bd));
+
+    std::unordered_set<ByteView> unique(rows.begin(), rows.end());
+    ASSERT_EQ(2, unique.size());
+}
+
+TEST(ByteViewTest, Hamming)
+{
+    ByteData b1("this is a test", ByteData::Encoding::plain);
+    ByteData b2("wokka wokka!!!", ByteData::Encoding::plain);
+
+    ASSERT_DOUBLE_EQ(37.0 / 14.0, ByteView(b1).hamming(b2));
+    ASSERT_EQ(37, ByteView(b1).hammingBits(b2));
+    ASSERT_EQ(37, b1.hammingBits(b2));
+    ASSERT_EQ(0, ByteView().hammingBits(ByteView()));
+    ASSERT_THROW(ByteView(b1).hamming(ByteView(b2).subView(0, 2)), std::invalid_argument);
+    ASSERT_THROW(ByteView(b1).hammingBits(ByteView(b2).subView(0, 2)), std::invalid_argument);
+}
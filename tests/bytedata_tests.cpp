@@ -486,3 +486,94 @@ TEST(ByteDataTest, SizeConstructor)
     ASSERT_EQ(b.size(), vec.size());
     ASSERT_EQ(0, memcmp(b.secureData().data(), vec.data(), b.size()));
 }
+
+TEST(ByteDataTest, HexRoundTripLengths)
+{
+    for (std::size_t length = 0; length < 150; length++)
+    {
+        ByteData bd(0, length);
+        for (std::size_t i = 0; i < length; i++)
+        {
+            bd.secureData()[i] = static_cast<std::uint8_t>(i * 37 + length);
+        }
+
+        auto hex = bd.str();
+        ASSERT_EQ(2 * length, hex.size());
+        ASSERT_EQ(bd, ByteData(hex));
+    }
+}
+
+TEST(ByteDataTest, ConstructorWrongHexLong)
+{
+    std::string hex(128, '0');
+    hex[77] = 'x';
+    ASSERT_THROW(ByteData{hex}, std::invalid_argument);
+}
+
+TEST(ByteDataTest, ConstructBase64IgnoreWhitespace)
+{
+    ByteData bd("EjRW\r\neJA=\n", ByteData::Encoding::base64IgnoreWhitespace);
+    ASSERT_EQ("1234567890", bd.str());
+    ASSERT_EQ("EjRWeJA=", bd.str(ByteData::Encoding::base64IgnoreWhitespace));
+
+    ASSERT_THROW(ByteData("EjRW\r\neJA=\n", ByteData::Encoding::base64), std::invalid_argument);
+    ASSERT_THROW(ByteData("EjRW\r\neJA\n", ByteData::Encoding::base64IgnoreWhitespace), std::invalid_argument);
+}
+
+TEST(ByteDataTest, ExtractRowViewsSameAsRows)
+{
+    ByteData bd("1234567890", ByteData::Encoding::plain);
+
+    for (size_t elmsInRow = 1; elmsInRow < 12; ++elmsInRow)
+    {
+        for (size_t maxRows = 0; maxRows < 4; ++maxRows)
+        {
+            auto rows = bd.extractRows(elmsInRow, maxRows);
+            auto views = bd.extractRowViews(elmsInRow, maxRows);
+            ASSERT_EQ(rows.size(), views.size());
+
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                ASSERT_EQ(rows.at(i), ByteData(views.at(i)));
+                ASSERT_EQ(rows.at(i), ByteData(bd.extractRowView(elmsInRow, i)));
+            }
+        }
+    }
+}
+
+TEST(ByteDataTest, ExtractRowViewPointsToData)
+{
+    ByteData bd("1234567890", ByteData::Encoding::plain);
+    ASSERT_EQ(ByteView(bd).data() + 4, bd.extractRowView(4, 1).data());
+    ASSERT_TRUE(bd.extractRowView(3, 10).empty());
+    ASSERT_THROW(ByteData().extractRowView(2, 0), std::invalid_argument);
+}
+
+TEST(ByteDataTest, XorWithView)
+{
+    ByteData b1("1234", ByteData::Encoding::plain);
+    ByteData b2("abcdef", ByteData::Encoding::plain);
+    ByteView view = ByteView(b2).subView(1, 4);
+
+    ByteData expected = b1 ^ ByteData("bcde", ByteData::Encoding::plain);
+    ASSERT_EQ(expected, b1 ^ view);
+
+    b1 ^= view;
+    ASSERT_EQ(expected, b1);
+}
+
+TEST(ByteDataTest, XorToReusesResult)
+{
+    ByteData b1("1234567890", ByteData::Encoding::plain);
+    ByteData key("abc", ByteData::Encoding::plain);
+
+    ByteData result("some previous content that is longer", ByteData::Encoding::plain);
+    ByteData::xorTo(b1, key, result);
+    ASSERT_EQ(b1 ^ key, result);
+
+    ByteData::xorTo(b1, key, b1);
+    ASSERT_EQ(result, b1);
+
+    ASSERT_THROW(ByteData::xorTo(ByteData(), key, result), std::invalid_argument);
+    ASSERT_THROW(ByteData::xorTo(b1, ByteView(), result), std::invalid_argument);
+}
@@ -0,0 +1,109 @@
+#include "byte_data.h"
+#include "crib_dragger.h"
+#include "file_utils.h"
+#include "ngram_model.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class CribDraggerTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        text = FileUtils::read("assets/mobydick.txt");
+        model = std::make_shared<NGramModel>(ByteData(text, ByteData::Encoding::plain));
+    }
+
+    static std::string text;
+    static std::shared_ptr<NGramModel> model;
+};
+
+std::string CribDraggerTest::text;
+std::shared_ptr<NGramModel> CribDraggerTest::model = nullptr;
+
+TEST_F(CribDraggerTest, ScoreWindowsSameAsScore)
+{
+    ByteData data(text.substr(1000, 3000), ByteData::Encoding::plain);
+    // the windows are xored with the crib, the score should be the same as for the same window xored one by one
+    for (const auto &crib : {std::string("a"), std::string("an"), std::string(" the whale"),
+                             std::string(200, 'e') + "Call me Ishmael"})
+    {
+        ByteData cribData(crib, ByteData::Encoding::plain);
+        auto numWindows = data.size() - crib.size() + 1;
+        std::vector<double> scores(numWindows);
+        model->scoreWindows(ByteView(data).data(), numWindows, cribData, scores.data());
+
+        for (std::size_t o = 0; o < numWindows; o++)
+        {
+            ASSERT_NEAR(scores[o], model->score(ByteView(data).subView(o, crib.size()), cribData), 1e-4);
+        }
+    }
+}
+
+TEST_F(CribDraggerTest, ScoreWindowsThrows)
+{
+    ByteData data(text.substr(0, NGramModel::MAX_WINDOWS + 10), ByteData::Encoding::plain);
+    std::vector<double> scores(NGramModel::MAX_WINDOWS + 1);
+    ASSERT_THROW(model->scoreWindows(ByteView(data).data(), 1, ByteView(), scores.data()), std::invalid_argument);
+    ByteData crib("a", ByteData::Encoding::plain);
+    ASSERT_THROW(model->scoreWindows(ByteView(data).data(), NGramModel::MAX_WINDOWS + 1, crib, scores.data()),
+                 std::invalid_argument);
+}
+
+TEST_F(CribDraggerTest, DragFindsKeystream)
+{
+    // data ciphered with a keystream of english text: the crib at the right offset gives the keystream back
+    auto plain = ByteData(text.substr(200000, 100000), ByteData::Encoding::plain);
+    auto keystream = ByteData(text.substr(500000, 100000), ByteData::Encoding::plain);
+    auto ciphered = plain ^ keystream;
+
+    std::size_t offset = 77777;
+    auto crib = plain.subView(offset, 40);
+    CribDragger dragger(model);
+    for (std::size_t numThreads : {1, 4})
+    {
+        auto matches = dragger.drag(ciphered, crib, 5, numThreads);
+        ASSERT_EQ(matches.size(), 5);
+        ASSERT_EQ(matches[0].first, offset);
+        ASSERT_NEAR(matches[0].second, model->score(keystream.subView(offset, 40)), 1e-4);
+        for (std::size_t i = 1; i < matches.size(); i++)
+        {
+            ASSERT_LE(matches[i - 1].second, matches[i].second);
+        }
+    }
+}
+
+TEST_F(CribDraggerTest, DragPairFindsOtherPlaintext)
+{
+    auto key = ByteData("some long keystream that is reused", ByteData::Encoding::plain);
+    auto firstPlain = ByteData(text.substr(100000, 150000), ByteData::Encoding::plain);
+    auto secondPlain = ByteData(text.substr(400000, 120000), ByteData::Encoding::plain);
+    auto first = firstPlain ^ key;
+    auto second = secondPlain ^ key;
+
+    std::size_t offset = 100003;
+    auto crib = firstPlain.subView(offset, 30);
+    CribDragger dragger(model);
+    auto matches = dragger.dragPair(first, second, crib, 3, 3);
+    ASSERT_EQ(matches.size(), 3);
+    ASSERT_EQ(matches[0].first, offset);
+
+    // same as dragging over the whole xor
+    auto whole = ByteData(text.substr(100000, 120000), ByteData::Encoding::plain) ^ secondPlain;
+    ASSERT_EQ(matches, dragger.drag(whole, crib, 3));
+}
+
+TEST_F(CribDraggerTest, DragEdgeCases)
+{
+    CribDragger dragger(model);
+    ByteData data("short", ByteData::Encoding::plain);
+    ASSERT_THROW(dragger.drag(data, ByteView(), 1), std::invalid_argument);
+    ASSERT_THROW(CribDragger(nullptr), std::invalid_argument);
+    ASSERT_TRUE(dragger.drag(data, ByteData("longer crib", ByteData::Encoding::plain), 1).empty());
+    ASSERT_TRUE(dragger.drag(data, ByteData("s", ByteData::Encoding::plain), 0).empty());
+    ASSERT_EQ(dragger.drag(data, data, 10).size(), 1);
+    ASSERT_EQ(dragger.drag(data, ByteData("s", ByteData::Encoding::plain), 10).size(), data.size());
+}
@@ -1,7 +1,13 @@
 #include "byte_data.h"
+#include "byte_distribution.h"
 #include "decryptor_xor.h"
 #include "file_utils.h"
+#include "general_utils.h"
 #include "gtest/gtest.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -12,12 +18,22 @@ protected:
     {
         auto str = FileUtils::read("assets/mobydick.txt");
         decryptor = std::make_shared<DecryptorXor>(str);
+
+        ByteData reference(str, ByteData::Encoding::plain);
+        ngramDecryptor =
+            std::make_shared<DecryptorXor>(LanguageModel(reference), std::make_shared<NGramModel>(reference));
     }
 
     static std::shared_ptr<DecryptorXor> decryptor;
+
+    /**
+     * scores with the trigram model of the same text as decryptor
+     */
+    static std::shared_ptr<DecryptorXor> ngramDecryptor;
 };
 
 std::shared_ptr<DecryptorXor> DecryptorXorTest::decryptor = nullptr;
+std::shared_ptr<DecryptorXor> DecryptorXorTest::ngramDecryptor = nullptr;
 
 TEST_F(DecryptorXorTest, TrivialCaseSingleXor)
 {
@@ -57,6 +73,21 @@ TEST_F(DecryptorXorTest, DecryptEnglishTextSingleXor)
     ASSERT_EQ(cipher, resultCipher);
 }
 
+TEST_F(DecryptorXorTest, ScoreSingleByteKeysSameAsXoring)
+{
+    ByteData cipherText = ByteData("Call me Ishmael. Some years ago", ByteData::Encoding::plain) ^ std::uint8_t{0x5a};
+    ByteDistribution reference(ByteData(FileUtils::read("assets/mobydick.txt"), ByteData::Encoding::plain));
+
+    auto scores = decryptor->scoreSingleByteKeys(cipherText);
+    for (std::size_t key = 0; key < scores.size(); key++)
+    {
+        ByteDistribution deciphered(cipherText ^ ByteData(static_cast<std::uint8_t>(key)));
+        ASSERT_DOUBLE_EQ(deciphered.distance(reference), scores[key]) << "key " << key;
+    }
+}
+
+TEST_F(DecryptorXorTest, EmptySingleXor) { ASSERT_THROW(decryptor->decipherSingle(ByteData()), std::invalid_argument); }
+
 TEST_F(DecryptorXorTest, CheckConfidenceSingleXor)
 {
     std::string englishText = "My father works at the factory. My mother is a teacher."
@@ -188,3 +219,371 @@ TEST_F(DecryptorXorTest, CheckConfidenceMultiXor)
 
     ASSERT_LT(confidenceEnglish, confidenceGibrish);
 }
+
+TEST_F(DecryptorXorTest, MultiXorParallelSameAsSerial)
+{
+    std::string englishText = FileUtils::read("assets/mobydick.txt").substr(10000, 3000);
+
+    for (auto cipher : {ByteData{"333435", ByteData::Encoding::hex}, ByteData{"1234567890", ByteData::Encoding::plain},
+                        ByteData{"a much longer key of 29 bytes", ByteData::Encoding::plain}})
+    {
+        ByteData cipherText = ByteData(englishText, ByteData::Encoding::plain) ^ cipher;
+
+        auto serial = decryptor->decipherMulti(cipherText, std::pair(2, 40));
+        ASSERT_EQ(englishText, std::get<0>(serial));
+
+        for (std::size_t numThreads : {2, 4, 0})
+        {
+            ASSERT_EQ(serial, decryptor->decipherMulti(cipherText, std::pair(2, 40), numThreads));
+        }
+    }
+}
+
+TEST_F(DecryptorXorTest, SingleXorBatch)
+{
+    auto lines = FileUtils::readLines("assets/mobydick.txt");
+    std::vector<ByteData> cipheredData;
+    for (std::size_t i = 0; i < 3000; i++)
+    {
+        // plain english lines, but every 5th one is gibberish
+        auto line = (i % 5 == 0) ? GeneralUtils::randomData(40) : ByteData(lines.at(i), ByteData::Encoding::plain);
+        cipheredData.push_back(line.size() == 0 ? line : line ^ static_cast<std::uint8_t>(i));
+    }
+    std::vector<ByteView> views(cipheredData.begin(), cipheredData.end());
+
+    auto best = decryptor->decipherSingleBatch(views, 10);
+    ASSERT_EQ(10, best.size());
+
+    for (std::size_t i = 0; i < best.size(); i++)
+    {
+        auto [index, key, confidence] = best[i];
+        ASSERT_NE(0, index % 5);
+        ASSERT_EQ(decryptor->decipherSingle(cipheredData[index]), std::make_tuple(lines.at(index), key, confidence));
+        if (i > 0)
+        {
+            ASSERT_LE(std::get<2>(best[i - 1]), confidence);
+        }
+    }
+
+    ASSERT_EQ(best, decryptor->decipherSingleBatch(views, 10, 4));
+    ASSERT_EQ(best.front(), decryptor->decipherSingleBatch(views, 1, 3).front());
+    ASSERT_TRUE(decryptor->decipherSingleBatch(views, 0).empty());
+    ASSERT_TRUE(decryptor->decipherSingleBatch({}, 5).empty());
+}
+
+TEST_F(DecryptorXorTest, RankKeySizesSameAsRows)
+{
+    // long enough for several blocks
+    auto cipherText = ByteData(FileUtils::read("assets/mobydick.txt").substr(0, 70000), ByteData::Encoding::plain) ^
+                      ByteData("a key of 17 bytes", ByteData::Encoding::plain);
+
+    auto ranked = DecryptorXor::rankKeySizes(cipherText, std::pair(1, 300));
+    ASSERT_EQ(300, ranked.size());
+    // multiples of the key size are as good as the key size itself
+    ASSERT_EQ(0, ranked.front().first % 17);
+
+    for (auto [keySize, score] : ranked)
+    {
+        auto rows = cipherText.extractRowViews(keySize);
+        if (rows.front().size() != rows.back().size())
+        {
+            rows.pop_back();
+        }
+
+        std::uint64_t bits = 0;
+        for (std::size_t i = 0; i < rows.size(); i++)
+        {
+            bits += rows[i].hammingBits(rows[(i + 1) % rows.size()]);
+        }
+
+        ASSERT_EQ(static_cast<double>(bits) / static_cast<double>(rows.size() * keySize), score) << keySize;
+    }
+}
+
+TEST_F(DecryptorXorTest, RankKeySizesShortData)
+{
+    ByteData data("0123456789", ByteData::Encoding::plain);
+
+    // only the key sizes that fit at least twice are ranked
+    auto ranked = DecryptorXor::rankKeySizes(data, std::pair(2, 40));
+    ASSERT_EQ(4, ranked.size());
+    ASSERT_TRUE(DecryptorXor::rankKeySizes(data, std::pair(6, 40)).empty());
+
+    ASSERT_THROW(DecryptorXor::rankKeySizes(data, std::pair(0, 4)), std::invalid_argument);
+    ASSERT_THROW(DecryptorXor::rankKeySizes(data, std::pair(5, 4)), std::invalid_argument);
+}
+
+TEST_F(DecryptorXorTest, RankSingleByteKeys)
+{
+    ByteData cipherText = ByteData("Call me Ishmael. Some years ago", ByteData::Encoding::plain) ^ std::uint8_t{0x5a};
+    auto scores = decryptor->scoreSingleByteKeys(cipherText);
+
+    auto ranked = decryptor->rankSingleByteKeys(cipherText, 5);
+    ASSERT_EQ(5, ranked.size());
+    ASSERT_EQ(std::uint8_t{0x5a}, ranked.front().first);
+    ASSERT_EQ(std::get<2>(decryptor->decipherSingle(cipherText)), ranked.front().second);
+
+    for (std::size_t i = 0; i < ranked.size(); i++)
+    {
+        ASSERT_EQ(scores[ranked[i].first], ranked[i].second);
+        if (i > 0)
+        {
+            ASSERT_LE(ranked[i - 1].second, ranked[i].second);
+        }
+    }
+
+    ASSERT_EQ(256, decryptor->rankSingleByteKeys(cipherText, 1000).size());
+    ASSERT_TRUE(decryptor->rankSingleByteKeys(cipherText, 0).empty());
+}
+
+TEST_F(DecryptorXorTest, RankColumnKeys)
+{
+    std::string englishText = FileUtils::read("assets/mobydick.txt").substr(10000, 3000);
+    ByteData cipher{"1234567890", ByteData::Encoding::plain};
+    ByteData cipherText = ByteData(englishText, ByteData::Encoding::plain) ^ cipher;
+
+    auto ranked = decryptor->rankColumnKeys(cipherText, cipher.size(), 3);
+    ASSERT_EQ(cipher.size(), ranked.size());
+    for (std::size_t i = 0; i < ranked.size(); i++)
+    {
+        ASSERT_EQ(3, ranked[i].size());
+        ASSERT_EQ(cipher.secureData()[i], ranked[i].front().first);
+    }
+
+    ASSERT_THROW(decryptor->rankColumnKeys(cipherText, 0, 3), std::invalid_argument);
+}
+
+TEST_F(DecryptorXorTest, RankMultiByteKeys)
+{
+    std::string englishText = FileUtils::read("assets/mobydick.txt").substr(10000, 3000);
+    ByteData cipher{"1234567890", ByteData::Encoding::plain};
+    ByteData cipherText = ByteData(englishText, ByteData::Encoding::plain) ^ cipher;
+
+    auto ranked = decryptor->rankMultiByteKeys(cipherText, std::pair(2, 40), 6);
+    ASSERT_EQ(6, ranked.size());
+    ASSERT_EQ(cipher, ranked.front().first);
+
+    auto [decipher, key, confidence] = decryptor->decipherMulti(cipherText, std::pair(2, 40));
+    ASSERT_EQ(englishText, decipher);
+    ASSERT_EQ(std::make_pair(key, confidence), ranked.front());
+
+    for (std::size_t i = 1; i < ranked.size(); i++)
+    {
+        ASSERT_LE(ranked[i - 1].second, ranked[i].second);
+    }
+
+    ASSERT_EQ(ranked, decryptor->rankMultiByteKeys(cipherText, std::pair(2, 40), 6, 4));
+    ASSERT_THROW(decryptor->rankMultiByteKeys(ByteData(), std::pair(2, 40), 6), std::invalid_argument);
+}
+
+TEST_F(DecryptorXorTest, NGramModelShortTexts)
+{
+    auto str = FileUtils::read("assets/mobydick.txt");
+
+    // short texts have too few bytes for the byte distribution alone
+    std::size_t distributionCorrect = 0, ngramCorrect = 0, total = 0;
+    for (std::size_t offset = 1000; offset + 12 < str.size() && total < 300; offset += 997, total++)
+    {
+        auto key = static_cast<std::uint8_t>(offset * 31);
+        auto ciphered = ByteData(str.substr(offset, 12), ByteData::Encoding::plain) ^ key;
+
+        distributionCorrect += std::get<1>(decryptor->decipherSingle(ciphered)) == key;
+        ngramCorrect += std::get<1>(ngramDecryptor->decipherSingle(ciphered)) == key;
+    }
+
+    ASSERT_GT(ngramCorrect, distributionCorrect);
+    ASSERT_GE(ngramCorrect * 100, total * 95);
+}
+
+TEST_F(DecryptorXorTest, NGramModelMultiXor)
+{
+    auto str = FileUtils::read("assets/mobydick.txt");
+
+    std::string plain = str.substr(10000, 2000);
+    ByteData key("Nantucket", ByteData::Encoding::plain);
+    auto [resultStr, resultKey, confidence] =
+        ngramDecryptor->decipherMulti(ByteData(plain, ByteData::Encoding::plain) ^ key, {2, 20});
+
+    ASSERT_EQ(plain, resultStr);
+    ASSERT_EQ(key, resultKey);
+}
+
+TEST_F(DecryptorXorTest, EstimateMultiByteKey)
+{
+    auto str = FileUtils::read("assets/mobydick.txt");
+    ByteData key("Nantucket whaler", ByteData::Encoding::plain);
+    auto ciphered = ByteData(str, ByteData::Encoding::plain) ^ key;
+
+    // samples of a few blocks out of the whole book
+    auto [resultKey, confidence, agreement] = decryptor->estimateMultiByteKey(ciphered, {2, 40}, 64 * 1024);
+    ASSERT_EQ(key, resultKey);
+    ASSERT_DOUBLE_EQ(1.0, agreement);
+    ASSERT_LT(confidence, std::numeric_limits<double>::max());
+
+    // the samples cover all of the data
+    auto [allKey, allConfidence, allAgreement] = decryptor->estimateMultiByteKey(ciphered, {2, 40}, ciphered.size(), 2);
+    ASSERT_EQ(key, allKey);
+    ASSERT_DOUBLE_EQ(1.0, allAgreement);
+}
+
+TEST_F(DecryptorXorTest, EstimateMultiByteKeyShortData)
+{
+    std::string plain = FileUtils::read("assets/mobydick.txt").substr(5000, 3000);
+    ByteData key("key", ByteData::Encoding::plain);
+
+    // a single block, both of the samples are the same
+    auto [resultKey, confidence, agreement] =
+        decryptor->estimateMultiByteKey(ByteData(plain, ByteData::Encoding::plain) ^ key, {2, 10});
+    ASSERT_EQ(key, resultKey);
+    ASSERT_DOUBLE_EQ(1.0, agreement);
+
+    auto [noKey, noConfidence, noAgreement] =
+        decryptor->estimateMultiByteKey(ByteData("abc", ByteData::Encoding::plain), {2, 10});
+    ASSERT_EQ(0, noKey.size());
+    ASSERT_DOUBLE_EQ(0.0, noAgreement);
+}
+
+TEST_F(DecryptorXorTest, EstimateMultiByteKeyWrongArguments)
+{
+    ByteData data("some data", ByteData::Encoding::plain);
+
+    ASSERT_THROW(decryptor->estimateMultiByteKey(data, {1, 10}), std::invalid_argument);
+    ASSERT_THROW(decryptor->estimateMultiByteKey(data, {5, 4}), std::invalid_argument);
+    ASSERT_THROW(decryptor->estimateMultiByteKey(ByteData(), {2, 10}), std::invalid_argument);
+    ASSERT_THROW(decryptor->estimateMultiByteKey(data, {2, 10}, 0), std::invalid_argument);
+}
+
+TEST_F(DecryptorXorTest, DecipherMultiFile)
+{
+    auto str = FileUtils::read("assets/mobydick.txt");
+    ByteData key("Queequeg", ByteData::Encoding::plain);
+    auto inFileName = (std::filesystem::temp_directory_path() / "matasano_decipher_multi_in.bin").string();
+    auto outFileName = (std::filesystem::temp_directory_path() / "matasano_decipher_multi_out.txt").string();
+    {
+        std::ofstream file(inFileName, std::ios::binary | std::ios::trunc);
+        file << (ByteData(str, ByteData::Encoding::plain) ^ key).str(ByteData::Encoding::plain);
+    }
+
+    auto [resultKey, confidence, agreement] = decryptor->decipherMultiFile(inFileName, outFileName, {2, 20}, 32 * 1024);
+    ASSERT_EQ(key, resultKey);
+    ASSERT_EQ(str, FileUtils::read(outFileName));
+
+    ASSERT_THROW(decryptor->decipherMultiFile("blah.bin", outFileName, {2, 20}), std::ios_base::failure);
+
+    std::remove(inFileName.c_str());
+    std::remove(outFileName.c_str());
+}
+
+TEST_F(DecryptorXorTest, DecipherMultiFileSamplesDisagree)
+{
+    // 4 blocks of 16 KiB in 2 samples: blocks 0 and 2 are the first one, ciphered with another key than 1 and 3
+    auto str = FileUtils::read("assets/mobydick.txt").substr(0, 64 * 1024);
+    ByteData plain(str, ByteData::Encoding::plain);
+    ByteData firstKey("Queequeg", ByteData::Encoding::plain);
+    ByteData secondKey("Tashtego", ByteData::Encoding::plain);
+    ByteData ciphered(0, plain.size());
+    for (std::size_t i = 0; i < plain.size(); i++)
+    {
+        auto const &key = (i / (16 * 1024)) % 2 == 0 ? firstKey : secondKey;
+        ciphered.secureData()[i] = plain.secureData()[i] ^ key.secureData()[i % key.size()];
+    }
+
+    auto inFileName = (std::filesystem::temp_directory_path() / "matasano_decipher_disagree_in.bin").string();
+    auto outFileName = (std::filesystem::temp_directory_path() / "matasano_decipher_disagree_out.txt").string();
+    {
+        std::ofstream file(inFileName, std::ios::binary | std::ios::trunc);
+        file << ciphered.str(ByteData::Encoding::plain);
+    }
+    std::remove(outFileName.c_str());
+
+    ASSERT_THROW(decryptor->decipherMultiFile(inFileName, outFileName, {2, 20}, 32 * 1024), std::invalid_argument);
+    ASSERT_FALSE(std::filesystem::exists(outFileName));
+
+    // without a threshold the key of the first sample is used
+    auto [resultKey, confidence, agreement] = decryptor->decipherMultiFile(inFileName, outFileName, {2, 20}, 32 * 1024,
+                                                                          1, 0.0);
+    ASSERT_EQ(firstKey, resultKey);
+    ASSERT_LT(agreement, 1.0);
+
+    std::remove(inFileName.c_str());
+    std::remove(outFileName.c_str());
+}
+
+TEST_F(DecryptorXorTest, RefineMultiByteKey)
+{
+    auto str = FileUtils::read("assets/mobydick.txt");
+
+    // a long key over a short text, only 10 bytes per column
+    const std::size_t keySize = 30;
+    std::size_t solvedCorrect = 0, refinedCorrect = 0;
+    for (std::size_t t = 0; t < 20; t++)
+    {
+        ByteData key(0, keySize);
+        for (std::size_t i = 0; i < keySize; i++)
+        {
+            key.secureData()[i] = static_cast<std::uint8_t>(t * 131 + i * 71 + 7);
+        }
+        auto ciphered = ByteData(str.substr(20000 + t * 5000, 300), ByteData::Encoding::plain) ^ key;
+
+        ByteData solved(0, keySize);
+        auto columns = ngramDecryptor->rankColumnKeys(ciphered, keySize, 1);
+        for (std::size_t i = 0; i < keySize; i++)
+        {
+            solved.secureData()[i] = columns[i].front().first;
+        }
+        auto refined = ngramDecryptor->refineMultiByteKey(ciphered, solved);
+        ASSERT_EQ(keySize, refined.size());
+
+        for (std::size_t i = 0; i < keySize; i++)
+        {
+            solvedCorrect += solved.secureData()[i] == key.secureData()[i];
+            refinedCorrect += refined.secureData()[i] == key.secureData()[i];
+        }
+    }
+
+    ASSERT_GT(refinedCorrect, solvedCorrect);
+    ASSERT_GE(refinedCorrect * 100, 20 * keySize * 95);
+}
+
+TEST_F(DecryptorXorTest, RefineMultiByteKeyKeepsRightKey)
+{
+    auto str = FileUtils::read("assets/mobydick.txt");
+
+    ByteData key("Call me Ishmael", ByteData::Encoding::plain);
+    auto ciphered = ByteData(str.substr(1000, 2000), ByteData::Encoding::plain) ^ key;
+    ASSERT_EQ(key, ngramDecryptor->refineMultiByteKey(ciphered, key));
+
+    ASSERT_THROW(ngramDecryptor->refineMultiByteKey(ciphered, ByteData("k", ByteData::Encoding::plain)),
+                 std::invalid_argument);
+    ASSERT_THROW(decryptor->refineMultiByteKey(ciphered, key), std::logic_error);
+}
+
+TEST_F(DecryptorXorTest, DecipherSharedKeystream)
+{
+    // lines of different lengths (some of them empty) ciphered with the same keystream
+    auto lines = FileUtils::readLines("assets/mobydick.txt");
+    auto keystream = GeneralUtils::randomData(200);
+    std::vector<ByteData> cipheredData;
+    std::size_t longest = 0;
+    for (std::size_t i = 0; i < 5000; i++)
+    {
+        auto line = ByteData(lines.at(i), ByteData::Encoding::plain);
+        cipheredData.push_back(line.size() == 0 ? line : line ^ keystream);
+        longest = std::max(longest, line.size());
+    }
+    std::vector<ByteView> views(cipheredData.begin(), cipheredData.end());
+
+    for (auto const *d : {decryptor.get(), ngramDecryptor.get()})
+    {
+        auto [key, confidence] = d->decipherSharedKeystream(views);
+        ASSERT_EQ(longest, key.size());
+        ASSERT_EQ(longest, confidence.size());
+        // the columns of the first 60 bytes have hundreds of bytes each
+        ASSERT_EQ(ByteView(keystream).subView(0, 60), ByteView(key).subView(0, 60));
+
+        ASSERT_EQ(std::make_pair(key, confidence), d->decipherSharedKeystream(views, 4));
+    }
+
+    ASSERT_TRUE(decryptor->decipherSharedKeystream({}).first.size() == 0);
+    ASSERT_TRUE(decryptor->decipherSharedKeystream(std::vector<ByteView>(3)).second.empty());
+}
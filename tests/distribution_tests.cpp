@@ -73,4 +73,56 @@ TEST(ByteDistributionTest, DistanceDifferentCompletely)
     ByteDistribution distribution2(bytes2);
 
     ASSERT_EQ(200.0, distribution.distance(distribution2));
-}
\ No newline at end of file
+}
+
+TEST(ByteDistributionTest, DistanceDifferentTails)
+{
+    // bytes that appear only in one of the distributions, with different percentages
+    ByteData bytes("aaaaaaab", ByteData::Encoding::plain);
+    ByteDistribution distribution(bytes);
+
+    ByteData bytes2("aaaaaccd", ByteData::Encoding::plain);
+    ByteDistribution distribution2(bytes2);
+
+    // a: |87.5 - 62.5|, b: 12.5, c: 25, d: 12.5
+    ASSERT_EQ(75.0, distribution.distance(distribution2));
+    ASSERT_EQ(75.0, distribution2.distance(distribution));
+}
+
+TEST(ByteDistributionTest, Histogram)
+{
+    ByteData bytes("abracadabra", ByteData::Encoding::plain);
+    auto histogram = ByteDistribution::histogram(bytes);
+
+    ASSERT_EQ(5, histogram['a']);
+    ASSERT_EQ(2, histogram['b']);
+    ASSERT_EQ(2, histogram['r']);
+    ASSERT_EQ(1, histogram['c']);
+    ASSERT_EQ(1, histogram['d']);
+    ASSERT_EQ(0, histogram['z']);
+
+    ByteDistribution fromHistogram(histogram, bytes.size());
+    ASSERT_EQ(0, fromHistogram.distance(ByteDistribution(bytes)));
+    ASSERT_EQ(5, fromHistogram.size());
+}
+
+TEST(ByteDistributionTest, Empty)
+{
+    ByteDistribution distribution(ByteData{});
+
+    ASSERT_EQ(0, distribution.size());
+    ASSERT_EQ(0, distribution.at(std::uint8_t{'a'}));
+}
+
+TEST(ByteDistributionTest, DistanceXored)
+{
+    ByteData bytes("some text to xor, with a few repeated letters", ByteData::Encoding::plain);
+    ByteDistribution distribution(bytes);
+    ByteDistribution reference(ByteData("another text for comparison", ByteData::Encoding::plain));
+
+    for (std::size_t key = 0; key < 256; key++)
+    {
+        ByteDistribution xored(bytes ^ ByteData(static_cast<std::uint8_t>(key)));
+        ASSERT_EQ(xored.distance(reference), distribution.distance(reference, static_cast<std::uint8_t>(key)));
+    }
+}
@@ -5,6 +5,35 @@
 #include "general_utils.h"
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <initializer_list>
+
+/**
+ * @brief encrypts the concatenation of parts into out (@see AesEcbOracle::encryptorFunction)
+ */
+static std::size_t encryptParts(const Aes &aes, std::initializer_list<ByteView> parts, std::span<std::uint8_t> out)
+{
+    std::size_t plainSize = 0;
+    for (auto part : parts)
+    {
+        plainSize += part.size();
+    }
+
+    auto cipherSize = aes.cipherSize(plainSize);
+    if (cipherSize > out.size())
+    {
+        return cipherSize;
+    }
+
+    auto it = out.begin();
+    for (auto part : parts)
+    {
+        it = std::copy(part.begin(), part.end(), it);
+    }
+
+    return aes.encryptInPlace(out, plainSize);
+}
+
 TEST(EcbOracletTest, TestEcb)
 {
     auto key = GeneralUtils::randomData(16);
@@ -13,11 +42,11 @@ TEST(EcbOracletTest, TestEcb)
     for (std::size_t i; i <= CryptoConstants::BLOCK_SIZE_BYTES; i++)
     {
         AesEcbOracle oracle(
-            [&](const ByteData &plain) -> ByteData {
+            [&](ByteView plain, std::span<std::uint8_t> out) {
                 auto prepend = GeneralUtils::randomData(GeneralUtils::randomNum(std::size_t{0}, i));
                 auto append = GeneralUtils::randomData(GeneralUtils::randomNum(std::size_t{0}, i));
 
-                return aes.encrypt(prepend + plain + append);
+                return encryptParts(aes, {prepend, plain, append}, out);
             },
             AesEcbOracle::EncryptorType::RandomUpToBlock1_Plain_RandomUpToBlock2);
 
@@ -34,11 +63,11 @@ TEST(EcbOracletTest, TestNotEcb)
     for (std::size_t i; i <= CryptoConstants::BLOCK_SIZE_BYTES; i++)
     {
         AesEcbOracle oracle(
-            [&](const ByteData &plain) -> ByteData {
+            [&](ByteView plain, std::span<std::uint8_t> out) {
                 auto prepend = GeneralUtils::randomData(GeneralUtils::randomNum(std::size_t{0}, i));
                 auto append = GeneralUtils::randomData(GeneralUtils::randomNum(std::size_t{0}, i));
 
-                return aes.encrypt(prepend + plain + append);
+                return encryptParts(aes, {prepend, plain, append}, out);
             },
             AesEcbOracle::EncryptorType::RandomUpToBlock1_Plain_RandomUpToBlock2);
 
@@ -53,8 +82,9 @@ TEST(EcbOracletTest, WrongEncryptorType)
 
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(plain + secret); },
-                        AesEcbOracle::EncryptorType::RandomUpToBlock1_Plain_RandomUpToBlock2);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {plain, secret}, out); },
+        AesEcbOracle::EncryptorType::RandomUpToBlock1_Plain_RandomUpToBlock2);
 
     ASSERT_THROW(oracle.recoverSecret(), std::invalid_argument);
 }
@@ -66,8 +96,9 @@ TEST(EcbOracletTest, TestRetrieveRandomSecretData)
 
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(plain + secret); },
-                        AesEcbOracle::EncryptorType::Plain_Secret);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {plain, secret}, out); },
+        AesEcbOracle::EncryptorType::Plain_Secret);
 
     auto recovered = oracle.recoverSecret();
     ASSERT_EQ(secret, recovered);
@@ -80,8 +111,9 @@ TEST(EcbOracletTest, TestRetrieveRandomSecretDataBlockSize)
 
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(plain + secret); },
-                        AesEcbOracle::EncryptorType::Plain_Secret);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {plain, secret}, out); },
+        AesEcbOracle::EncryptorType::Plain_Secret);
 
     auto recovered = oracle.recoverSecret();
     ASSERT_EQ(secret, recovered);
@@ -93,8 +125,9 @@ TEST(EcbOracletTest, TestRetrieveKnownSecretData)
     auto secret = ByteData("0123456789abcdefrtyu", ByteData::Encoding::plain);
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(plain + secret); },
-                        AesEcbOracle::EncryptorType::Plain_Secret);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {plain, secret}, out); },
+        AesEcbOracle::EncryptorType::Plain_Secret);
 
     auto recovered = oracle.recoverSecret();
     ASSERT_EQ(secret, recovered);
@@ -108,8 +141,9 @@ TEST(EcbOracletTest, TestRetrieveRandomSecretDataConstantRandom_Plain_Secret)
 
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(random + plain + secret); },
-                        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {random, plain, secret}, out); },
+        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
 
     auto recovered = oracle.recoverSecret();
     ASSERT_EQ(secret, recovered);
@@ -123,8 +157,9 @@ TEST(EcbOracletTest, TestRetrieveRandomSecretDataBlockSizeConstantRandom_Plain_S
 
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(random + plain + secret); },
-                        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {random, plain, secret}, out); },
+        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
 
     auto recovered = oracle.recoverSecret();
     ASSERT_EQ(secret, recovered);
@@ -137,8 +172,9 @@ TEST(EcbOracletTest, TestRetrieveKnownSecretDataConstantRandom_Plain_Secret1)
     auto secret = ByteData("1123456789abcdefrtyu", ByteData::Encoding::plain);
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(random + plain + secret); },
-                        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {random, plain, secret}, out); },
+        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
 
     auto recovered = oracle.recoverSecret();
     ASSERT_EQ(secret, recovered);
@@ -151,8 +187,9 @@ TEST(EcbOracletTest, TestRetrieveKnownSecretDataConstantRandom_Plain_Secret2)
     auto secret = ByteData("0123456789abcdefrtyu", ByteData::Encoding::plain);
     Aes ecb(key, ByteData(), Aes::Mode::ecb);
 
-    AesEcbOracle oracle([&](const ByteData &plain) -> ByteData { return ecb.encrypt(random + plain + secret); },
-                        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
+    AesEcbOracle oracle(
+        [&](ByteView plain, std::span<std::uint8_t> out) { return encryptParts(ecb, {random, plain, secret}, out); },
+        AesEcbOracle::EncryptorType::ConstantRandom_Plain_Secret);
 
     auto recovered = oracle.recoverSecret();
     ASSERT_EQ(secret, recovered);
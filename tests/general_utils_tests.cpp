@@ -63,3 +63,23 @@ TEST(TestRandomNumber, TestEqualRanges)
 }
 
 TEST(TestRandomNumber, TestEmptyVector) { ASSERT_EQ(0, GeneralUtils::randomData(0).size()); }
+
+TEST(TestParallelFor, TestEachIndexOnce)
+{
+    for (std::size_t numThreads : {1, 3, 0})
+    {
+        std::vector<int> calls(1000, 0);
+        GeneralUtils::parallelFor(calls.size(), numThreads, [&](std::size_t i) { calls[i]++; });
+        ASSERT_EQ(std::vector<int>(calls.size(), 1), calls);
+    }
+
+    GeneralUtils::parallelFor(0, 4, [](std::size_t) { FAIL(); });
+}
+
+TEST(TestParallelFor, TestRethrows)
+{
+    auto throwing = [](std::size_t i) { THROW_IF(i == 7, "bad index", std::invalid_argument); };
+
+    ASSERT_THROW(GeneralUtils::parallelFor(100, 1, throwing), std::invalid_argument);
+    ASSERT_THROW(GeneralUtils::parallelFor(100, 4, throwing), std::invalid_argument);
+}
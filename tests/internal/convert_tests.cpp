@@ -1,5 +1,8 @@
 #include "internal/matasano_convert.h"
 #include "gtest/gtest.h"
+#include <cstdint>
+#include <string>
+#include <vector>
 
 TEST(ConvertTestsParseNum, TestEmpty)
 {
@@ -57,4 +60,157 @@ TEST(ConvertTestsNumToStr, NumFromStringAndBack)
     auto str = "aaaa";
     auto num = Convert::parseNumFromStr(str);
     ASSERT_EQ(str, Convert::numToStr(num));
-}
\ No newline at end of file
+}
+
+TEST(ConvertTestsHex, AllBytesRoundTrip)
+{
+    std::vector<std::uint8_t> bytes(256);
+    for (std::size_t i = 0; i < bytes.size(); i++)
+    {
+        bytes[i] = static_cast<std::uint8_t>(i);
+    }
+
+    std::string hex(bytes.size() * 2, '\0');
+    Convert::bytesToHex(bytes.data(), bytes.size(), hex.data());
+
+    for (std::size_t i = 0; i < bytes.size(); i++)
+    {
+        ASSERT_EQ(Convert::numToStr(bytes[i], 2, 16), hex.substr(2 * i, 2));
+    }
+
+    std::vector<std::uint8_t> decoded(bytes.size());
+    Convert::hexToBytes(hex.data(), hex.size(), decoded.data());
+    ASSERT_EQ(bytes, decoded);
+}
+
+TEST(ConvertTestsHex, UpperCase)
+{
+    std::string hex = "ABCDEF0123456789abcdefABCDEF0123456789ABCDEFabcdef0123456789ABCDEF0123456789";
+    std::vector<std::uint8_t> decoded(hex.size() / 2);
+    Convert::hexToBytes(hex.data(), hex.size(), decoded.data());
+
+    for (std::size_t i = 0; i < decoded.size(); i++)
+    {
+        ASSERT_EQ(Convert::parseNumFromStr(hex.substr(2 * i, 2)), decoded[i]);
+    }
+}
+
+TEST(ConvertTestsHex, UnevenLength)
+{
+    std::uint8_t out[4];
+    ASSERT_THROW(Convert::hexToBytes("abc", 3, out), std::invalid_argument);
+}
+
+TEST(ConvertTestsHex, InvalidCharAnyPosition)
+{
+    // covers both the vectorized blocks and the scalar tail
+    std::string valid(200, 'a');
+    std::vector<std::uint8_t> out(valid.size() / 2);
+
+    for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\xff'})
+    {
+        for (std::size_t pos = 0; pos < valid.size(); pos++)
+        {
+            auto hex = valid;
+            hex[pos] = bad;
+            ASSERT_THROW(Convert::hexToBytes(hex.data(), hex.size(), out.data()), std::invalid_argument);
+        }
+    }
+}
+
+TEST(ConvertTestsBase64, RoundTripLengths)
+{
+    // long enough to go through the vectorized decoder as well as the scalar tail
+    for (std::size_t size = 0; size < 300; size++)
+    {
+        std::vector<std::uint8_t> bytes(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            bytes[i] = static_cast<std::uint8_t>(i * 131 + size * 7);
+        }
+
+        std::string base64(Convert::base64Length(size), '\0');
+        Convert::bytesToBase64(bytes.data(), bytes.size(), base64.data());
+
+        std::vector<std::uint8_t> decoded(base64.size() / 4 * 3);
+        decoded.resize(Convert::base64ToBytes(base64.data(), base64.size(), decoded.data()));
+        ASSERT_EQ(bytes, decoded);
+    }
+}
+
+TEST(ConvertTestsBase64, SkipWhitespace)
+{
+    std::string base64 = "SSdtIGtpbGxpbmcgeW91ciBicmFpbiBsaWtlIGEgcG9pc29ub3VzIG11c2hyb29t";
+    std::string multiline = " SSdtIGtpbGxpbmcgeW91ciBicmFp\r\nbiBsaWtlIGEgcG9pc29ub\n3VzIG11c2hyb29t\n";
+
+    std::vector<std::uint8_t> expected(base64.size() / 4 * 3);
+    expected.resize(Convert::base64ToBytes(base64.data(), base64.size(), expected.data()));
+
+    std::vector<std::uint8_t> decoded(multiline.size() / 4 * 3);
+    decoded.resize(Convert::base64ToBytes(multiline.data(), multiline.size(), decoded.data(), true));
+    ASSERT_EQ(expected, decoded);
+
+    ASSERT_THROW(Convert::base64ToBytes(multiline.data(), multiline.size(), decoded.data()), std::invalid_argument);
+}
+
+TEST(ConvertTestsBase64, SkipWhitespaceLineWrapped)
+{
+    // several compaction buffers, lines that are and are not whole quads, padding at the end
+    for (std::size_t size : {10000, 10001, 10002})
+    {
+        std::vector<std::uint8_t> bytes(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            bytes[i] = static_cast<std::uint8_t>(i * 7 + i / 300);
+        }
+        std::string base64(Convert::base64Length(size), '\0');
+        Convert::bytesToBase64(bytes.data(), size, base64.data());
+
+        for (std::size_t lineLength : {1, 61, 64, 76})
+        {
+            for (std::string lineBreak : {"\n", "\r\n", " \t\v\f"})
+            {
+                std::string wrapped;
+                for (std::size_t i = 0; i < base64.size(); i += lineLength)
+                {
+                    wrapped += base64.substr(i, lineLength) + lineBreak;
+                }
+
+                std::vector<std::uint8_t> decoded(wrapped.size() / 4 * 3);
+                decoded.resize(Convert::base64ToBytes(wrapped.data(), wrapped.size(), decoded.data(), true));
+                ASSERT_EQ(bytes, decoded) << size << " " << lineLength;
+
+                // an invalid character far from the start is still found
+                wrapped[wrapped.size() / 2] = '.';
+                ASSERT_THROW(Convert::base64ToBytes(wrapped.data(), wrapped.size(), decoded.data(), true),
+                             std::invalid_argument);
+            }
+        }
+    }
+}
+
+TEST(ConvertTestsBase64, PaddingWithWhitespace)
+{
+    std::string base64 = "EjRW\neJA=\n";
+    std::uint8_t out[6];
+    ASSERT_EQ(5, Convert::base64ToBytes(base64.data(), base64.size(), out, true));
+
+    std::string base64Broken = "EjRW\neJ=\nA";
+    ASSERT_THROW(Convert::base64ToBytes(base64Broken.data(), base64Broken.size(), out, true), std::invalid_argument);
+}
+
+TEST(ConvertTestsBase64, InvalidCharAnyPosition)
+{
+    std::string valid(160, 'Q');
+    std::vector<std::uint8_t> out(valid.size() / 4 * 3);
+
+    for (char bad : {'.', '-', '_', '=', ' ', '\n', '\0', '\x80'})
+    {
+        for (std::size_t pos = 0; pos < valid.size() - 2; pos++)
+        {
+            auto base64 = valid;
+            base64[pos] = bad;
+            ASSERT_THROW(Convert::base64ToBytes(base64.data(), base64.size(), out.data()), std::invalid_argument);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#include "internal/xor_kernel.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <vector>
+
+TEST(XorKernelTests, RepeatingSameAsScalar)
+{
+    // key sizes around and above the vector width, data sizes that hit both the scalar and the vectorized paths
+    for (std::size_t keySize : {1, 2, 3, 7, 16, 31, 32, 33, 63, 64, 65, 100, 200})
+    {
+        std::vector<std::uint8_t> key(keySize);
+        for (std::size_t i = 0; i < keySize; i++)
+        {
+            key[i] = static_cast<std::uint8_t>(i * 37 + keySize);
+        }
+
+        for (std::size_t size : {1, 15, 64, 127, 128, 1000, 8191, 20000})
+        {
+            std::vector<std::uint8_t> data(size);
+            std::vector<std::uint8_t> expected(size);
+            for (std::size_t i = 0; i < size; i++)
+            {
+                data[i] = static_cast<std::uint8_t>(i * 131 + 5);
+                expected[i] = data[i] ^ key[i % keySize];
+            }
+
+            std::vector<std::uint8_t> out(size);
+            XorKernel::xorRepeating(data.data(), size, key.data(), keySize, out.data());
+            ASSERT_EQ(expected, out) << "key size " << keySize << ", data size " << size;
+
+            // in place
+            XorKernel::xorRepeating(data.data(), size, key.data(), keySize, data.data());
+            ASSERT_EQ(expected, data) << "key size " << keySize << ", data size " << size;
+        }
+    }
+}
+
+TEST(XorKernelTests, Blocks)
+{
+    for (std::size_t size = 0; size < 300; size++)
+    {
+        std::vector<std::uint8_t> lhs(size), rhs(size), expected(size), out(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            lhs[i] = static_cast<std::uint8_t>(i * 7);
+            rhs[i] = static_cast<std::uint8_t>(i * 13 + size);
+            expected[i] = lhs[i] ^ rhs[i];
+        }
+
+        XorKernel::xorBlocks(lhs.data(), rhs.data(), size, out.data());
+        ASSERT_EQ(expected, out);
+    }
+}
+
+TEST(XorKernelTests, HammingDistance)
+{
+    // sizes around all the vector widths, so every path and every tail is used
+    for (std::size_t size = 0; size < 300; size++)
+    {
+        std::vector<std::uint8_t> lhs(size), rhs(size);
+        std::uint64_t expected = 0;
+        for (std::size_t i = 0; i < size; i++)
+        {
+            lhs[i] = static_cast<std::uint8_t>(i * 7 + 1);
+            rhs[i] = static_cast<std::uint8_t>(i * 13 + size);
+            for (auto diff = lhs[i] ^ rhs[i]; diff != 0; diff >>= 1)
+            {
+                expected += diff & 1;
+            }
+        }
+
+        ASSERT_EQ(expected, XorKernel::hammingDistance(lhs.data(), rhs.data(), size)) << "size " << size;
+    }
+}
+
+TEST(XorKernelTests, HammingDistanceAllBitsDiffer)
+{
+    std::vector<std::uint8_t> zeroes(1000, 0x00), ones(1000, 0xff);
+    ASSERT_EQ(8000, XorKernel::hammingDistance(zeroes.data(), ones.data(), zeroes.size()));
+    ASSERT_EQ(0, XorKernel::hammingDistance(ones.data(), ones.data(), ones.size()));
+}
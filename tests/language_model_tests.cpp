@@ -0,0 +1,58 @@
+#include "byte_data.h"
+#include "decryptor_xor.h"
+#include "file_utils.h"
+#include "language_model.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+static std::string tempFileName(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+TEST(LanguageModelTest, SaveLoadRoundTrip)
+{
+    auto referenceText = FileUtils::read("assets/mobydick.txt");
+    LanguageModel model(ByteData(referenceText, ByteData::Encoding::plain));
+    ASSERT_EQ(referenceText.size(), model.total());
+
+    auto fileName = tempFileName("matasano_language_model_test.model");
+    model.save(fileName);
+    ASSERT_EQ(LanguageModel::FILE_SIZE, std::filesystem::file_size(fileName));
+
+    auto loaded = LanguageModel::load(fileName);
+    std::remove(fileName.c_str());
+
+    ASSERT_EQ(model.total(), loaded.total());
+    ASSERT_EQ(model.histogram(), loaded.histogram());
+    ASSERT_DOUBLE_EQ(0.0, model.distribution().distance(loaded.distribution()));
+
+    DecryptorXor fromText(referenceText);
+    DecryptorXor fromModel(loaded);
+    ByteData plain("Call me Ishmael. Some years ago, never mind how long precisely", ByteData::Encoding::plain);
+    auto ciphered = plain ^ ByteData("key", ByteData::Encoding::plain);
+    ASSERT_EQ(fromText.scoreSingleByteKeys(ciphered), fromModel.scoreSingleByteKeys(ciphered));
+    ASSERT_EQ(fromText.decipherMulti(ciphered, {2, 6}), fromModel.decipherMulti(ciphered, {2, 6}));
+}
+
+TEST(LanguageModelTest, LoadNoFile)
+{
+    ASSERT_THROW(LanguageModel::load("blah.model"), std::ifstream::failure);
+}
+
+TEST(LanguageModelTest, LoadNotModel)
+{
+    ASSERT_THROW(LanguageModel::load("assets/file_read_test.txt"), std::invalid_argument);
+
+    auto fileName = tempFileName("matasano_language_model_bad_magic.model");
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        file << std::string(LanguageModel::FILE_SIZE, 'x');
+    }
+    ASSERT_THROW(LanguageModel::load(fileName), std::invalid_argument);
+    std::remove(fileName.c_str());
+}
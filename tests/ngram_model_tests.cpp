@@ -0,0 +1,77 @@
+#include "byte_data.h"
+#include "file_utils.h"
+#include "ngram_model.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+
+class NGramModelTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        text = FileUtils::read("assets/mobydick.txt");
+        model = std::make_shared<NGramModel>(ByteData(text, ByteData::Encoding::plain));
+    }
+
+    static std::string text;
+    static std::shared_ptr<NGramModel> model;
+};
+
+std::string NGramModelTest::text;
+std::shared_ptr<NGramModel> NGramModelTest::model = nullptr;
+
+TEST_F(NGramModelTest, ClassOf)
+{
+    ASSERT_EQ(NGramModel::classOf('a'), NGramModel::classOf('A'));
+    ASSERT_NE(NGramModel::classOf('a'), NGramModel::classOf('b'));
+    ASSERT_NE(NGramModel::classOf(' '), NGramModel::classOf(0));
+    ASSERT_EQ(NGramModel::classOf('0'), NGramModel::classOf('9'));
+    for (std::size_t byte = 0; byte < 256; byte++)
+    {
+        ASSERT_LT(NGramModel::classOf(static_cast<std::uint8_t>(byte)), NGramModel::CLASSES);
+    }
+}
+
+TEST_F(NGramModelTest, ScoreWithKeySameAsXored)
+{
+    ByteData key("secret", ByteData::Encoding::plain);
+    // shorter and longer than the vectors and than a scoring chunk
+    for (std::size_t size : {1, 2, 3, 10, 17, 33, 255, 256, 257, 258, 1000, 4099})
+    {
+        ByteData plain(text.substr(500, size), ByteData::Encoding::plain);
+        auto ciphered = plain ^ key;
+
+        ASSERT_DOUBLE_EQ(model->score(plain), model->score(ciphered, key)) << size;
+        ASSERT_GT(model->score(plain), 0.0);
+    }
+}
+
+TEST_F(NGramModelTest, ScoreSameForRepeatedKey)
+{
+    ByteData key("key", ByteData::Encoding::plain);
+    ByteData ciphered = ByteData(text.substr(0, 3000), ByteData::Encoding::plain) ^ key;
+
+    // the same deciphered text, so exactly the same score
+    ASSERT_EQ(model->score(ciphered, key), model->score(ciphered, key + key));
+}
+
+TEST_F(NGramModelTest, EnglishScoresBetter)
+{
+    ByteData english("It is not down in any map; true places never are.", ByteData::Encoding::plain);
+    ByteData shuffled("ta ;aeprse y nI n  ipm.eeanoir nrvsca  ,tuta ldwo", ByteData::Encoding::plain);
+
+    ASSERT_LT(model->score(english), model->score(shuffled));
+    ASSERT_LT(model->score(english), model->score(english ^ std::uint8_t{0x20}));
+    ASSERT_LT(model->score(english), model->score(english ^ std::uint8_t{0x01}));
+}
+
+TEST_F(NGramModelTest, ScoreEmpty)
+{
+    ByteData key("key", ByteData::Encoding::plain);
+
+    ASSERT_THROW(model->score(ByteData()), std::invalid_argument);
+    ASSERT_THROW(model->score(ByteData(), key), std::invalid_argument);
+    ASSERT_THROW(model->score(key, ByteData()), std::invalid_argument);
+}
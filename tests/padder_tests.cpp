@@ -60,3 +60,11 @@ TEST(PadderTests, RemovePaddingWrongPadding)
     ByteData b("123456", ByteData::Encoding::plain);
     ASSERT_THROW(Padder::removePadding(b + std::uint8_t{3} + std::uint8_t{3}), std::invalid_argument);
 }
+
+TEST(PadderTests, PaddingSize)
+{
+    ByteData b("123456");
+    ASSERT_EQ(4u, Padder::paddingSize(Padder::pad(b, 4)));
+    ASSERT_EQ(0u, Padder::paddingSize(ByteView()));
+    ASSERT_THROW(Padder::paddingSize(b + std::uint8_t{3} + std::uint8_t{3}), std::invalid_argument);
+}
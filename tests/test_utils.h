@@ -0,0 +1,46 @@
+#ifndef MATASANO_TEST_UTILS_H
+#define MATASANO_TEST_UTILS_H
+
+#include "byte_data.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Data and keys shared by the tests
+ */
+namespace TestUtils
+{
+/**
+ * @brief the 16 byte key the cipher tests use
+ */
+inline const ByteData KEY("0123456789abcdef", ByteData::Encoding::plain);
+
+/**
+ * @brief the 16 byte iv the cbc tests use
+ */
+inline const ByteData IV("fedcba9876543210", ByteData::Encoding::plain);
+
+/**
+ * @brief the 8 byte nonce the ctr tests use
+ */
+inline const ByteData NONCE("76543210", ByteData::Encoding::plain);
+
+/**
+ * @brief deterministic data that does not repeat with any short period, much faster to make than random data
+ *
+ * @param size number of bytes
+ * @return the data
+ */
+inline ByteData patternData(std::size_t size)
+{
+    ByteData data(0, size);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        data.secureData()[i] = static_cast<std::uint8_t>(i * 31 + i / 257);
+    }
+    return data;
+}
+} // namespace TestUtils
+
+#endif
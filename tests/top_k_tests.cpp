@@ -0,0 +1,41 @@
+#include "top_k.h"
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <vector>
+
+TEST(TopKTest, KeepsBest)
+{
+    TopK<int> topK(3);
+    for (int value : {5, 1, 9, 3, 7, 2, 8})
+    {
+        topK.push(value);
+    }
+
+    ASSERT_EQ(3, topK.size());
+    ASSERT_EQ((std::vector<int>{1, 2, 3}), topK.extractSorted());
+    ASSERT_EQ(0, topK.size());
+}
+
+TEST(TopKTest, CustomOrder)
+{
+    TopK<int, std::greater<int>> topK(2);
+    for (int value : {5, 1, 9, 3})
+    {
+        topK.push(value);
+    }
+
+    ASSERT_EQ((std::vector<int>{9, 5}), topK.extractSorted());
+}
+
+TEST(TopKTest, FewerThanCapacityAndZeroCapacity)
+{
+    TopK<int> topK(10);
+    topK.push(4);
+    topK.push(2);
+    ASSERT_EQ((std::vector<int>{2, 4}), topK.extractSorted());
+
+    TopK<int> none(0);
+    none.push(1);
+    ASSERT_TRUE(none.extractSorted().empty());
+}
@@ -0,0 +1,98 @@
+#include "byte_data.h"
+#include "byte_distribution.h"
+#include "decryptor_xor.h"
+#include "file_utils.h"
+#include "language_model.h"
+#include "xor_scorers.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+
+class XorScorersTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        model = std::make_shared<LanguageModel>(
+            ByteData(FileUtils::read("assets/mobydick.txt"), ByteData::Encoding::plain));
+    }
+
+    static std::shared_ptr<LanguageModel> model;
+
+    static inline const std::string ENGLISH = "Call me Ishmael. Some years ago, never mind how long precisely, having "
+                                              "little or no money in my purse, and nothing particular to interest me.";
+};
+
+std::shared_ptr<LanguageModel> XorScorersTest::model = nullptr;
+
+/**
+ * @brief checks that scoring with a key is the same as scoring the xored data, and that the right key is the best
+ */
+template <XorScorer Scorer> void checkScorer(const Scorer &scorer, const std::string &english)
+{
+    const std::uint8_t cipher = 0x5a;
+    ByteData plain(english, ByteData::Encoding::plain);
+    ByteData ciphered = plain ^ cipher;
+
+    auto cipheredCounts = ByteDistribution::histogram(ciphered);
+    for (std::size_t key = 0; key < 256; key++)
+    {
+        auto deciphered = ciphered ^ ByteData(static_cast<std::uint8_t>(key));
+        ASSERT_DOUBLE_EQ(scorer.score(ByteDistribution::histogram(deciphered), deciphered.size(), 0),
+                         scorer.score(cipheredCounts, ciphered.size(), static_cast<std::uint8_t>(key)))
+            << "key " << key;
+    }
+
+    auto [resultStr, resultKey, ignore] = DecryptorXor::decipherSingle(ciphered, scorer);
+    ASSERT_EQ(cipher, resultKey);
+    ASSERT_EQ(english, resultStr);
+}
+
+TEST_F(XorScorersTest, L1) { checkScorer(L1Scorer(*model), ENGLISH); }
+
+TEST_F(XorScorersTest, L1SameAsDistance)
+{
+    L1Scorer scorer(*model);
+    ByteData data(ENGLISH, ByteData::Encoding::plain);
+
+    for (std::size_t key = 0; key < 256; key++)
+    {
+        ASSERT_DOUBLE_EQ(ByteDistribution(data).distance(model->distribution(), static_cast<std::uint8_t>(key)),
+                         scorer.score(ByteDistribution::histogram(data), data.size(), static_cast<std::uint8_t>(key)));
+    }
+}
+
+TEST_F(XorScorersTest, ChiSquared) { checkScorer(ChiSquaredScorer(*model), ENGLISH); }
+
+TEST_F(XorScorersTest, LogLikelihood) { checkScorer(LogLikelihoodScorer(*model), ENGLISH); }
+
+TEST_F(XorScorersTest, Printable)
+{
+    PrintableScorer scorer;
+    ByteData data(ENGLISH, ByteData::Encoding::plain);
+    auto counts = ByteDistribution::histogram(data);
+
+    ASSERT_DOUBLE_EQ(0.0, scorer.score(counts, data.size(), 0));
+    ASSERT_DOUBLE_EQ(1.0, scorer.score(counts, data.size(), 0x80));
+    ASSERT_DOUBLE_EQ(0.0, scorer.score(counts, 0, 0));
+}
+
+TEST_F(XorScorersTest, DecryptorReferenceScorer)
+{
+    // the multi byte key methods and their measure of confidence score with the scorer the decryptor is compiled with
+    BasicDecryptorXor<ChiSquaredScorer> decryptor(*model);
+    ChiSquaredScorer scorer(*model);
+
+    auto english = FileUtils::read("assets/mobydick.txt").substr(20000, 2000);
+    ByteData plain(english, ByteData::Encoding::plain);
+    ByteData key("Ishmael", ByteData::Encoding::plain);
+
+    auto [resultStr, resultKey, confidence] = decryptor.decipherMulti(plain ^ key, {2, 10});
+    ASSERT_EQ(key, resultKey);
+    ASSERT_EQ(english, resultStr);
+
+    auto counts = ByteDistribution::histogram(plain);
+    ASSERT_DOUBLE_EQ(scorer.score(counts, plain.size(), 0), confidence);
+    ASSERT_NE(L1Scorer(*model).score(counts, plain.size(), 0), confidence);
+}
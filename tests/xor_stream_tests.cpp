@@ -0,0 +1,139 @@
+#include "byte_data.h"
+#include "file_utils.h"
+#include "xor_stream.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+static std::string tempFileName(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static void writeFile(const std::string &fileName, const ByteData &data)
+{
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file << data.str(ByteData::Encoding::plain);
+}
+
+TEST(XorStreamTest, KeyPhaseAcrossChunks)
+{
+    auto data = TestUtils::patternData(10000);
+    ByteData key("seven!!", ByteData::Encoding::plain);
+    auto expected = data ^ key;
+
+    // chunks of all kinds of sizes, also smaller than the key and not multiples of it
+    for (std::size_t chunkSize : {1, 3, 7, 13, 64, 129, 1000, 10000})
+    {
+        XorStream stream(key);
+        ByteData result(0, data.size());
+        for (std::size_t offset = 0; offset < data.size(); offset += chunkSize)
+        {
+            auto size = std::min(chunkSize, data.size() - offset);
+            stream.process(data.secureData().data() + offset, size, result.secureData().data() + offset);
+            ASSERT_EQ((offset + size) % key.size(), stream.phase());
+        }
+        ASSERT_EQ(expected, result) << chunkSize;
+    }
+}
+
+TEST(XorStreamTest, InPlace)
+{
+    auto data = TestUtils::patternData(5000);
+    ByteData key("key", ByteData::Encoding::plain);
+    auto expected = data ^ key;
+
+    XorStream stream(key);
+    stream.process(data.secureData().data(), 100);
+    stream.process(data.secureData().data() + 100, data.size() - 100);
+    ASSERT_EQ(expected, data);
+}
+
+TEST(XorStreamTest, EmptyKey) { ASSERT_THROW(XorStream{ByteData()}, std::invalid_argument); }
+
+TEST(XorStreamTest, Streams)
+{
+    auto data = TestUtils::patternData(3 * 1024 * 1024 + 17);
+    ByteData key("ICE", ByteData::Encoding::plain);
+
+    std::istringstream in(data.str(ByteData::Encoding::plain));
+    std::ostringstream out;
+    ASSERT_EQ(data.size(), XorStream(key).process(in, out));
+    ASSERT_EQ((data ^ key).str(ByteData::Encoding::plain), out.str());
+}
+
+TEST(XorStreamTest, StreamWriteFails)
+{
+    // a stream buffer that can't take any output
+    struct FullBuffer : std::streambuf
+    {
+        int_type overflow(int_type) override { return traits_type::eof(); }
+    } full;
+    std::ostream out(&full);
+
+    std::istringstream in(TestUtils::patternData(1000).str(ByteData::Encoding::plain));
+    ASSERT_THROW(XorStream(ByteData("key", ByteData::Encoding::plain)).process(in, out), std::ios_base::failure);
+    ASSERT_EQ(std::ios_base::goodbit, out.exceptions());
+}
+
+TEST(XorStreamTest, Files)
+{
+    auto inFileName = tempFileName("matasano_xor_stream_in.bin");
+    auto outFileName = tempFileName("matasano_xor_stream_out.bin");
+    auto data = TestUtils::patternData(2 * 1024 * 1024 + 5);
+    ByteData key("a longer key", ByteData::Encoding::plain);
+    writeFile(inFileName, data);
+
+    XorStream::xorFile(inFileName, outFileName, key);
+    ASSERT_EQ((data ^ key).str(ByteData::Encoding::plain), FileUtils::read(outFileName));
+
+    // back again, in place
+    XorStream::xorFileInPlace(outFileName, key);
+    ASSERT_EQ(data.str(ByteData::Encoding::plain), FileUtils::read(outFileName));
+
+    std::remove(inFileName.c_str());
+    std::remove(outFileName.c_str());
+}
+
+TEST(XorStreamTest, SameFile)
+{
+    auto fileName = tempFileName("matasano_xor_stream_same.bin");
+    auto data = ByteData("the input is also the output", ByteData::Encoding::plain);
+    ByteData key("key", ByteData::Encoding::plain);
+    writeFile(fileName, data);
+
+    // through another path to the same file, it should be xored in place and not truncated first
+    auto otherPath = (std::filesystem::path(fileName).parent_path() / "." / "matasano_xor_stream_same.bin").string();
+    XorStream::xorFile(fileName, otherPath, key);
+    ASSERT_EQ((data ^ key).str(ByteData::Encoding::plain), FileUtils::read(fileName));
+
+    std::remove(fileName.c_str());
+}
+
+TEST(XorStreamTest, EmptyFile)
+{
+    auto inFileName = tempFileName("matasano_xor_stream_empty_in.bin");
+    auto outFileName = tempFileName("matasano_xor_stream_empty_out.bin");
+    writeFile(inFileName, ByteData());
+    ByteData key("key", ByteData::Encoding::plain);
+
+    XorStream::xorFile(inFileName, outFileName, key);
+    XorStream::xorFileInPlace(inFileName, key);
+    ASSERT_EQ("", FileUtils::read(outFileName));
+
+    std::remove(inFileName.c_str());
+    std::remove(outFileName.c_str());
+}
+
+TEST(XorStreamTest, NoFile)
+{
+    ByteData key("key", ByteData::Encoding::plain);
+    ASSERT_THROW(XorStream::xorFile("blah.bin", tempFileName("matasano_blah.bin"), key), std::ios_base::failure);
+    ASSERT_THROW(XorStream::xorFileInPlace("blah.bin", key), std::ios_base::failure);
+}